@@ -38,24 +38,71 @@ pub fn main() anyerror!void {
         defer _ = gpa.deinit();
 
         const allocator = gpa.allocator();
+        try elementCounts(allocator);
         try simpleTemplate(allocator, &buffer, .Buffer, std.io.null_writer);
         try simpleTemplate(allocator, &buffer, .Alloc, std.io.null_writer);
         try simpleTemplate(allocator, &buffer, .Writer, file_writer);
         try partialTemplates(allocator, &buffer, .Buffer, std.io.null_writer);
         try partialTemplates(allocator, &buffer, .Alloc, std.io.null_writer);
+        try jsonRecords(allocator);
         try parseTemplates(allocator);
     } else {
         const allocator = std.heap.c_allocator;
 
+        try elementCounts(allocator);
         try simpleTemplate(allocator, &buffer, .Buffer, std.io.null_writer);
         try simpleTemplate(allocator, &buffer, .Alloc, std.io.null_writer);
         try simpleTemplate(allocator, &buffer, .Writer, file_writer);
         try partialTemplates(allocator, &buffer, .Buffer, std.io.null_writer);
         try partialTemplates(allocator, &buffer, .Alloc, std.io.null_writer);
+        try jsonRecords(allocator);
         try parseTemplates(allocator);
     }
 }
 
+pub fn elementCounts(allocator: Allocator) !void {
+    const commented_template_text =
+        \\{{! Layout used by the blog pages }}
+        \\<html>
+        \\    {{! Metadata }}
+        \\    <head>
+        \\        <title>{{title}}</title>
+        \\    </head>
+        \\{{=<% %>=}}
+        \\    <body>
+        \\        <%! One article per post %>
+        \\        <%#posts%>
+        \\            <article><%title%></article>
+        \\        <%/posts%>
+        \\        <%! Footer %>
+        \\    </body>
+        \\</html>
+    ;
+
+    std.debug.print("Elements per template\n", .{});
+    std.debug.print("----------------------------------\n", .{});
+
+    inline for (.{ "template1.html", "template2.html", "template3.html" }) |file_name| {
+        try printElementCount(allocator, file_name, @embedFile("../data/" ++ file_name));
+    }
+
+    try printElementCount(allocator, "commented", commented_template_text);
+    std.debug.print("\n\n", .{});
+}
+
+fn printElementCount(allocator: Allocator, caption: []const u8, template_text: []const u8) !void {
+
+    // Cached templates borrowing strings can only merge contiguous static texts,
+    // owned strings merge every run of static texts left apart by comments and delimiters
+    var borrowed = (try mustache.parseText(allocator, template_text, .{}, .{ .copy_strings = false, .features = features })).success;
+    defer borrowed.deinit(allocator);
+
+    var owned = (try mustache.parseText(allocator, template_text, .{}, .{ .copy_strings = true, .features = features })).success;
+    defer owned.deinit(allocator);
+
+    std.debug.print("{s}: {} elements borrowing strings, {} elements owning strings\n", .{ caption, borrowed.elements.len, owned.elements.len });
+}
+
 pub fn simpleTemplate(allocator: Allocator, buffer: []u8, comptime mode: Mode, writer: anytype) !void {
     const template_text = "<title>{{title}}</title><h1>{{ title }}</h1><div>{{{body}}}</div>";
     const fmt_template = "<title>{[title]s}</title><h1>{[title]s}</h1><div>{[body]s}</div>";
@@ -266,6 +313,101 @@ pub fn partialTemplates(allocator: Allocator, buffer: []u8, comptime mode: Mode,
     std.debug.print("\n\n", .{});
 }
 
+pub fn jsonRecords(allocator: Allocator) !void {
+    const template_text =
+        \\<table>
+        \\{{#records}}
+        \\    <tr><td>{{id}}</td><td>{{name}}</td><td>{{email}}</td>{{#active}}<td>active</td>{{/active}}<td>{{score}}</td></tr>
+        \\{{/records}}
+        \\</table>
+    ;
+
+    const Record = struct { id: u32, name: []const u8, email: []const u8, active: bool, score: i64 };
+    const records_len = 1_000;
+
+    var records = try allocator.alloc(Record, records_len);
+    defer allocator.free(records);
+
+    for (records) |*record, index| {
+        record.* = .{
+            .id = @intCast(u32, index),
+            .name = "John Doe",
+            .email = "john.doe@example.com",
+            .active = index % 2 == 0,
+            .score = @intCast(i64, index) * 7,
+        };
+    }
+
+    const data = .{ .records = records };
+
+    var json_text = try std.json.stringifyAlloc(allocator, data, .{});
+    defer allocator.free(json_text);
+
+    var parser = std.json.Parser.init(allocator, false);
+    defer parser.deinit();
+
+    var json_data = try parser.parse(json_text);
+    defer json_data.deinit();
+
+    var document = try mustache.JsonDocument.fromValue(allocator, json_data.root);
+    defer document.deinit();
+
+    var template = (try mustache.parseText(allocator, template_text, .{}, .{ .copy_strings = false, .features = features })).success;
+    defer template.deinit(allocator);
+
+    // Each render walks all the records
+    const times = TIMES / records_len;
+    var no_buffer = [0]u8{};
+
+    std.debug.print("Same-shape JSON records\n", .{});
+    std.debug.print("----------------------------------\n", .{});
+
+    const reference = try repeatTimes("Mustache pre-parsed", times, preParsed, .{
+        allocator,
+        &no_buffer,
+        Mode.Alloc,
+        template,
+        data,
+        std.io.null_writer,
+    }, null);
+
+    _ = try repeatTimes("Mustache pre-parsed - JSON", times, preParsed, .{
+        allocator,
+        &no_buffer,
+        Mode.Alloc,
+        template,
+        json_data,
+        std.io.null_writer,
+    }, reference);
+
+    // Same render, looking up every name by hash
+    _ = try repeatTimes("Mustache pre-parsed - JSON, no slot hints", times, preParsedWithoutSlotHints, .{
+        allocator,
+        template,
+        json_data,
+    }, reference);
+
+    _ = try repeatTimes("Mustache pre-parsed - JSON document", times, preParsed, .{
+        allocator,
+        &no_buffer,
+        Mode.Alloc,
+        template,
+        &document,
+        std.io.null_writer,
+    }, reference);
+
+    _ = try repeatTimes("Mustache pre-parsed - raw JSON", times, preParsed, .{
+        allocator,
+        &no_buffer,
+        Mode.Alloc,
+        template,
+        mustache.RawJson{ .text = json_text },
+        std.io.null_writer,
+    }, reference);
+
+    std.debug.print("\n\n", .{});
+}
+
 pub fn parseTemplates(allocator: Allocator) !void {
     std.debug.print("----------------------------------\n", .{});
     _ = try repeat("Parse", parse, .{allocator}, null);
@@ -273,20 +415,24 @@ pub fn parseTemplates(allocator: Allocator) !void {
 }
 
 fn repeat(comptime caption: []const u8, comptime func: anytype, args: anytype, reference: ?i128) !i128 {
+    return try repeatTimes(caption, TIMES, func, args, reference);
+}
+
+fn repeatTimes(comptime caption: []const u8, times: usize, comptime func: anytype, args: anytype, reference: ?i128) !i128 {
     var index: usize = 0;
     var total_bytes: usize = 0;
 
     const start = std.time.nanoTimestamp();
-    while (index < TIMES) : (index += 1) {
+    while (index < times) : (index += 1) {
         total_bytes += try @call(.{}, func, args);
     }
     const ellapsed = std.time.nanoTimestamp() - start;
 
-    printSummary(caption, ellapsed, total_bytes, reference);
+    printSummary(caption, times, ellapsed, total_bytes, reference);
     return ellapsed;
 }
 
-fn printSummary(caption: []const u8, ellapsed: i128, total_bytes: usize, reference: ?i128) void {
+fn printSummary(caption: []const u8, times: usize, ellapsed: i128, total_bytes: usize, reference: ?i128) void {
     std.debug.print("{s}\n", .{caption});
     std.debug.print("Total time {d:.3}s\n", .{@intToFloat(f64, ellapsed) / std.time.ns_per_s});
 
@@ -295,8 +441,8 @@ fn printSummary(caption: []const u8, ellapsed: i128, total_bytes: usize, referen
         std.debug.print("Comparation {d:.3}x {s}\n", .{ perf, (if (perf > 0) "slower" else "faster") });
     }
 
-    std.debug.print("{d:.0} ops/s\n", .{TIMES / (@intToFloat(f64, ellapsed) / std.time.ns_per_s)});
-    std.debug.print("{d:.0} ns/iter\n", .{@intToFloat(f64, ellapsed) / TIMES});
+    std.debug.print("{d:.0} ops/s\n", .{@intToFloat(f64, times) / (@intToFloat(f64, ellapsed) / std.time.ns_per_s)});
+    std.debug.print("{d:.0} ns/iter\n", .{@intToFloat(f64, ellapsed) / @intToFloat(f64, times)});
     std.debug.print("{d:.0} MB/s\n", .{(@intToFloat(f64, total_bytes) / 1024 / 1024) / (@intToFloat(f64, ellapsed) / std.time.ns_per_s)});
     std.debug.print("\n", .{});
 }
@@ -339,6 +485,12 @@ fn preParsed(allocator: Allocator, buffer: []u8, mode: Mode, template: mustache.
     }
 }
 
+fn preParsedWithoutSlotHints(allocator: Allocator, template: mustache.Template, data: anytype) !usize {
+    const ret = try mustache.allocRenderWithOptions(allocator, template, data, .{ .object_slot_hints = false });
+    defer allocator.free(ret);
+    return ret.len;
+}
+
 fn preParsedPartials(allocator: Allocator, buffer: []u8, mode: Mode, template: mustache.Template, partial_templates: anytype, data: anytype, writer: anytype) !usize {
     switch (mode) {
         .Buffer => {
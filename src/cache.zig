@@ -0,0 +1,761 @@
+const std = @import("std");
+const Allocator = std.mem.Allocator;
+const Wyhash = std.hash.Wyhash;
+
+const testing = std.testing;
+const assert = std.debug.assert;
+
+const mustache = @import("mustache.zig");
+const Features = mustache.options.Features;
+const RenderOptions = mustache.options.RenderOptions;
+const RenderFromTemplateOptions = mustache.options.RenderFromTemplateOptions;
+const Delimiters = mustache.Delimiters;
+const ParseError = mustache.ParseError;
+const Template = mustache.Template;
+const StreamError = mustache.StreamError;
+
+const map = @import("rendering/partials_map.zig");
+const FileSignature = @import("registry.zig").FileSignature;
+
+const FileError = std.fs.File.OpenError || std.fs.File.ReadError || std.fs.File.StatError;
+
+pub const CacheLimits = struct {
+    /// Maximum number of cached templates
+    max_entries: usize = 64,
+
+    /// Maximum number of bytes owned by cached templates, including their source text or path.
+    /// Templates larger than the whole budget are evicted as soon as they are not being rendered.
+    max_bytes: ?usize = null,
+};
+
+pub const CacheStats = struct {
+    hits: u64 = 0,
+    misses: u64 = 0,
+    evictions: u64 = 0,
+};
+
+/// How cached file templates are checked for changes
+pub const FileValidation = enum {
+    /// Stats the file on each access, reloading it when inode, size or mtime change
+    stat,
+
+    /// Never touches the filesystem for cached files.
+    /// Use `invalidateFile` when notified of a change, e.g. from inotify
+    manual,
+};
+
+/// Caches parsed templates, keyed by a hash of the template text and delimiters,
+/// or by the absolute path for template files.
+/// All templates are parsed with the same comptime `features`.
+/// Least recently used templates are evicted when the limits are exceeded,
+/// templates being rendered are never evicted.
+///
+/// Use one instance per thread, or a `TemplateRegistry` to share templates between threads.
+pub fn TemplateCache(comptime features: Features) type {
+    return struct {
+        const Self = @This();
+
+        pub const Error = Allocator.Error || ParseError;
+        pub const FileCacheError = Error || FileError;
+
+        /// Errors rendering a cached template, including the errors streaming readers and file ranges
+        pub const RenderError = Error || StreamError;
+        pub const FileRenderError = FileCacheError || StreamError;
+
+        const Kind = enum(u8) {
+            text,
+            file,
+        };
+
+        pub const Entry = struct {
+            kind: Kind,
+            hash: u64,
+
+            /// Owns the template text followed by the delimiters,
+            /// the template is parsed without copying strings from it.
+            /// For files, owns the absolute path
+            buffer: []const u8,
+            text_len: usize,
+            delimiters: Delimiters,
+
+            /// Version of the file when parsed
+            signature: ?FileSignature = null,
+
+            template: Template,
+
+            /// Bytes owned by this entry
+            footprint: usize,
+
+            /// Number of renders in progress using this template
+            pins: u32 = 0,
+
+            /// False until the entry is indexed, or forever in case of a hash collision
+            cached: bool = false,
+
+            /// Least recently used list
+            prev: ?*Entry = null,
+            next: ?*Entry = null,
+
+            fn matches(self: *const Entry, kind: Kind, key: []const u8, delimiters: Delimiters) bool {
+                return self.kind == kind and
+                    std.mem.eql(u8, self.buffer[0..self.text_len], key) and
+                    std.mem.eql(u8, self.delimiters.starting_delimiter, delimiters.starting_delimiter) and
+                    std.mem.eql(u8, self.delimiters.ending_delimiter, delimiters.ending_delimiter);
+            }
+        };
+
+        /// Resolves partials from the caller's template texts or paths through the cache
+        fn CachedPartials(comptime TPartials: type, comptime kind: Kind) type {
+            const TextPartials = map.PartialsMap(TPartials, partialsOptions(kind));
+
+            return struct {
+                pub const KV = struct {
+                    key: []const u8,
+                    value: Template,
+                };
+
+                state: *PartialsState,
+                partials: TextPartials,
+
+                pub fn get(self: @This(), key: []const u8) ?Template {
+                    // Each partial is pinned once per render, no matter how many times it's included
+                    if (self.state.pinned.get(key)) |entry| return entry.template;
+
+                    const value = self.partials.get(key) orelse return null;
+                    const acquired = switch (kind) {
+                        .text => self.state.cache.acquireText(value, .{}),
+                        .file => self.state.cache.acquireFile(value),
+                    };
+
+                    const entry = acquired catch |err| {
+                        if (self.state.last_error == null) self.state.last_error = err;
+                        return null;
+                    };
+
+                    self.state.pin(key, entry) catch |err| {
+                        self.state.cache.release(entry);
+                        if (self.state.last_error == null) self.state.last_error = err;
+                        return null;
+                    };
+
+                    return entry.template;
+                }
+            };
+        }
+
+        const PartialsState = struct {
+            cache: *Self,
+
+            /// Partials acquired during this render, by the partial's name.
+            /// Names are copied, since lambdas may include partials from short-lived templates
+            pinned: std.StringHashMapUnmanaged(*Entry) = .{},
+            last_error: ?FileCacheError = null,
+
+            fn pin(self: *PartialsState, key: []const u8, entry: *Entry) Allocator.Error!void {
+                const allocator = self.cache.allocator;
+
+                try self.pinned.ensureUnusedCapacity(allocator, 1);
+                const owned_key = try allocator.dupe(u8, key);
+                self.pinned.putAssumeCapacityNoClobber(owned_key, entry);
+            }
+
+            fn deinit(self: *PartialsState) void {
+                var iterator = self.pinned.iterator();
+                while (iterator.next()) |pinned| {
+                    self.cache.release(pinned.value_ptr.*);
+                    self.cache.allocator.free(pinned.key_ptr.*);
+                }
+
+                self.pinned.deinit(self.cache.allocator);
+            }
+        };
+
+        allocator: Allocator,
+        limits: CacheLimits,
+
+        index: std.AutoHashMapUnmanaged(u64, *Entry) = .{},
+
+        /// Most recently used
+        head: ?*Entry = null,
+
+        /// Least recently used
+        tail: ?*Entry = null,
+
+        count: usize = 0,
+
+        /// Bytes owned by all cached entries
+        bytes: usize = 0,
+
+        stats: CacheStats = .{},
+
+        file_validation: FileValidation = .stat,
+
+        pub fn init(allocator: Allocator, limits: CacheLimits) Self {
+            return .{
+                .allocator = allocator,
+                .limits = limits,
+            };
+        }
+
+        /// Frees all templates.
+        /// No render can be in progress when calling this function.
+        pub fn deinit(self: *Self) void {
+            var current = self.head;
+            while (current) |entry| {
+                current = entry.next;
+                assert(entry.pins == 0);
+                self.destroy(entry);
+            }
+
+            self.index.deinit(self.allocator);
+        }
+
+        /// Parses the `template_text`, or reuses a previously parsed template, and renders with the given `data` to a `writer`
+        pub fn renderText(self: *Self, template_text: []const u8, data: anytype, writer: anytype) !void {
+            try self.renderTextPartialsWithOptions(template_text, {}, data, writer, .{});
+        }
+
+        /// Parses the `template_text`, or reuses a previously parsed template, and renders with the given `data` to a `writer`
+        /// `partials` can be a tuple, an array, slice or a HashMap containing the partial's name as key and the template text as value
+        pub fn renderTextPartials(self: *Self, template_text: []const u8, partials: anytype, data: anytype, writer: anytype) !void {
+            try self.renderTextPartialsWithOptions(template_text, partials, data, writer, .{});
+        }
+
+        /// Parses the `template_text`, or reuses a previously parsed template, and renders with the given `data` to a `writer`
+        /// `partials` can be a tuple, an array, slice or a HashMap containing the partial's name as key and the template text as value
+        /// `options` defines the behavior of the render process
+        pub fn renderTextPartialsWithOptions(self: *Self, template_text: []const u8, partials: anytype, data: anytype, writer: anytype, comptime options: RenderFromTemplateOptions) !void {
+            const entry = try self.acquireText(template_text, .{});
+            defer self.release(entry);
+
+            var state = PartialsState{ .cache = self };
+            defer state.deinit();
+
+            const cached_partials = CachedPartials(@TypeOf(partials), .text){
+                .state = &state,
+                .partials = map.PartialsMap(@TypeOf(partials), partialsOptions(.text)).init(self.allocator, partials),
+            };
+
+            try mustache.renderPartialsWithOptions(entry.template, cached_partials, data, writer, options);
+            if (state.last_error) |err| return err;
+        }
+
+        /// Parses the `template_text`, or reuses a previously parsed template, and renders with the given `data`.
+        /// Returns an owned slice with the content, caller must free the memory
+        pub fn allocRenderText(self: *Self, allocator: Allocator, template_text: []const u8, data: anytype) RenderError![]const u8 {
+            return try self.allocRenderTextPartialsWithOptions(allocator, template_text, {}, data, .{});
+        }
+
+        /// Parses the `template_text`, or reuses a previously parsed template, and renders with the given `data`.
+        /// `partials` can be a tuple, an array, slice or a HashMap containing the partial's name as key and the template text as value
+        /// Returns an owned slice with the content, caller must free the memory
+        pub fn allocRenderTextPartials(self: *Self, allocator: Allocator, template_text: []const u8, partials: anytype, data: anytype) RenderError![]const u8 {
+            return try self.allocRenderTextPartialsWithOptions(allocator, template_text, partials, data, .{});
+        }
+
+        /// Parses the `template_text`, or reuses a previously parsed template, and renders with the given `data`.
+        /// `partials` can be a tuple, an array, slice or a HashMap containing the partial's name as key and the template text as value
+        /// `options` defines the behavior of the render process
+        /// Returns an owned slice with the content, caller must free the memory
+        pub fn allocRenderTextPartialsWithOptions(self: *Self, allocator: Allocator, template_text: []const u8, partials: anytype, data: anytype, comptime options: RenderFromTemplateOptions) RenderError![]const u8 {
+            const entry = try self.acquireText(template_text, .{});
+            defer self.release(entry);
+
+            var state = PartialsState{ .cache = self };
+            defer state.deinit();
+
+            const cached_partials = CachedPartials(@TypeOf(partials), .text){
+                .state = &state,
+                .partials = map.PartialsMap(@TypeOf(partials), partialsOptions(.text)).init(self.allocator, partials),
+            };
+
+            const result = try mustache.allocRenderPartialsWithOptions(allocator, entry.template, cached_partials, data, options);
+            errdefer allocator.free(result);
+
+            if (state.last_error) |err| return @errSetCast(RenderError, err);
+            return result;
+        }
+
+        /// Parses the file, or reuses a previously parsed template, and renders with the given `data` to a `writer`
+        pub fn renderFile(self: *Self, template_absolute_path: []const u8, data: anytype, writer: anytype) !void {
+            try self.renderFilePartialsWithOptions(template_absolute_path, {}, data, writer, .{});
+        }
+
+        /// Parses the file, or reuses a previously parsed template, and renders with the given `data` to a `writer`
+        /// `partials` can be a tuple, an array, slice or a HashMap containing the partial's name as key and the absolute path as value
+        pub fn renderFilePartials(self: *Self, template_absolute_path: []const u8, partials: anytype, data: anytype, writer: anytype) !void {
+            try self.renderFilePartialsWithOptions(template_absolute_path, partials, data, writer, .{});
+        }
+
+        /// Parses the file, or reuses a previously parsed template, and renders with the given `data` to a `writer`
+        /// `partials` can be a tuple, an array, slice or a HashMap containing the partial's name as key and the absolute path as value
+        /// `options` defines the behavior of the render process
+        pub fn renderFilePartialsWithOptions(self: *Self, template_absolute_path: []const u8, partials: anytype, data: anytype, writer: anytype, comptime options: RenderFromTemplateOptions) !void {
+            const entry = try self.acquireFile(template_absolute_path);
+            defer self.release(entry);
+
+            var state = PartialsState{ .cache = self };
+            defer state.deinit();
+
+            const cached_partials = CachedPartials(@TypeOf(partials), .file){
+                .state = &state,
+                .partials = map.PartialsMap(@TypeOf(partials), partialsOptions(.file)).init(self.allocator, partials),
+            };
+
+            try mustache.renderPartialsWithOptions(entry.template, cached_partials, data, writer, options);
+            if (state.last_error) |err| return err;
+        }
+
+        /// Parses the file, or reuses a previously parsed template, and renders with the given `data`.
+        /// Returns an owned slice with the content, caller must free the memory
+        pub fn allocRenderFile(self: *Self, allocator: Allocator, template_absolute_path: []const u8, data: anytype) FileRenderError![]const u8 {
+            return try self.allocRenderFilePartialsWithOptions(allocator, template_absolute_path, {}, data, .{});
+        }
+
+        /// Parses the file, or reuses a previously parsed template, and renders with the given `data`.
+        /// `partials` can be a tuple, an array, slice or a HashMap containing the partial's name as key and the absolute path as value
+        /// Returns an owned slice with the content, caller must free the memory
+        pub fn allocRenderFilePartials(self: *Self, allocator: Allocator, template_absolute_path: []const u8, partials: anytype, data: anytype) FileRenderError![]const u8 {
+            return try self.allocRenderFilePartialsWithOptions(allocator, template_absolute_path, partials, data, .{});
+        }
+
+        /// Parses the file, or reuses a previously parsed template, and renders with the given `data`.
+        /// `partials` can be a tuple, an array, slice or a HashMap containing the partial's name as key and the absolute path as value
+        /// `options` defines the behavior of the render process
+        /// Returns an owned slice with the content, caller must free the memory
+        pub fn allocRenderFilePartialsWithOptions(self: *Self, allocator: Allocator, template_absolute_path: []const u8, partials: anytype, data: anytype, comptime options: RenderFromTemplateOptions) FileRenderError![]const u8 {
+            const entry = try self.acquireFile(template_absolute_path);
+            defer self.release(entry);
+
+            var state = PartialsState{ .cache = self };
+            defer state.deinit();
+
+            const cached_partials = CachedPartials(@TypeOf(partials), .file){
+                .state = &state,
+                .partials = map.PartialsMap(@TypeOf(partials), partialsOptions(.file)).init(self.allocator, partials),
+            };
+
+            const result = try mustache.allocRenderPartialsWithOptions(allocator, entry.template, cached_partials, data, options);
+            errdefer allocator.free(result);
+
+            if (state.last_error) |err| return err;
+            return result;
+        }
+
+        /// Returns a cached template, parsing and caching it if needed.
+        /// The template can't be evicted until `release` is called.
+        pub fn acquireText(self: *Self, template_text: []const u8, delimiters: Delimiters) Error!*Entry {
+            const hash = hashKey(.text, template_text, delimiters);
+
+            if (self.index.get(hash)) |entry| {
+                if (entry.matches(.text, template_text, delimiters)) {
+                    self.moveToFront(entry);
+                    self.stats.hits += 1;
+                    entry.pins += 1;
+                    return entry;
+                }
+            }
+
+            self.stats.misses += 1;
+            var entry = try self.createText(hash, template_text, delimiters);
+            entry.pins += 1;
+            errdefer self.release(entry);
+
+            try self.insert(entry);
+            return entry;
+        }
+
+        /// Returns a cached template file, parsing and caching it if needed.
+        /// Unless `file_validation` is `.manual`, the file is reloaded if changed since cached.
+        /// The template can't be evicted until `release` is called.
+        pub fn acquireFile(self: *Self, template_absolute_path: []const u8) FileCacheError!*Entry {
+            const hash = hashKey(.file, template_absolute_path, .{});
+
+            if (self.index.get(hash)) |entry| {
+                if (entry.matches(.file, template_absolute_path, .{})) {
+                    const up_to_date = switch (self.file_validation) {
+                        .manual => true,
+                        .stat => up_to_date: {
+                            const signature = FileSignature.read(template_absolute_path) catch |err| {
+                                self.detach(entry);
+                                return err;
+                            };
+                            break :up_to_date signature.eql(entry.signature.?);
+                        },
+                    };
+
+                    if (up_to_date) {
+                        self.moveToFront(entry);
+                        self.stats.hits += 1;
+                        entry.pins += 1;
+                        return entry;
+                    }
+
+                    self.detach(entry);
+                }
+            }
+
+            self.stats.misses += 1;
+            var entry = try self.createFile(hash, template_absolute_path);
+            entry.pins += 1;
+            errdefer self.release(entry);
+
+            try self.insert(entry);
+            return entry;
+        }
+
+        /// Removes a file from the cache, forcing it to be reloaded on the next access.
+        /// Returns false if the file was not cached.
+        pub fn invalidateFile(self: *Self, template_absolute_path: []const u8) bool {
+            const hash = hashKey(.file, template_absolute_path, .{});
+            if (self.index.get(hash)) |entry| {
+                if (entry.matches(.file, template_absolute_path, .{})) {
+                    self.detach(entry);
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        fn insert(self: *Self, entry: *Entry) Allocator.Error!void {
+            const result = try self.index.getOrPut(self.allocator, entry.hash);
+            if (result.found_existing) {
+                // Hash collision, the previous entry remains cached
+                entry.cached = false;
+            } else {
+                result.value_ptr.* = entry;
+                entry.cached = true;
+                self.bytes += entry.footprint;
+                self.pushFront(entry);
+                self.evict();
+            }
+        }
+
+        /// Removes the entry from the cache, destroying it as soon as it's not being rendered
+        fn detach(self: *Self, entry: *Entry) void {
+            assert(entry.cached);
+
+            self.unlink(entry);
+            _ = self.index.remove(entry.hash);
+            self.bytes -= entry.footprint;
+            entry.cached = false;
+
+            if (entry.pins == 0) self.destroy(entry);
+        }
+
+        /// Allows the template to be evicted again
+        pub fn release(self: *Self, entry: *Entry) void {
+            assert(entry.pins > 0);
+            entry.pins -= 1;
+
+            if (entry.pins == 0) {
+                if (entry.cached) self.evict() else self.destroy(entry);
+            }
+        }
+
+        fn createText(self: *Self, hash: u64, template_text: []const u8, delimiters: Delimiters) Error!*Entry {
+            const buffer = try std.mem.concat(self.allocator, u8, &.{ template_text, delimiters.starting_delimiter, delimiters.ending_delimiter });
+            errdefer self.allocator.free(buffer);
+
+            const starting_end = template_text.len + delimiters.starting_delimiter.len;
+            const owned_delimiters = Delimiters{
+                .starting_delimiter = buffer[template_text.len..starting_end],
+                .ending_delimiter = buffer[starting_end..],
+            };
+
+            const template = switch (try mustache.parseText(self.allocator, buffer[0..template_text.len], owned_delimiters, .{ .copy_strings = false, .features = features })) {
+                .success => |template| template,
+                .parse_error => |detail| return detail.parse_error,
+            };
+            errdefer template.deinit(self.allocator);
+
+            var entry = try self.allocator.create(Entry);
+            entry.* = .{
+                .kind = .text,
+                .hash = hash,
+                .buffer = buffer,
+                .text_len = template_text.len,
+                .delimiters = owned_delimiters,
+                .template = template,
+                .footprint = @sizeOf(Entry) + buffer.len + template.memoryFootprint(),
+            };
+
+            return entry;
+        }
+
+        fn createFile(self: *Self, hash: u64, template_absolute_path: []const u8) FileCacheError!*Entry {
+            const path = try self.allocator.dupe(u8, template_absolute_path);
+            errdefer self.allocator.free(path);
+
+            // Reads the signature first, so a change during parsing is detected on the next access
+            const signature = try FileSignature.read(path);
+
+            const template = switch (try mustache.parseFile(self.allocator, path, .{}, .{ .features = features })) {
+                .success => |template| template,
+                .parse_error => |detail| return detail.parse_error,
+            };
+            errdefer template.deinit(self.allocator);
+
+            var entry = try self.allocator.create(Entry);
+            entry.* = .{
+                .kind = .file,
+                .hash = hash,
+                .buffer = path,
+                .text_len = path.len,
+                .delimiters = .{},
+                .signature = signature,
+                .template = template,
+                .footprint = @sizeOf(Entry) + path.len + template.memoryFootprint(),
+            };
+
+            return entry;
+        }
+
+        fn destroy(self: *Self, entry: *Entry) void {
+            entry.template.deinit(self.allocator);
+            self.allocator.free(entry.buffer);
+            self.allocator.destroy(entry);
+        }
+
+        /// Evicts the least recently used templates not being rendered, until the limits are satisfied
+        fn evict(self: *Self) void {
+            var current = self.tail;
+            while (current) |entry| {
+                if (self.withinLimits()) break;
+                current = entry.prev;
+
+                if (entry.pins == 0) {
+                    self.detach(entry);
+                    self.stats.evictions += 1;
+                }
+            }
+        }
+
+        fn withinLimits(self: *const Self) bool {
+            if (self.count > self.limits.max_entries) return false;
+            if (self.limits.max_bytes) |max_bytes| {
+                if (self.bytes > max_bytes) return false;
+            }
+
+            return true;
+        }
+
+        fn pushFront(self: *Self, entry: *Entry) void {
+            entry.prev = null;
+            entry.next = self.head;
+
+            if (self.head) |head| head.prev = entry else self.tail = entry;
+            self.head = entry;
+            self.count += 1;
+        }
+
+        fn unlink(self: *Self, entry: *Entry) void {
+            if (entry.prev) |prev| prev.next = entry.next else self.head = entry.next;
+            if (entry.next) |next| next.prev = entry.prev else self.tail = entry.prev;
+
+            entry.prev = null;
+            entry.next = null;
+            self.count -= 1;
+        }
+
+        fn moveToFront(self: *Self, entry: *Entry) void {
+            if (self.head == entry) return;
+            self.unlink(entry);
+            self.pushFront(entry);
+        }
+
+        fn partialsOptions(comptime kind: Kind) RenderOptions {
+            return switch (kind) {
+                .text => .{ .string = .{ .features = features } },
+                .file => .{ .file = .{ .features = features } },
+            };
+        }
+
+        fn hashKey(kind: Kind, key: []const u8, delimiters: Delimiters) u64 {
+            var hasher = Wyhash.init(0);
+            hasher.update(&[_]u8{@enumToInt(kind)});
+            hasher.update(key);
+            hasher.update(delimiters.starting_delimiter);
+            hasher.update(&[_]u8{0});
+            hasher.update(delimiters.ending_delimiter);
+            return hasher.final();
+        }
+    };
+}
+
+test {
+    _ = tests;
+}
+
+const tests = struct {
+    const Cache = TemplateCache(.{});
+
+    test "Reuse parsed templates" {
+        var cache = Cache.init(testing.allocator, .{});
+        defer cache.deinit();
+
+        var i: usize = 0;
+        while (i < 3) : (i += 1) {
+            const result = try cache.allocRenderText(testing.allocator, "Hello {{name}}", .{ .name = "world" });
+            defer testing.allocator.free(result);
+
+            try testing.expectEqualStrings("Hello world", result);
+        }
+
+        try testing.expectEqual(@as(usize, 1), cache.count);
+    }
+
+    test "Render to writer" {
+        var cache = Cache.init(testing.allocator, .{});
+        defer cache.deinit();
+
+        var list = std.ArrayList(u8).init(testing.allocator);
+        defer list.deinit();
+
+        try cache.renderText("{{a}}-", .{ .a = 1 }, list.writer());
+        try cache.renderText("{{a}}-", .{ .a = 2 }, list.writer());
+        try testing.expectEqualStrings("1-2-", list.items);
+        try testing.expectEqual(@as(usize, 1), cache.count);
+    }
+
+    test "LRU eviction" {
+        var cache = Cache.init(testing.allocator, .{ .max_entries = 2 });
+        defer cache.deinit();
+
+        const templates = [_][]const u8{ "one", "two", "one", "three" };
+        for (templates) |template_text| {
+            const result = try cache.allocRenderText(testing.allocator, template_text, .{});
+            testing.allocator.free(result);
+        }
+
+        // "two" was the least recently used
+        try testing.expectEqual(@as(usize, 2), cache.count);
+        try testing.expectEqualStrings("three", cache.head.?.template.elements[0].static_text);
+        try testing.expectEqualStrings("one", cache.tail.?.template.elements[0].static_text);
+    }
+
+    test "Byte budget" {
+        const template_text = "{{#items}}{{name}}{{/items}}";
+
+        const footprint = footprint: {
+            var single = Cache.init(testing.allocator, .{});
+            defer single.deinit();
+
+            const result = try single.allocRenderText(testing.allocator, template_text, .{ .items = false });
+            testing.allocator.free(result);
+            break :footprint single.bytes;
+        };
+
+        // Room for two templates of the same size
+        var cache = Cache.init(testing.allocator, .{ .max_bytes = footprint * 2 + footprint / 2 });
+        defer cache.deinit();
+
+        const templates = [_][]const u8{ "{{#items}}{{name}}{{/items}}", "{{#items}}{{nome}}{{/items}}", "{{#items}}{{name}}{{/items}}", "{{#items}}{{nime}}{{/items}}" };
+        for (templates) |text| {
+            const result = try cache.allocRenderText(testing.allocator, text, .{ .items = false });
+            testing.allocator.free(result);
+        }
+
+        try testing.expectEqual(@as(usize, 2), cache.count);
+        try testing.expect(cache.bytes <= footprint * 2);
+        try testing.expectEqual(@as(u64, 1), cache.stats.hits);
+        try testing.expectEqual(@as(u64, 3), cache.stats.misses);
+        try testing.expectEqual(@as(u64, 1), cache.stats.evictions);
+    }
+
+    test "Cached partials" {
+        var cache = Cache.init(testing.allocator, .{ .max_entries = 1 });
+        defer cache.deinit();
+
+        const partials = .{
+            .{ "item", "[{{.}}]" },
+        };
+
+        const result = try cache.allocRenderTextPartials(testing.allocator, "{{#items}}{{>item}}{{/items}}", partials, .{ .items = [_]u32{ 1, 2, 3 } });
+        defer testing.allocator.free(result);
+
+        // The main template was pinned while the partial was loaded
+        try testing.expectEqualStrings("[1][2][3]", result);
+        try testing.expectEqual(@as(usize, 1), cache.count);
+
+        // The partial was acquired once, not once per item
+        try testing.expectEqual(@as(u64, 0), cache.stats.hits);
+        try testing.expectEqual(@as(u64, 2), cache.stats.misses);
+    }
+
+    test "Cached files" {
+        var tmp = testing.tmpDir(.{});
+        defer tmp.cleanup();
+
+        const absolute_path = try writeTemplateFile(tmp.dir, "cached.mustache", "Hello {{name}}");
+        defer testing.allocator.free(absolute_path);
+
+        var cache = Cache.init(testing.allocator, .{});
+        defer cache.deinit();
+
+        {
+            const result = try cache.allocRenderFile(testing.allocator, absolute_path, .{ .name = "world" });
+            defer testing.allocator.free(result);
+            try testing.expectEqualStrings("Hello world", result);
+        }
+
+        const cached = cache.head.?;
+
+        {
+            const result = try cache.allocRenderFile(testing.allocator, absolute_path, .{ .name = "again" });
+            defer testing.allocator.free(result);
+            try testing.expectEqualStrings("Hello again", result);
+            try testing.expect(cached == cache.head.?);
+        }
+
+        // A different size invalidates the cached template
+        testing.allocator.free(try writeTemplateFile(tmp.dir, "cached.mustache", "Bye {{name}}!"));
+
+        {
+            const result = try cache.allocRenderFile(testing.allocator, absolute_path, .{ .name = "world" });
+            defer testing.allocator.free(result);
+            try testing.expectEqualStrings("Bye world!", result);
+            try testing.expectEqual(@as(usize, 1), cache.count);
+        }
+
+        try testing.expect(cache.invalidateFile(absolute_path));
+        try testing.expect(!cache.invalidateFile(absolute_path));
+        try testing.expectEqual(@as(usize, 0), cache.count);
+    }
+
+    test "Missing file" {
+        var tmp = testing.tmpDir(.{});
+        defer tmp.cleanup();
+
+        const absolute_path = try writeTemplateFile(tmp.dir, "missing.mustache", "{{name}}");
+        defer testing.allocator.free(absolute_path);
+
+        var cache = Cache.init(testing.allocator, .{});
+        defer cache.deinit();
+
+        const result = try cache.allocRenderFile(testing.allocator, absolute_path, .{ .name = "world" });
+        testing.allocator.free(result);
+
+        try tmp.dir.deleteFile("missing.mustache");
+        try testing.expectError(error.FileNotFound, cache.allocRenderFile(testing.allocator, absolute_path, .{ .name = "world" }));
+        try testing.expectEqual(@as(usize, 0), cache.count);
+    }
+
+    fn writeTemplateFile(dir: std.fs.Dir, file_name: []const u8, template_text: []const u8) ![]const u8 {
+        var file = try dir.createFile(file_name, .{ .truncate = true });
+        defer file.close();
+
+        try file.writeAll(template_text);
+
+        return try dir.realpathAlloc(testing.allocator, file_name);
+    }
+
+    test "Parse error" {
+        var cache = Cache.init(testing.allocator, .{});
+        defer cache.deinit();
+
+        try testing.expectError(error.UnexpectedEof, cache.allocRenderText(testing.allocator, "{{#hello}}", .{}));
+        try testing.expectEqual(@as(usize, 0), cache.count);
+    }
+};
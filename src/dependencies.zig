@@ -0,0 +1,508 @@
+const std = @import("std");
+const Allocator = std.mem.Allocator;
+const json = std.json;
+
+const testing = std.testing;
+
+const mustache = @import("mustache.zig");
+const Element = mustache.Element;
+const Template = mustache.Template;
+
+const BlockScope = @import("linking.zig").BlockScope;
+const map = @import("rendering/partials_map.zig");
+const raw_json = @import("rendering/raw_json.zig");
+
+/// The keys a template can read, at each level of the data.
+/// Mustache names resolve against every level of the context stack,
+/// so a name read inside a section is projected both in the section's value and in all the enclosing ones.
+/// Arrays are transparent, their items are projected with the same node.
+/// Returned by `Template.dependencies`, to fetch only the data a template needs before rendering.
+pub const Projection = struct {
+    const Self = @This();
+
+    pub const Error = Allocator.Error || error{InvalidJson};
+
+    /// How the template reads a value, a value can be read by several tags
+    pub const Usage = packed struct {
+        /// `{{name}}` or `{{{name}}}`
+        interpolation: bool = false,
+
+        /// `{{#name}}`, iterated when the value is a list
+        section: bool = false,
+
+        /// `{{^name}}`, only checked for truthiness
+        inverted_section: bool = false,
+    };
+
+    pub const Node = struct {
+        members: std.StringArrayHashMapUnmanaged(*Node) = .{},
+
+        /// Tags reading this value, none when it is only traversed by a dotted name
+        usage: Usage = .{},
+
+        /// Keeps the whole value, set when a recursive partial makes the depth unknown,
+        /// or when sections nest too deep to track each level
+        complete: bool = false,
+
+        /// Returns the node of a dotted `path`, relative to this one
+        pub fn find(self: *const Node, path: []const u8) ?*const Node {
+            var current = self;
+            var iterator = std.mem.split(u8, path, ".");
+            while (iterator.next()) |part| {
+                current = current.members.get(part) orelse return null;
+            }
+
+            return current;
+        }
+    };
+
+    arena: std.heap.ArenaAllocator,
+    root: *Node,
+
+    /// Derives the projection of the `template` and all the partials and parents it may include.
+    /// `partials` can be a tuple, an array, slice or a HashMap containing the partial's name as key and the `Template` as value.
+    /// The projection owns its keys, the templates can be freed afterwards.
+    pub fn init(allocator: Allocator, template: Template, partials: anytype) Allocator.Error!Self {
+        const PartialsMap = map.PartialsMap(@TypeOf(partials), .{ .template = .{} });
+
+        var arena = std.heap.ArenaAllocator.init(allocator);
+        errdefer arena.deinit();
+
+        const root = try arena.allocator().create(Node);
+        root.* = .{};
+
+        var analyzer = Analyzer(PartialsMap){
+            .allocator = arena.allocator(),
+            .partials_map = PartialsMap.init(partials),
+        };
+
+        var root_scope = [_]*Node{root};
+        try analyzer.walk(template.elements, &root_scope, null);
+
+        return Self{
+            .arena = arena,
+            .root = root,
+        };
+    }
+
+    pub fn deinit(self: *Self) void {
+        self.arena.deinit();
+    }
+
+    /// Copies from the JSON `text` only the values the template can read, skipping everything else without parsing it.
+    /// The output is compact, whitespace between values is removed.
+    pub fn filter(self: *const Self, text: []const u8, list: *std.ArrayList(u8)) Error!void {
+        const start = raw_json.skipWhitespace(text, 0);
+        if (start >= text.len) return error.InvalidJson;
+
+        _ = try filterValue(self.root, text, start, list);
+    }
+
+    /// Parses the JSON `text`, loading only the values the template can read.
+    /// Unused objects and arrays cost a scan for their closing bracket, no allocations.
+    pub fn parseJson(self: *const Self, allocator: Allocator, text: []const u8) !json.ValueTree {
+        var filtered = std.ArrayList(u8).init(allocator);
+        defer filtered.deinit();
+
+        try self.filter(text, &filtered);
+
+        var parser = json.Parser.init(allocator, true);
+        defer parser.deinit();
+
+        return try parser.parse(filtered.items);
+    }
+
+    /// Copies the value starting at `start`, returning the position following it
+    fn filterValue(node: *const Node, text: []const u8, start: usize, list: *std.ArrayList(u8)) Error!usize {
+        const end = raw_json.valueEnd(text, start) orelse return error.InvalidJson;
+
+        if (node.complete) {
+            try list.appendSlice(text[start..end]);
+            return end;
+        }
+
+        switch (text[start]) {
+            '{' => {
+                try list.append('{');
+
+                var pos = raw_json.skipWhitespace(text, start + 1);
+                var first = true;
+                while (pos < end and text[pos] != '}') {
+                    if (!first) {
+                        if (text[pos] != ',') return error.InvalidJson;
+                        pos = raw_json.skipWhitespace(text, pos + 1);
+                    }
+
+                    if (pos >= end or text[pos] != '"') return error.InvalidJson;
+                    const key_end = raw_json.stringEnd(text, pos) orelse return error.InvalidJson;
+                    const raw_key = text[pos..key_end];
+
+                    pos = raw_json.skipWhitespace(text, key_end);
+                    if (pos >= end or text[pos] != ':') return error.InvalidJson;
+                    pos = raw_json.skipWhitespace(text, pos + 1);
+                    if (pos >= end) return error.InvalidJson;
+
+                    if (findMember(node, raw_key[1 .. raw_key.len - 1])) |child| {
+                        if (list.items[list.items.len - 1] != '{') try list.append(',');
+                        try list.appendSlice(raw_key);
+                        try list.append(':');
+                        pos = try filterValue(child, text, pos, list);
+                    } else {
+                        pos = raw_json.valueEnd(text, pos) orelse return error.InvalidJson;
+                    }
+
+                    pos = raw_json.skipWhitespace(text, pos);
+                    first = false;
+                }
+
+                try list.append('}');
+            },
+            '[' => {
+                try list.append('[');
+
+                var pos = raw_json.skipWhitespace(text, start + 1);
+                var first = true;
+                while (pos < end and text[pos] != ']') {
+                    if (!first) {
+                        if (text[pos] != ',') return error.InvalidJson;
+                        pos = raw_json.skipWhitespace(text, pos + 1);
+                        try list.append(',');
+                    }
+
+                    if (pos >= end) return error.InvalidJson;
+                    pos = raw_json.skipWhitespace(text, try filterValue(node, text, pos, list));
+                    first = false;
+                }
+
+                try list.append(']');
+            },
+            else => try list.appendSlice(text[start..end]),
+        }
+
+        return end;
+    }
+
+    fn findMember(node: *const Node, raw_key: []const u8) ?*const Node {
+        if (std.mem.indexOfScalar(u8, raw_key, '\\') == null) return node.members.get(raw_key);
+
+        var iterator = node.members.iterator();
+        while (iterator.next()) |entry| {
+            if (raw_json.stringEql(raw_key, entry.key_ptr.*)) return entry.value_ptr.*;
+        }
+
+        return null;
+    }
+};
+
+fn Analyzer(comptime PartialsMap: type) type {
+    return struct {
+        const Self = @This();
+        const Node = Projection.Node;
+
+        /// Each nested section doubles the scope, since its value is projected under every node.
+        /// Past this length the items are kept whole instead, and the scope stops growing
+        const max_scope_len = 32;
+
+        allocator: Allocator,
+        partials_map: PartialsMap,
+
+        /// Partials and parents being walked, to stop at recursion
+        including: std.ArrayListUnmanaged(Including) = .{},
+
+        const Including = struct {
+            key: []const u8,
+            scope_len: usize,
+        };
+
+        /// `scope` holds the nodes that may be at any level of the context stack
+        fn walk(
+            self: *Self,
+            elements: []const Element,
+            scope: []const *Node,
+            block_scope: ?*const BlockScope,
+        ) Allocator.Error!void {
+            var index: usize = 0;
+            while (index < elements.len) {
+                const element = elements[index];
+                index += 1;
+
+                const children = elements[index .. index + element.childrenCount()];
+                index += children.len;
+
+                switch (element) {
+                    .static_text => {},
+                    .interpolation, .unescaped_interpolation => |path| {
+                        if (path.len == 0) continue;
+                        for (scope) |node| (try self.project(node, path)).usage.interpolation = true;
+                    },
+                    .section => |section| {
+                        if (section.path.len == 0) {
+                            try self.walk(children, scope, block_scope);
+                            continue;
+                        }
+
+                        if (scope.len * 2 > max_scope_len) {
+                            // Names read inside the items can't be projected deeper, the items are kept whole.
+                            // The names may still resolve against the enclosing levels
+                            for (scope) |node| {
+                                const value = try self.project(node, section.path);
+                                value.usage.section = true;
+                                value.complete = true;
+                            }
+
+                            try self.walk(children, scope, block_scope);
+                            continue;
+                        }
+
+                        // Items are pushed over the current stack
+                        var section_scope = try std.ArrayListUnmanaged(*Node).initCapacity(self.allocator, scope.len * 2);
+                        section_scope.appendSliceAssumeCapacity(scope);
+                        for (scope) |node| {
+                            const value = try self.project(node, section.path);
+                            value.usage.section = true;
+                            section_scope.appendAssumeCapacity(value);
+                        }
+
+                        try self.walk(children[0..section.children_count], section_scope.items, block_scope);
+                        try self.walk(children[section.children_count..], scope, block_scope);
+                    },
+                    .inverted_section => |section| {
+                        if (section.path.len > 0) {
+                            for (scope) |node| (try self.project(node, section.path)).usage.inverted_section = true;
+                        }
+                        try self.walk(children, scope, block_scope);
+                    },
+                    .partial => |partial| {
+                        if (comptime PartialsMap.isEmpty()) continue;
+
+                        if (self.partials_map.get(partial.key)) |partial_template| {
+                            try self.include(partial.key, partial_template.elements, scope, block_scope);
+                        }
+                    },
+                    .parent => |parent| {
+                        if (comptime PartialsMap.isEmpty()) continue;
+
+                        if (self.partials_map.get(parent.key)) |parent_template| {
+                            const parent_scope = BlockScope{
+                                .parent = block_scope,
+                                .elements = children,
+                            };
+
+                            try self.include(parent.key, parent_template.elements, scope, &parent_scope);
+                        }
+                    },
+                    .block => |block| {
+                        // Both the default content and the override may render
+                        try self.walk(children, scope, block_scope);
+
+                        if (block_scope) |current| {
+                            if (current.find(block.key)) |content| try self.walk(content, scope, block_scope);
+                        }
+                    },
+                }
+            }
+        }
+
+        fn include(
+            self: *Self,
+            key: []const u8,
+            elements: []const Element,
+            scope: []const *Node,
+            block_scope: ?*const BlockScope,
+        ) Allocator.Error!void {
+            for (self.including.items) |including| {
+                if (std.mem.eql(u8, including.key, key)) {
+                    // The nodes entered since the first inclusion can nest at any depth,
+                    // the ones before it already hold every name the partial reads
+                    for (scope[including.scope_len..]) |node| node.complete = true;
+                    return;
+                }
+            }
+
+            try self.including.append(self.allocator, .{ .key = key, .scope_len = scope.len });
+            defer _ = self.including.pop();
+
+            try self.walk(elements, scope, block_scope);
+        }
+
+        /// Adds the path under `node`, returning the node of its last part
+        fn project(self: *Self, node: *Node, path: Element.Path) Allocator.Error!*Node {
+            var current = node;
+            for (path) |part| {
+                const result = try current.members.getOrPut(self.allocator, part.name);
+                if (!result.found_existing) {
+                    result.key_ptr.* = try self.allocator.dupe(u8, part.name);
+                    result.value_ptr.* = try self.allocator.create(Node);
+                    result.value_ptr.*.* = .{};
+                }
+
+                current = result.value_ptr.*;
+            }
+
+            return current;
+        }
+    };
+}
+
+test {
+    _ = tests;
+}
+
+const tests = struct {
+    fn expectFilter(template_text: []const u8, partials: anytype, json_text: []const u8, expected: []const u8) !void {
+        const allocator = testing.allocator;
+
+        var template = (try mustache.parseText(allocator, template_text, .{}, .{ .copy_strings = false })).success;
+        defer template.deinit(allocator);
+
+        var projection = try Projection.init(allocator, template, partials);
+        defer projection.deinit();
+
+        var filtered = std.ArrayList(u8).init(allocator);
+        defer filtered.deinit();
+
+        try projection.filter(json_text, &filtered);
+        try testing.expectEqualStrings(expected, filtered.items);
+    }
+
+    test "Filter" {
+        try expectFilter(
+            "{{title}} {{#items}}{{name}} {{title}}{{/items}}{{^empty}}-{{/empty}}",
+            {},
+            \\{
+            \\  "title": "Report",
+            \\  "unused": {"a": [1, 2, {"b": "}"}]},
+            \\  "items": [{"name": "a", "price": 1}, {"name": "b", "title": "c", "tags": ["x"]}],
+            \\  "empty": []
+            \\}
+        ,
+            \\{"title":"Report","items":[{"name":"a"},{"name":"b","title":"c"}],"empty":[]}
+        );
+    }
+
+    test "Dotted names" {
+        try expectFilter(
+            "{{#person}}{{address.city}}{{/person}}",
+            {},
+            \\{"person": {"name": "a", "address": {"city": "b", "zip": 1}}, "address": {"city": "c", "street": "d"}}
+        ,
+            \\{"person":{"address":{"city":"b"}},"address":{"city":"c"}}
+        );
+    }
+
+    test "Partials" {
+        const allocator = testing.allocator;
+
+        var footer = (try mustache.parseText(allocator, "{{site.name}}", .{}, .{ .copy_strings = false })).success;
+        defer footer.deinit(allocator);
+
+        // Recursive partial keeps everything under the nodes it can reach
+        var node = (try mustache.parseText(allocator, "{{name}}{{#children}}{{>node}}{{/children}}", .{}, .{ .copy_strings = false })).success;
+        defer node.deinit(allocator);
+
+        try expectFilter(
+            "{{>footer}}{{#tree}}{{>node}}{{/tree}}",
+            .{ .{ "footer", footer }, .{ "node", node } },
+            \\{"site": {"name": "a", "url": "b"}, "tree": {"name": "c", "children": [{"name": "d", "extra": 1}]}, "other": 2}
+        ,
+            \\{"site":{"name":"a"},"tree":{"name":"c","children":[{"name": "d", "extra": 1}]}}
+        );
+    }
+
+    test "Parse" {
+        const allocator = testing.allocator;
+
+        var template = (try mustache.parseText(allocator, "{{#items}}<{{name}}>{{/items}}", .{}, .{ .copy_strings = false })).success;
+        defer template.deinit(allocator);
+
+        var projection = try Projection.init(allocator, template, {});
+        defer projection.deinit();
+
+        var tree = try projection.parseJson(allocator,
+            \\{"items": [{"name": "a\"b", "big": [1, 2, 3]}], "blob": "A"}
+        );
+        defer tree.deinit();
+
+        try testing.expect(tree.root.Object.get("blob") == null);
+
+        const result = try mustache.allocRender(allocator, template, tree);
+        defer allocator.free(result);
+
+        try testing.expectEqualStrings("<a&quot;b>", result);
+    }
+
+    test "Dependencies" {
+        const allocator = testing.allocator;
+
+        var layout = (try mustache.parseText(allocator, "{{$body}}{{/body}}|{{{site.name}}}", .{}, .{ .copy_strings = false })).success;
+        defer layout.deinit(allocator);
+
+        var template = (try mustache.parseText(allocator,
+            \\{{<layout}}{{$body}}{{#orders}}{{id}}{{^paid}}!{{/paid}}{{/orders}}{{/body}}{{/layout}}
+        , .{}, .{ .copy_strings = false })).success;
+        defer template.deinit(allocator);
+
+        var dependencies = try template.dependencies(allocator, .{.{ "layout", layout }});
+        defer dependencies.deinit();
+
+        const root = dependencies.root;
+
+        const orders = root.find("orders").?;
+        try testing.expectEqual(Projection.Usage{ .section = true }, orders.usage);
+        try testing.expectEqual(Projection.Usage{ .interpolation = true }, orders.find("id").?.usage);
+        try testing.expectEqual(Projection.Usage{ .inverted_section = true }, orders.find("paid").?.usage);
+
+        // Names inside a section can also resolve from the enclosing levels
+        try testing.expect(root.find("id") != null);
+
+        try testing.expectEqual(Projection.Usage{}, root.find("site").?.usage);
+        try testing.expectEqual(Projection.Usage{ .interpolation = true }, root.find("site.name").?.usage);
+        try testing.expect(root.find("site.url") == null);
+        try testing.expect(!root.complete);
+    }
+
+    test "Deep sections" {
+        const allocator = testing.allocator;
+
+        var text = std.ArrayList(u8).init(allocator);
+        defer text.deinit();
+
+        const depth = 64;
+        var level: usize = 0;
+        while (level < depth) : (level += 1) try text.writer().print("{{{{#s{d}}}}}", .{level});
+        try text.appendSlice("{{name}}");
+        while (level > 0) {
+            level -= 1;
+            try text.writer().print("{{{{/s{d}}}}}", .{level});
+        }
+
+        var template = (try mustache.parseText(allocator, text.items, .{}, .{ .copy_strings = false })).success;
+        defer template.deinit(allocator);
+
+        // Without a limit, the names would be projected under 2^64 nodes
+        var dependencies = try template.dependencies(allocator, {});
+        defer dependencies.deinit();
+
+        const root = dependencies.root;
+        try testing.expect(!root.find("s0.s1.s2.s3.s4").?.complete);
+        try testing.expect(root.find("s0.s1.s2.s3.s4.s5").?.complete);
+        try testing.expect(root.find("s5").?.complete);
+        try testing.expectEqual(Projection.Usage{ .interpolation = true }, root.find("name").?.usage);
+    }
+
+    test "Invalid JSON" {
+        const allocator = testing.allocator;
+
+        var template = (try mustache.parseText(allocator, "{{name}}", .{}, .{ .copy_strings = false })).success;
+        defer template.deinit(allocator);
+
+        var projection = try Projection.init(allocator, template, {});
+        defer projection.deinit();
+
+        var filtered = std.ArrayList(u8).init(allocator);
+        defer filtered.deinit();
+
+        try testing.expectError(error.InvalidJson, projection.filter("{\"name\": \"a\"", &filtered));
+        try testing.expectError(error.InvalidJson, projection.filter("{\"name\" \"a\"}", &filtered));
+    }
+};
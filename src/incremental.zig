@@ -0,0 +1,436 @@
+const std = @import("std");
+const Allocator = std.mem.Allocator;
+
+const testing = std.testing;
+const assert = std.debug.assert;
+
+const mustache = @import("mustache.zig");
+const TemplateOptions = mustache.options.TemplateOptions;
+const IncrementalTemplateOptions = mustache.options.IncrementalTemplateOptions;
+const Delimiters = mustache.Delimiters;
+const Element = mustache.Element;
+const ParseErrorDetail = mustache.ParseErrorDetail;
+const Template = mustache.Template;
+
+const parsing = @import("parsing/parsing.zig");
+const PartType = parsing.PartType;
+
+/// Replaces the bytes `start..end` of the source with `text`
+pub const TextEdit = struct {
+    start: usize,
+    end: usize,
+    text: []const u8,
+};
+
+/// A template parsed as a sequence of independent top-level segments.
+///
+/// Segments are cut only at line starts outside of any tag or section,
+/// where parsing the pieces separately produces the same elements as parsing the whole text.
+/// An edit reparses only the segments it touches, widened until the scanner finds such a boundary again;
+/// all other segments keep their elements and strings.
+pub fn IncrementalTemplate(comptime options: IncrementalTemplateOptions) type {
+    return struct {
+        const Self = @This();
+
+        const template_options = TemplateOptions{
+            .source = .{ .string = .{ .copy_strings = true } },
+            .output = .cache,
+            .features = options.features,
+        };
+
+        const Segment = struct {
+            /// Byte offset in the source
+            start: usize,
+
+            /// Index of the first element in the template
+            first_element: usize,
+        };
+
+        pub const Result = union(enum) {
+            parse_error: ParseErrorDetail,
+            success: Self,
+        };
+
+        allocator: Allocator,
+        delimiters: Delimiters,
+        source: []const u8,
+        segments: []Segment,
+        elements: []Element,
+
+        pub fn parse(allocator: Allocator, template_text: []const u8, delimiters: Delimiters) Allocator.Error!Result {
+            var parsed = ParsedSegments.init(allocator);
+            defer parsed.deinit();
+
+            if (try parsed.parseAll(template_text, delimiters)) |detail| {
+                return Result{ .parse_error = detail };
+            }
+
+            const source = try allocator.dupe(u8, template_text);
+            errdefer allocator.free(source);
+
+            var segments = try allocator.alloc(Segment, parsed.list.items.len);
+            errdefer allocator.free(segments);
+
+            var elements = try allocator.alloc(Element, parsed.countElements());
+            parsed.moveTo(segments, elements, 0);
+
+            return Result{
+                .success = .{
+                    .allocator = allocator,
+                    .delimiters = delimiters,
+                    .source = source,
+                    .segments = segments,
+                    .elements = elements,
+                },
+            };
+        }
+
+        pub fn deinit(self: *Self) void {
+            Element.deinitMany(self.allocator, true, self.elements);
+            self.allocator.free(self.elements);
+            self.allocator.free(self.segments);
+            self.allocator.free(self.source);
+        }
+
+        /// The current template, valid until the next `edit` or `deinit`
+        pub fn template(self: *const Self) Template {
+            return Template{
+                .elements = self.elements,
+                .options = &template_options,
+            };
+        }
+
+        /// Applies the edit to the source and reparses only the affected segments.
+        /// Returns the parse error, if any, leaving the template unchanged.
+        pub fn edit(self: *Self, text_edit: TextEdit) Allocator.Error!?ParseErrorDetail {
+            assert(text_edit.start <= text_edit.end and text_edit.end <= self.source.len);
+
+            const source = try std.mem.concat(self.allocator, u8, &.{
+                self.source[0..text_edit.start],
+                text_edit.text,
+                self.source[text_edit.end..],
+            });
+            var committed = false;
+            defer if (!committed) self.allocator.free(source);
+
+            // First segment touched by the edit, and first segment starting strictly after it
+            var first: usize = 0;
+            while (first + 1 < self.segments.len and self.segments[first + 1].start <= text_edit.start) first += 1;
+            var next = std.math.min(first + 1, self.segments.len);
+            while (next < self.segments.len and self.segments[next].start <= text_edit.end) next += 1;
+
+            const delta = @intCast(isize, source.len) - @intCast(isize, self.source.len);
+            const region_start = if (self.segments.len == 0) 0 else self.segments[first].start;
+
+            var parsed = ParsedSegments.init(self.allocator);
+            defer parsed.deinit();
+
+            // Widens the region over the following segments until it ends on a clean boundary
+            var position = region_start;
+            while (true) {
+                const limit = if (next < self.segments.len) shift(self.segments[next].start, delta) else source.len;
+                const cut = nextCut(source[0..limit], position, self.delimiters, options.segment_size);
+
+                if (cut.index < limit) {
+                    if (try parsed.parseSegment(source, position, cut.index, self.delimiters)) |detail| return detail;
+                    position = cut.index;
+                } else if (cut.clean or limit == source.len) {
+                    if (try parsed.parseSegment(source, position, limit, self.delimiters)) |detail| return detail;
+                    break;
+                } else {
+                    next += 1;
+                }
+            }
+
+            const first_element = if (self.segments.len == 0) 0 else self.segments[first].first_element;
+            const end_element = if (next < self.segments.len) self.segments[next].first_element else self.elements.len;
+            const reused_segments = self.segments.len - next;
+
+            const new_element_count = parsed.countElements();
+            const new_segment_count = parsed.list.items.len;
+            const elements_len = first_element + new_element_count + (self.elements.len - end_element);
+            const segments_len = first + new_segment_count + reused_segments;
+
+            var elements = try self.allocator.alloc(Element, elements_len);
+            errdefer self.allocator.free(elements);
+
+            var segments = try self.allocator.alloc(Segment, segments_len);
+            errdefer self.allocator.free(segments);
+
+            // From here, nothing can fail
+            std.mem.copy(Element, elements, self.elements[0..first_element]);
+            std.mem.copy(Element, elements[first_element + new_element_count ..], self.elements[end_element..]);
+            std.mem.copy(Segment, segments, self.segments[0..first]);
+
+            parsed.moveTo(segments[first..], elements[first_element..], first_element);
+
+            const element_delta = @intCast(isize, new_element_count) - @intCast(isize, end_element - first_element);
+            for (self.segments[next..]) |segment, index| {
+                segments[first + new_segment_count + index] = .{
+                    .start = shift(segment.start, delta),
+                    .first_element = shift(segment.first_element, element_delta),
+                };
+            }
+
+            Element.deinitMany(self.allocator, true, self.elements[first_element..end_element]);
+            self.allocator.free(self.elements);
+            self.allocator.free(self.segments);
+            self.allocator.free(self.source);
+
+            self.elements = elements;
+            self.segments = segments;
+            self.source = source;
+            committed = true;
+
+            return null;
+        }
+
+        inline fn shift(value: usize, delta: isize) usize {
+            return @intCast(usize, @intCast(isize, value) + delta);
+        }
+
+        /// Templates parsed from consecutive segments, waiting to be spliced
+        const ParsedSegments = struct {
+            const Item = struct {
+                start: usize,
+                elements: []const Element,
+            };
+
+            allocator: Allocator,
+            list: std.ArrayListUnmanaged(Item) = .{},
+
+            fn init(allocator: Allocator) ParsedSegments {
+                return .{ .allocator = allocator };
+            }
+
+            fn deinit(self: *ParsedSegments) void {
+                for (self.list.items) |item| {
+                    Element.deinitMany(self.allocator, true, item.elements);
+                    self.allocator.free(item.elements);
+                }
+                self.list.deinit(self.allocator);
+            }
+
+            fn parseAll(self: *ParsedSegments, source: []const u8, delimiters: Delimiters) Allocator.Error!?ParseErrorDetail {
+                var position: usize = 0;
+                while (position < source.len) {
+                    const cut = nextCut(source, position, delimiters, options.segment_size);
+                    if (try self.parseSegment(source, position, cut.index, delimiters)) |detail| return detail;
+                    position = cut.index;
+                }
+
+                return null;
+            }
+
+            fn parseSegment(self: *ParsedSegments, source: []const u8, start: usize, end: usize, delimiters: Delimiters) Allocator.Error!?ParseErrorDetail {
+                if (start == end) return null;
+
+                const result = try mustache.parseText(self.allocator, source[start..end], delimiters, .{ .copy_strings = true, .features = options.features });
+                switch (result) {
+                    .success => |parsed| {
+                        errdefer parsed.deinit(self.allocator);
+                        try self.list.append(self.allocator, .{ .start = start, .elements = parsed.elements });
+                        return null;
+                    },
+                    .parse_error => |detail| {
+                        var adjusted = detail;
+                        if (adjusted.lin > 0) adjusted.lin += @intCast(u32, std.mem.count(u8, source[0..start], "\n"));
+                        return adjusted;
+                    },
+                }
+            }
+
+            fn countElements(self: *const ParsedSegments) usize {
+                var count: usize = 0;
+                for (self.list.items) |item| count += item.elements.len;
+                return count;
+            }
+
+            /// Moves all elements, leaving this list empty
+            fn moveTo(self: *ParsedSegments, segments: []Segment, elements: []Element, first_element: usize) void {
+                var element_index: usize = 0;
+                for (self.list.items) |item, index| {
+                    segments[index] = .{
+                        .start = item.start,
+                        .first_element = first_element + element_index,
+                    };
+
+                    std.mem.copy(Element, elements[element_index..], item.elements);
+                    element_index += item.elements.len;
+                    self.allocator.free(item.elements);
+                }
+
+                self.list.clearRetainingCapacity();
+            }
+        };
+    };
+}
+
+const Cut = struct {
+    index: usize,
+
+    /// False when the text ends inside a tag, a section, or after a delimiter change
+    clean: bool,
+};
+
+/// Finds the first line start after `start + min_size` that lies outside of any tag or section.
+/// Returns `text.len` if there is none.
+fn nextCut(text: []const u8, start: usize, delimiters: Delimiters, min_size: usize) Cut {
+    var depth: usize = 0;
+    var index = start;
+
+    while (index < text.len) {
+        if (text[index] == '\n') {
+            index += 1;
+            if (depth == 0 and index - start >= min_size and index < text.len) return Cut{ .index = index, .clean = true };
+            continue;
+        }
+
+        if (!std.mem.startsWith(u8, text[index..], delimiters.starting_delimiter)) {
+            index += 1;
+            continue;
+        }
+
+        const content = index + delimiters.starting_delimiter.len;
+        if (content >= text.len) return Cut{ .index = text.len, .clean = false };
+
+        switch (text[content]) {
+            @enumToInt(PartType.section),
+            @enumToInt(PartType.inverted_section),
+            @enumToInt(PartType.parent),
+            @enumToInt(PartType.block),
+            => depth += 1,
+            @enumToInt(PartType.close_section) => depth -|= 1,
+
+            // The remaining text depends on the new delimiters
+            @enumToInt(PartType.delimiters) => return Cut{ .index = text.len, .clean = false },
+            else => {},
+        }
+
+        const close = std.mem.indexOfPos(u8, text, content, delimiters.ending_delimiter) orelse return Cut{ .index = text.len, .clean = false };
+        index = close + delimiters.ending_delimiter.len;
+
+        if (text[content] == @enumToInt(PartType.triple_mustache) and index < text.len and text[index] == '}') index += 1;
+    }
+
+    return Cut{ .index = text.len, .clean = depth == 0 };
+}
+
+test {
+    _ = tests;
+}
+
+const tests = struct {
+    // Tiny segments, so each line becomes a segment
+    const Incremental = IncrementalTemplate(.{ .segment_size = 1 });
+
+    const Data = struct {
+        name: []const u8 = "mustache",
+        items: []const []const u8 = &.{ "a", "b" },
+        show: bool = true,
+    };
+
+    fn expectEquivalent(incremental: *const Incremental) !void {
+        const allocator = testing.allocator;
+
+        const expected = try mustache.allocRenderText(allocator, incremental.source, Data{});
+        defer allocator.free(expected);
+
+        const actual = try mustache.allocRender(allocator, incremental.template(), Data{});
+        defer allocator.free(actual);
+
+        try testing.expectEqualStrings(expected, actual);
+    }
+
+    fn parse(template_text: []const u8) !Incremental {
+        return switch (try Incremental.parse(testing.allocator, template_text, .{})) {
+            .success => |value| value,
+            .parse_error => error.TestUnexpectedResult,
+        };
+    }
+
+    test "Segments" {
+        const template_text =
+            \\Hello {{name}}
+            \\{{#items}}
+            \\  - {{.}}
+            \\{{/items}}
+            \\{{! multi-line
+            \\comment }}
+            \\Bye
+        ;
+
+        var incremental = try parse(template_text);
+        defer incremental.deinit();
+
+        // The section and the comment can't be split
+        try testing.expectEqual(@as(usize, 4), incremental.segments.len);
+        try expectEquivalent(&incremental);
+    }
+
+    test "Edit reuses untouched segments" {
+        var incremental = try parse("first {{name}}\nsecond\nthird {{name}}\n");
+        defer incremental.deinit();
+
+        const first_text = incremental.elements[0].static_text;
+        const last_path = incremental.elements[incremental.elements.len - 2].interpolation;
+
+        const start = std.mem.indexOf(u8, incremental.source, "second").?;
+        try testing.expect((try incremental.edit(.{ .start = start, .end = start + "second".len, .text = "{{#show}}2nd{{/show}}" })) == null);
+
+        try testing.expectEqualStrings("first {{name}}\n{{#show}}2nd{{/show}}\nthird {{name}}\n", incremental.source);
+        try testing.expect(first_text.ptr == incremental.elements[0].static_text.ptr);
+        try testing.expect(last_path.ptr == incremental.elements[incremental.elements.len - 2].interpolation.ptr);
+        try expectEquivalent(&incremental);
+    }
+
+    test "Edit widens to the enclosing section" {
+        var incremental = try parse("{{#items}}\n[{{.}}]\n{{/items}}\nend\n");
+        defer incremental.deinit();
+
+        const start = std.mem.indexOf(u8, incremental.source, "[").?;
+        try testing.expect((try incremental.edit(.{ .start = start, .end = start + 1, .text = "<" })) == null);
+        try expectEquivalent(&incremental);
+
+        try testing.expectEqualStrings("{{#items}}\n<{{.}}]\n{{/items}}\nend\n", incremental.source);
+    }
+
+    test "Edit absorbs following segments" {
+        var incremental = try parse("a\nb }}\nc\n");
+        defer incremental.deinit();
+
+        try testing.expectEqual(@as(usize, 3), incremental.segments.len);
+
+        // Opening a tag absorbs the following segments until it's closed
+        try testing.expect((try incremental.edit(.{ .start = 0, .end = 0, .text = "{{!" })) == null);
+        try testing.expectEqualStrings("{{!a\nb }}\nc\n", incremental.source);
+        try testing.expectEqual(@as(usize, 2), incremental.segments.len);
+        try expectEquivalent(&incremental);
+    }
+
+    test "Edit with parse error" {
+        var incremental = try parse("one\ntwo {{name}}\nthree\n");
+        defer incremental.deinit();
+
+        const start = std.mem.indexOf(u8, incremental.source, "two").?;
+        const detail = try incremental.edit(.{ .start = start, .end = start, .text = "{{/name}}" });
+        try testing.expect(detail != null);
+        try testing.expectEqual(mustache.ParseError.UnexpectedCloseSection, detail.?.parse_error);
+        try testing.expectEqual(@as(u32, 2), detail.?.lin);
+
+        // Unchanged
+        try testing.expectEqualStrings("one\ntwo {{name}}\nthree\n", incremental.source);
+        try expectEquivalent(&incremental);
+    }
+
+    test "Delimiters disable further segments" {
+        var incremental = try parse("{{name}}\n{{=<% %>=}}\n<%name%>\nend\n");
+        defer incremental.deinit();
+
+        try testing.expectEqual(@as(usize, 2), incremental.segments.len);
+
+        const start = std.mem.indexOf(u8, incremental.source, "end").?;
+        try testing.expect((try incremental.edit(.{ .start = start, .end = start + 3, .text = "<%#show%>yes<%/show%>" })) == null);
+        try expectEquivalent(&incremental);
+    }
+};
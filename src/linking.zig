@@ -0,0 +1,437 @@
+const std = @import("std");
+const Allocator = std.mem.Allocator;
+
+const testing = std.testing;
+const assert = std.debug.assert;
+
+const mustache = @import("mustache.zig");
+const TemplateOptions = mustache.options.TemplateOptions;
+const LinkOptions = mustache.options.LinkOptions;
+const Element = mustache.Element;
+const Template = mustache.Template;
+
+const map = @import("rendering/partials_map.zig");
+
+/// Block overrides passed by a `{{<parent}}` tag to the parent template.
+/// Scopes are chained from the innermost parent tag to the outermost one.
+pub const BlockScope = struct {
+    parent: ?*const BlockScope,
+
+    /// Children of the parent tag, only the block elements at the first level are considered overrides
+    elements: []const Element,
+
+    /// Returns the content overriding the block named `key`, or null if no scope overrides it.
+    /// The outermost override wins, so a child template always has the last word over its parents.
+    pub fn find(self: *const BlockScope, key: []const u8) ?[]const Element {
+        var found: ?[]const Element = null;
+
+        var scope: ?*const BlockScope = self;
+        while (scope) |current| : (scope = current.parent) {
+            if (findBlock(current.elements, key)) |content| found = content;
+        }
+
+        return found;
+    }
+
+    fn findBlock(elements: []const Element, key: []const u8) ?[]const Element {
+        var index: usize = 0;
+        while (index < elements.len) {
+            const element = elements[index];
+            index += 1;
+
+            const children = elements[index .. index + element.childrenCount()];
+            index += children.len;
+
+            switch (element) {
+                .block => |block| if (std.mem.eql(u8, block.key, key)) return children,
+                else => {},
+            }
+        }
+
+        return null;
+    }
+};
+
+/// Resolves the `{{<parent}}` tags of a template against its parent chain,
+/// producing a single flattened template where every `{{$block}}` is replaced by its override or default content.
+/// Rendering the linked template costs the same as rendering a hand-inlined one.
+/// parameters:
+/// `allocator` used to allocate the linked template, use this same allocator to deinit it.
+/// `template` the child template to be linked.
+/// `partials` can be a tuple, an array, slice or a HashMap containing the parent's name as key and the `Template` as value
+/// `options`: comptime options.
+/// The linked template borrows all strings from `template` and `partials`, which must outlive it.
+/// Parents not found in `partials`, parents tags with indentation, and parents nested deeper than `options.max_depth`
+/// are kept as tags, to be resolved at render time.
+/// So are parents with a section enclosing overridden blocks, since a lambda would receive the section's original text,
+/// which only renders as expected with the overrides in scope.
+pub fn link(
+    allocator: Allocator,
+    template: Template,
+    partials: anytype,
+    comptime options: LinkOptions,
+) Allocator.Error!Template {
+    const static = struct {
+        const template_options = TemplateOptions{
+            .source = .{ .string = .{ .copy_strings = false } },
+            .output = .cache,
+            .features = options.features,
+            .load_mode = .runtime_loaded,
+        };
+    };
+
+    const PartialsMap = map.PartialsMap(@TypeOf(partials), .{ .template = .{} });
+
+    var linker = Linker(PartialsMap, options){
+        .allocator = allocator,
+        .partials_map = PartialsMap.init(partials),
+    };
+    errdefer linker.deinit();
+
+    try linker.linkLevel(template.elements, null, 0);
+
+    return Template{
+        .elements = linker.list.toOwnedSlice(allocator),
+        .options = &static.template_options,
+    };
+}
+
+fn Linker(comptime PartialsMap: type, comptime options: LinkOptions) type {
+    return struct {
+        const Self = @This();
+
+        allocator: Allocator,
+        partials_map: PartialsMap,
+        list: std.ArrayListUnmanaged(Element) = .{},
+
+        /// Number of linked sections whose `inner_text` depends on the enclosing block overrides
+        stale_sections: usize = 0,
+
+        pub fn deinit(self: *Self) void {
+            Element.deinitMany(self.allocator, false, self.list.items);
+            self.list.deinit(self.allocator);
+        }
+
+        fn linkLevel(
+            self: *Self,
+            elements: []const Element,
+            scope: ?*const BlockScope,
+            depth: u32,
+        ) Allocator.Error!void {
+            var index: usize = 0;
+            while (index < elements.len) {
+                const element = elements[index];
+                index += 1;
+
+                const children = elements[index .. index + element.childrenCount()];
+                index += children.len;
+
+                switch (element) {
+                    .section => |section| {
+                        if (section.inner_text != null) {
+                            if (scope) |current| {
+                                if (readsOverrides(children, current)) self.stale_sections += 1;
+                            }
+                        }
+
+                        const position = try self.append(element);
+                        try self.linkLevel(children[0..section.children_count], scope, depth);
+
+                        const children_count = @intCast(u32, self.list.items.len - position - 1);
+                        try self.linkLevel(children[section.children_count..], scope, depth);
+
+                        self.list.items[position].section.children_count = children_count;
+                        self.list.items[position].section.else_count = @intCast(u32, self.list.items.len - position - 1) - children_count;
+                    },
+
+                    .inverted_section => {
+                        const position = try self.append(element);
+                        try self.linkLevel(children, scope, depth);
+                        self.closeLevel(position);
+                    },
+
+                    .block => |block| {
+                        const content = if (scope) |current| current.find(block.key) orelse children else children;
+                        try self.linkLevel(content, scope, depth);
+                    },
+
+                    .parent => |parent| {
+                        const parent_template = if (comptime PartialsMap.isEmpty())
+                            null
+                        else if (parent.indentation == null and depth < options.max_depth)
+                            self.partials_map.get(parent.key)
+                        else
+                            null;
+
+                        if (parent_template) |value| {
+                            const start = self.list.items.len;
+                            const stale_sections = self.stale_sections;
+
+                            try self.linkLevel(value.elements, &BlockScope{ .parent = scope, .elements = children }, depth + 1);
+                            if (self.stale_sections == stale_sections) continue;
+
+                            // A section's text would not match its linked content,
+                            // resolves this parent at render time instead
+                            self.truncate(start);
+                            self.stale_sections = stale_sections;
+                        }
+
+                        // Unresolved parents are kept as tags,
+                        // carrying the overrides from the enclosing scopes before their own,
+                        // since the outermost override wins.
+                        const position = try self.append(element);
+                        if (scope) |current| try self.copyOverrides(current);
+                        try self.copyLevel(children);
+                        self.closeLevel(position);
+                    },
+
+                    else => _ = try self.append(element),
+                }
+            }
+        }
+
+        /// Returns true if the elements include a block overridden by the scope, or a parent tag that could be
+        fn readsOverrides(elements: []const Element, scope: *const BlockScope) bool {
+            for (elements) |element| {
+                switch (element) {
+                    .block => |block| if (scope.find(block.key) != null) return true,
+                    .parent => return true,
+                    else => {},
+                }
+            }
+
+            return false;
+        }
+
+        /// Removes the elements appended from `position` on
+        fn truncate(self: *Self, position: usize) void {
+            Element.deinitMany(self.allocator, false, self.list.items[position..]);
+            self.list.shrinkRetainingCapacity(position);
+        }
+
+        fn copyOverrides(self: *Self, scope: *const BlockScope) Allocator.Error!void {
+            if (scope.parent) |parent| try self.copyOverrides(parent);
+
+            var index: usize = 0;
+            while (index < scope.elements.len) {
+                const element = scope.elements[index];
+                const children_count = element.childrenCount();
+
+                if (element == .block) {
+                    try self.copyLevel(scope.elements[index .. index + 1 + children_count]);
+                }
+
+                index += 1 + children_count;
+            }
+        }
+
+        fn copyLevel(self: *Self, elements: []const Element) Allocator.Error!void {
+            for (elements) |element| {
+                _ = try self.append(element);
+            }
+        }
+
+        /// Appends a shallow copy of the element, paths are always copied since the linked template frees them
+        fn append(self: *Self, element: Element) Allocator.Error!usize {
+            const position = self.list.items.len;
+            try self.list.ensureUnusedCapacity(self.allocator, 1);
+
+            self.list.appendAssumeCapacity(switch (element) {
+                .interpolation => |path| .{ .interpolation = try self.dupePath(path) },
+                .unescaped_interpolation => |path| .{ .unescaped_interpolation = try self.dupePath(path) },
+                .section => |section| .{
+                    .section = .{
+                        .path = try self.dupePath(section.path),
+                        .children_count = section.children_count,
+                        .inner_text = section.inner_text,
+                        .delimiters = section.delimiters,
+                        .else_count = section.else_count,
+                    },
+                },
+                .inverted_section => |section| .{
+                    .inverted_section = .{
+                        .path = try self.dupePath(section.path),
+                        .children_count = section.children_count,
+                    },
+                },
+                else => element,
+            });
+
+            return position;
+        }
+
+        /// Updates the children count of the element at `position` to include every element appended after it
+        fn closeLevel(self: *Self, position: usize) void {
+            const children_count = @intCast(u32, self.list.items.len - position - 1);
+            switch (self.list.items[position]) {
+                .inverted_section => |*section| section.children_count = children_count,
+                .parent => |*parent| parent.children_count = children_count,
+                else => unreachable,
+            }
+        }
+
+        fn dupePath(self: *Self, path: Element.Path) Allocator.Error!Element.Path {
+            return if (path.len == 0) path else try self.allocator.dupe(Element.PathPart, path);
+        }
+    };
+}
+
+test {
+    _ = tests;
+}
+
+const tests = struct {
+    fn expectParse(template_text: []const u8) !Template {
+        return switch (try mustache.parseText(testing.allocator, template_text, .{}, .{ .copy_strings = false })) {
+            .success => |template| template,
+            .parse_error => error.TestUnexpectedResult,
+        };
+    }
+
+    fn expectLink(
+        template_text: []const u8,
+        comptime partials_text: anytype,
+        data: anytype,
+        expected: []const u8,
+        expected_parents: usize,
+    ) !void {
+        const allocator = testing.allocator;
+
+        var template = try expectParse(template_text);
+        defer template.deinit(allocator);
+
+        var partials = std.StringHashMap(Template).init(allocator);
+        defer {
+            var iterator = partials.valueIterator();
+            while (iterator.next()) |partial| partial.deinit(allocator);
+            partials.deinit();
+        }
+
+        inline for (partials_text) |item| {
+            var partial = try expectParse(item[1]);
+            errdefer partial.deinit(allocator);
+
+            try partials.put(item[0], partial);
+        }
+
+        var linked = try link(allocator, template, partials, .{});
+        defer linked.deinit(allocator);
+
+        // Blocks can only be left inside unresolved parents
+        var parents: usize = 0;
+        var index: usize = 0;
+        while (index < linked.elements.len) : (index += 1) {
+            switch (linked.elements[index]) {
+                .parent => |parent| {
+                    parents += 1;
+                    index += parent.children_count;
+                },
+                .block => return error.TestUnexpectedResult,
+                else => {},
+            }
+        }
+
+        try testing.expectEqual(expected_parents, parents);
+
+        const result = try mustache.allocRenderPartials(allocator, linked, partials, data);
+        defer allocator.free(result);
+
+        try testing.expectEqualStrings(expected, result);
+    }
+
+    test "Overridden content" {
+        try expectLink(
+            "{{<super}}{{$title}}sub template title{{/title}}{{/super}}",
+            .{
+                .{ "super", "...{{$title}}Default title{{/title}}..." },
+            },
+            .{},
+            "...sub template title...",
+            0,
+        );
+    }
+
+    test "Sections around blocks" {
+        try expectLink(
+            "{{<layout}}{{$item}}<{{.}}>{{/item}}{{/layout}}",
+            .{
+                .{ "layout", "{{#items}}{{$item}}{{.}}{{/item}},{{/items}}{{^items}}empty{{/items}}" },
+            },
+            .{ .items = [_]u32{ 1, 2, 3 } },
+            "<1>,<2>,<3>,",
+            0,
+        );
+    }
+
+    test "Multi-level inheritance" {
+        try expectLink(
+            "{{<parent}}{{$a}}c{{/a}}{{/parent}}",
+            .{
+                .{ "parent", "{{<older}}{{$a}}p{{/a}}{{/older}}" },
+                .{ "older", "{{<grandParent}}{{$a}}o{{/a}}{{/grandParent}}" },
+                .{ "grandParent", "{{$a}}g{{/a}}" },
+            },
+            .{},
+            "c",
+            0,
+        );
+    }
+
+    test "Recursion" {
+        try expectLink(
+            "{{<parent}}{{$foo}}override{{/foo}}{{/parent}}",
+            .{
+                .{ "parent", "{{$foo}}default content{{/foo}} {{$bar}}{{<parent2}}{{/parent2}}{{/bar}}" },
+                .{ "parent2", "{{$foo}}parent2 default content{{/foo}} {{<parent}}{{$bar}}don't recurse{{/bar}}{{/parent}}" },
+            },
+            .{},
+            "override override override don't recurse",
+            0,
+        );
+    }
+
+    // Lambdas used for sections inside a parent should receive the raw section string,
+    // rendered with the overrides in scope
+    test "Lambda inside parent" {
+        const Data = struct {
+            pub fn lambda(ctx: mustache.LambdaContext) !void {
+                try ctx.write("(");
+                try ctx.render(testing.allocator, ctx.inner_text);
+                try ctx.write(")");
+            }
+        };
+
+        try expectLink(
+            "{{<layout}}{{$title}}child{{/title}}{{/layout}}",
+            .{
+                .{ "layout", "[{{#lambda}}{{$title}}default{{/title}}{{/lambda}}]" },
+            },
+            Data{},
+            "[(child)]",
+            1,
+        );
+
+        // Sections not enclosing overridden blocks are still linked
+        try expectLink(
+            "{{<layout}}{{$title}}child{{/title}}{{/layout}}",
+            .{
+                .{ "layout", "[{{#lambda}}{{$body}}default{{/body}}{{/lambda}}]{{$title}}{{/title}}" },
+            },
+            Data{},
+            "[(default)]child",
+            0,
+        );
+    }
+
+    test "Unresolved parent keeps the outer overrides" {
+        try expectLink(
+            "{{<layout}}{{$title}}child{{/title}}{{/layout}}",
+            .{
+                .{ "layout", "[{{<missing}}{{$title}}layout{{/title}}{{/missing}}]" },
+            },
+            .{},
+            "[]",
+            1,
+        );
+    }
+};
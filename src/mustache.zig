@@ -3,6 +3,11 @@ const Allocator = std.mem.Allocator;
 
 const template = @import("template.zig");
 const rendering = @import("rendering/rendering.zig");
+const registry = @import("registry.zig");
+const incremental = @import("incremental.zig");
+const cache = @import("cache.zig");
+const linking = @import("linking.zig");
+const dependencies = @import("dependencies.zig");
 
 pub const ParseError = template.ParseError;
 pub const ParseErrorDetail = template.ParseErrorDetail;
@@ -18,11 +23,39 @@ pub const parseText = template.parseText;
 pub const parseFile = template.parseFile;
 pub const parseComptime = template.parseComptime;
 
+pub const link = linking.link;
+
+pub const Projection = dependencies.Projection;
+
+pub const outputBound = rendering.outputBound;
+pub const SafeHtml = rendering.SafeHtml;
+pub const FileRange = rendering.FileRange;
+pub const StreamError = rendering.StreamError;
+pub const RawJson = rendering.RawJson;
+pub const MsgPack = rendering.MsgPack;
+pub const JsonDocument = rendering.JsonDocument;
+pub const EscapeCache = rendering.EscapeCache;
+pub const EscapeCacheStats = rendering.EscapeCacheStats;
+
+pub const IncrementalTemplate = incremental.IncrementalTemplate;
+pub const TextEdit = incremental.TextEdit;
+
 pub const render = rendering.render;
 pub const renderWithOptions = rendering.renderWithOptions;
 pub const renderPartials = rendering.renderPartials;
 pub const renderPartialsWithOptions = rendering.renderPartialsWithOptions;
 
+pub const renderJsonStream = rendering.renderJsonStream;
+pub const renderJsonStreamWithOptions = rendering.renderJsonStreamWithOptions;
+pub const renderJsonStreamPartials = rendering.renderJsonStreamPartials;
+pub const renderJsonStreamPartialsWithOptions = rendering.renderJsonStreamPartialsWithOptions;
+
+pub const CsvFormat = rendering.CsvFormat;
+pub const renderCsvStream = rendering.renderCsvStream;
+pub const renderCsvStreamWithOptions = rendering.renderCsvStreamWithOptions;
+pub const renderCsvStreamPartials = rendering.renderCsvStreamPartials;
+pub const renderCsvStreamPartialsWithOptions = rendering.renderCsvStreamPartialsWithOptions;
+
 pub const allocRender = rendering.allocRender;
 pub const allocRenderWithOptions = rendering.allocRenderWithOptions;
 pub const allocRenderPartials = rendering.allocRenderPartials;
@@ -75,7 +108,18 @@ pub const allocRenderFileZPartialsWithOptions = rendering.allocRenderFileZPartia
 
 pub const LambdaContext = rendering.LambdaContext;
 
+pub const TemplateRegistry = registry.TemplateRegistry;
+
+pub const TemplateCache = cache.TemplateCache;
+pub const CacheLimits = cache.CacheLimits;
+pub const FileValidation = cache.FileValidation;
+
 test {
     _ = template;
     _ = rendering;
+    _ = registry;
+    _ = incremental;
+    _ = cache;
+    _ = linking;
+    _ = dependencies;
 }
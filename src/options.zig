@@ -85,6 +85,26 @@ pub const ParseFileOptions = struct {
     features: Features = .{},
 };
 
+pub const IncrementalTemplateOptions = struct {
+    /// Minimum size of each independently parsed segment.
+    /// Smaller segments make edits cheaper, at the cost of more allocations when parsing the whole template.
+    segment_size: usize = 4 * 1024,
+
+    /// Those options affect both performance and supported Mustache features.
+    /// Defaults to full-spec compatible.
+    features: Features = .{},
+};
+
+pub const LinkOptions = struct {
+    /// Max nesting of parent templates expanded by the link step.
+    /// Deeper parents are kept as `{{<parent}}` tags and resolved at render time.
+    max_depth: u32 = 64,
+
+    /// Those options affect both performance and supported Mustache features.
+    /// Defaults to full-spec compatible.
+    features: Features = .{},
+};
+
 pub const Features = struct {
     /// Allows redefining the delimiters through the tags '{{=' and '=}}'
     /// Disabling this option speeds up the parsing process.
@@ -117,6 +137,14 @@ pub const Lambdas = union(enum) {
     },
 };
 
+pub const FloatFormat = union(enum) {
+    /// Shortest representation that reads back as the same value
+    shortest,
+
+    /// Fixed number of decimal places, rounded
+    decimals: u8,
+};
+
 pub const ContextMisses = enum {
     empty,
     fail,
@@ -127,6 +155,37 @@ pub const RenderFromTemplateOptions = struct {
     /// Mustache's spec says it must be rendered as an empty string
     /// However, in Debug mode it defaults to `Error` to avoid silently broken contexts.
     context_misses: ContextMisses = if (builtin.mode == .Debug) .fail else .empty,
+
+    /// Defines how floats are rendered
+    float_format: FloatFormat = .shortest,
+
+    /// Defines how `allocRender` reserves memory for the output
+    preallocation: Preallocation = .capacity_hint,
+
+    /// Remembers where each name was found in a `std.json` object,
+    /// checking the same position first in the next object
+    object_slot_hints: bool = true,
+};
+
+pub const Preallocation = enum {
+    /// Walks the template against the data before rendering, summing the size of each value
+    capacity_hint,
+
+    /// Allocates once, using the upper bound computed from the data type by `mustache.outputBound`.
+    /// Falls back to `capacity_hint` when the output can't be bounded.
+    output_bound,
+};
+
+pub const EscapeCacheLimits = struct {
+    /// Number of cached values
+    max_entries: usize = 256,
+
+    /// Shorter values are cheaper to escape than to look up
+    min_len: usize = 64,
+
+    /// Longer values are not cached.
+    /// Each entry holds a copy of the value and its escaped form, up to `max_len * 7` bytes
+    max_len: usize = 4 * 1024,
 };
 
 pub const RenderFromStringOptions = struct {
@@ -135,6 +194,9 @@ pub const RenderFromStringOptions = struct {
     /// However, in Debug mode it defaults to `Error` to avoid silently broken contexts.
     context_misses: ContextMisses = if (builtin.mode == .Debug) .fail else .empty,
 
+    /// Defines how floats are rendered
+    float_format: FloatFormat = .shortest,
+
     /// Those options affect both performance and supported Mustache features.
     /// Defaults to full-spec compatible.
     features: Features = .{},
@@ -146,6 +208,9 @@ pub const RenderFromFileOptions = struct {
     /// However, in Debug mode it defaults to `Error` to avoid silently broken contexts.
     context_misses: ContextMisses = if (builtin.mode == .Debug) .fail else .empty,
 
+    /// Defines how floats are rendered
+    float_format: FloatFormat = .shortest,
+
     /// Define the buffer size for reading the stream
     read_buffer_size: usize = 4 * 1024,
 
@@ -372,10 +372,170 @@ pub fn Parser(comptime options: TemplateOptions) type {
                 }
             }
 
+            var cursor = FuseCursor{};
+            defer if (options.output == .render) {
+                for (cursor.merged_texts.items) |content| self.gpa.free(content);
+                cursor.merged_texts.deinit(self.gpa);
+            };
+
+            self.fuseLevel(list.items, list.items.len, &cursor);
+            list.items.len = cursor.write;
+
             const elements = if (options.output == .render or options.load_mode == .comptime_loaded) list.items else list.toOwnedSlice(self.gpa);
             try render.render(elements);
         }
 
+        const FuseCursor = struct {
+            read: usize = 0,
+            write: usize = 0,
+
+            /// Texts merged when output = .render, freed once the elements are rendered
+            merged_texts: std.ArrayListUnmanaged([]const u8) = .{},
+        };
+
+        const MergedText = struct {
+            content: []const u8,
+
+            /// Number of static texts merged
+            count: usize,
+        };
+
+        /// Fuses adjacent elements at each level:
+        /// Consecutive static texts left by comments, delimiters and standalone trimming are merged into a single text,
+        /// and each section immediately followed by an inverted section with the same path,
+        /// as in `{{#items}}...{{/items}}{{^items}}...{{/items}}`, becomes a single section with an else branch,
+        /// so the path is resolved only once while rendering.
+        /// Elements are compacted in place, the cursor never writes past the element being read.
+        fn fuseLevel(self: *Self, elements: []Element, end: usize, cursor: *FuseCursor) void {
+            while (cursor.read < end) {
+                const element = elements[cursor.read];
+                cursor.read += 1;
+
+                if (element == .static_text) {
+                    var run_start = cursor.read - 1;
+                    var run_end = cursor.read;
+                    while (run_end < end and elements[run_end] == .static_text) run_end += 1;
+
+                    while (run_start < run_end) {
+                        const merged = self.mergeStaticTexts(elements[run_start..run_end], cursor);
+                        elements[cursor.write] = .{ .static_text = merged.content };
+                        cursor.write += 1;
+                        run_start += merged.count;
+                    }
+
+                    cursor.read = run_end;
+                    continue;
+                }
+
+                const position = cursor.write;
+                elements[position] = element;
+                cursor.write += 1;
+
+                switch (element) {
+                    .section => |section| {
+                        self.fuseLevel(elements, cursor.read + section.children_count, cursor);
+                        elements[position].section.children_count = @intCast(u32, cursor.write - position - 1);
+
+                        if (cursor.read < end) {
+                            switch (elements[cursor.read]) {
+                                .inverted_section => |inverted_section| {
+                                    if (pathEql(section.path, inverted_section.path)) {
+                                        cursor.read += 1;
+
+                                        const else_position = cursor.write;
+                                        self.fuseLevel(elements, cursor.read + inverted_section.children_count, cursor);
+                                        elements[position].section.else_count = @intCast(u32, cursor.write - else_position);
+
+                                        if (options.load_mode == .runtime_loaded) {
+                                            Element.destroyPath(self.gpa, copy_string, inverted_section.path);
+                                        }
+                                    }
+                                },
+                                else => {},
+                            }
+                        }
+                    },
+                    .inverted_section => |inverted_section| {
+                        self.fuseLevel(elements, cursor.read + inverted_section.children_count, cursor);
+                        elements[position].inverted_section.children_count = @intCast(u32, cursor.write - position - 1);
+                    },
+                    .parent => |parent| {
+                        self.fuseLevel(elements, cursor.read + parent.children_count, cursor);
+                        elements[position].parent.children_count = @intCast(u32, cursor.write - position - 1);
+                    },
+                    .block => |block| {
+                        self.fuseLevel(elements, cursor.read + block.children_count, cursor);
+                        elements[position].block.children_count = @intCast(u32, cursor.write - position - 1);
+                    },
+                    else => {},
+                }
+            }
+        }
+
+        /// Merges a run of consecutive static texts, building the merged text once.
+        /// Owned strings are copied into a single allocation, comptime strings are concatenated,
+        /// and borrowed strings are sliced when contiguous in the source.
+        /// Otherwise, borrowed strings are only copied when output = .render, since a cached template borrowing its text
+        /// can't own a new buffer, and only the contiguous texts at the start of the run are merged.
+        fn mergeStaticTexts(self: *Self, run: []const Element, cursor: *FuseCursor) MergedText {
+            if (run.len == 1) return .{ .content = run[0].static_text, .count = 1 };
+
+            if (comptime is_comptime) {
+                var content: []const u8 = "";
+                for (run) |element| content = content ++ element.static_text;
+                return .{ .content = content, .count = run.len };
+            }
+
+            var total_len: usize = 0;
+            for (run) |element| total_len += element.static_text.len;
+
+            if (comptime !copy_string) {
+                const first = run[0].static_text;
+
+                var contiguous: usize = 1;
+                var contiguous_len: usize = first.len;
+                while (contiguous < run.len) : (contiguous += 1) {
+                    const text = run[contiguous].static_text;
+                    if (first.ptr + contiguous_len != text.ptr) break;
+                    contiguous_len += text.len;
+                }
+
+                const prefix = MergedText{ .content = first.ptr[0..contiguous_len], .count = contiguous };
+                if (contiguous == run.len or options.output != .render) return prefix;
+
+                // Merging is just an optimization, the texts are kept apart when out of memory
+                cursor.merged_texts.ensureUnusedCapacity(self.gpa, 1) catch return prefix;
+                const content = self.gpa.alloc(u8, total_len) catch return prefix;
+                copyRun(content, run);
+
+                cursor.merged_texts.appendAssumeCapacity(content);
+                return .{ .content = content, .count = run.len };
+            } else {
+                const content = self.gpa.alloc(u8, total_len) catch return .{ .content = run[0].static_text, .count = 1 };
+                copyRun(content, run);
+
+                for (run) |element| self.gpa.free(element.static_text);
+                return .{ .content = content, .count = run.len };
+            }
+        }
+
+        fn copyRun(content: []u8, run: []const Element) void {
+            var index: usize = 0;
+            for (run) |element| {
+                std.mem.copy(u8, content[index..], element.static_text);
+                index += element.static_text.len;
+            }
+        }
+
+        fn pathEql(path: Element.Path, other: Element.Path) bool {
+            if (path.len != other.len) return false;
+            for (path) |part, index| {
+                if (part.hash != other[index].hash or !std.mem.eql(u8, part.name, other[index].name)) return false;
+            }
+
+            return true;
+        }
+
         fn unRefNodes(self: *Self) void {
             if (options.isRefCounted()) {
                 var nodes = &self.inner_state.nodes;
@@ -395,10 +555,10 @@ pub fn Parser(comptime options: TemplateOptions) type {
 
         pub fn parsePath(self: *Self, identifier: []const u8) Allocator.Error!Element.Path {
             const action = struct {
-                pub fn action(ctx: *Self, iterator: *std.mem.TokenIterator(u8), index: usize) Allocator.Error!?[][]const u8 {
+                pub fn action(ctx: *Self, iterator: *std.mem.TokenIterator(u8), index: usize) Allocator.Error!?[]Element.PathPart {
                     if (iterator.next()) |part| {
                         var path = (try action(ctx, iterator, index + 1)) orelse unreachable;
-                        path[index] = try ctx.dupe(part);
+                        path[index] = Element.PathPart.init(try ctx.dupe(part));
                         return path;
                     } else {
                         if (comptime options.load_mode == .comptime_loaded) {
@@ -408,21 +568,21 @@ pub fn Parser(comptime options: TemplateOptions) type {
                                 // Creates a static buffer only if running at comptime
                                 const buffer_len = comptime_count.path;
                                 assert(buffer_len >= index);
-                                var buffer: [buffer_len][]const u8 = undefined;
+                                var buffer: [buffer_len]Element.PathPart = undefined;
                                 return buffer[0..index];
                             }
                         } else {
                             if (index == 0) {
                                 return null;
                             } else {
-                                return try ctx.gpa.alloc([]const u8, index);
+                                return try ctx.gpa.alloc(Element.PathPart, index);
                             }
                         }
                     }
                 }
             }.action;
 
-            const empty: Element.Path = &[0][]const u8{};
+            const empty: Element.Path = &[0]Element.PathPart{};
 
             if (identifier.len == 0) {
                 return empty;
@@ -546,7 +706,7 @@ test "Basic parse" {
                     {
                         const element = elements[1];
                         try testing.expectEqual(Element.Type.section, element);
-                        try testing.expectEqualStrings("section", element.section.path[0]);
+                        try testing.expectEqualStrings("section", element.section.path[0].name);
                         try testing.expectEqual(@as(u32, 8), element.section.children_count);
                     }
 
@@ -559,7 +719,7 @@ test "Basic parse" {
                     {
                         const element = elements[3];
                         try testing.expectEqual(Element.Type.interpolation, element);
-                        try testing.expectEqualStrings("name", element.interpolation[0]);
+                        try testing.expectEqualStrings("name", element.interpolation[0].name);
                     }
 
                     {
@@ -571,7 +731,7 @@ test "Basic parse" {
                     {
                         const element = elements[5];
                         try testing.expectEqual(Element.Type.unescaped_interpolation, element);
-                        try testing.expectEqualStrings("comments", element.unescaped_interpolation[0]);
+                        try testing.expectEqualStrings("comments", element.unescaped_interpolation[0].name);
                     }
 
                     {
@@ -583,7 +743,7 @@ test "Basic parse" {
                     {
                         const element = elements[7];
                         try testing.expectEqual(Element.Type.inverted_section, element);
-                        try testing.expectEqualStrings("inverted", element.inverted_section.path[0]);
+                        try testing.expectEqualStrings("inverted", element.inverted_section.path[0].name);
                         try testing.expectEqual(@as(u32, 1), element.inverted_section.children_count);
                     }
 
@@ -725,8 +885,9 @@ test "Scan delimiters Tags" {
                     {
                         var element = elements[0];
                         try testing.expectEqual(Element.Type.interpolation, element);
-                        try testing.expectEqualStrings("interpolation", element.interpolation[0]);
-                        try testing.expectEqualStrings("value", element.interpolation[1]);
+                        try testing.expectEqualStrings("interpolation", element.interpolation[0].name);
+                        try testing.expectEqualStrings("value", element.interpolation[1].name);
+                        try testing.expectEqual(std.array_hash_map.hashString("value"), element.interpolation[1].hash);
                     }
                 },
                 else => try testing.expect(false),
@@ -764,6 +925,70 @@ test "Scan delimiters Tags" {
     };
 }
 
+test "Fuse section and inverted section" {
+    const template_text = "[{{#a}}x{{/a}}{{^a}}y{{#b}}z{{/b}}{{^b}}w{{/b}}{{/a}}{{^c}}{{/c}}]";
+
+    const TestRender = struct {
+        pub const Error = error{ TestUnexpectedResult, TestExpectedEqual };
+
+        calls: u32 = 0,
+
+        pub fn render(ctx: *@This(), elements: []Element) Error!void {
+            defer ctx.calls += 1;
+
+            try testing.expectEqual(@as(usize, 9), elements.len);
+
+            try testing.expectEqual(Element.Type.section, elements[1]);
+            try testing.expectEqualStrings("a", elements[1].section.path[0].name);
+            try testing.expectEqual(@as(u32, 1), elements[1].section.children_count);
+            try testing.expectEqual(@as(u32, 4), elements[1].section.else_count);
+            try testing.expectEqualStrings("x", elements[2].static_text);
+            try testing.expectEqualStrings("y", elements[3].static_text);
+
+            try testing.expectEqual(Element.Type.section, elements[4]);
+            try testing.expectEqualStrings("b", elements[4].section.path[0].name);
+            try testing.expectEqual(@as(u32, 1), elements[4].section.children_count);
+            try testing.expectEqual(@as(u32, 1), elements[4].section.else_count);
+            try testing.expectEqualStrings("z", elements[5].static_text);
+            try testing.expectEqualStrings("w", elements[6].static_text);
+
+            // Inverted sections with a different path are kept
+            try testing.expectEqual(Element.Type.inverted_section, elements[7]);
+            try testing.expectEqualStrings("c", elements[7].inverted_section.path[0].name);
+            try testing.expectEqualStrings("]", elements[8].static_text);
+        }
+    };
+
+    const runTheTest = struct {
+        pub fn action(comptime load_mode: TemplateLoadMode) !void {
+            const allocator = testing.allocator;
+
+            var test_render = TestRender{};
+            var parser = try TesterParser(load_mode).init(allocator, template_text, .{});
+            defer parser.deinit();
+
+            const success = try parser.parse(&test_render);
+
+            try testing.expect(success);
+            try testing.expectEqual(@as(u32, 1), test_render.calls);
+        }
+    }.action;
+
+    //Runtime test
+    try runTheTest(.runtime_loaded);
+
+    //Comptime test
+    if (comptime_tests_enabled) comptime {
+        @setEvalBranchQuota(9999);
+        try runTheTest(.{
+            .comptime_loaded = .{
+                .template_text = template_text,
+                .default_delimiters = .{},
+            },
+        });
+    };
+}
+
 test "Parse - UnexpectedCloseSection " {
 
     //                          Close section
@@ -0,0 +1,488 @@
+const std = @import("std");
+const Allocator = std.mem.Allocator;
+const Mutex = std.Thread.Mutex;
+
+const testing = std.testing;
+const assert = std.debug.assert;
+
+const mustache = @import("mustache.zig");
+const Features = mustache.options.Features;
+const Delimiters = mustache.Delimiters;
+const ParseErrorDetail = mustache.ParseErrorDetail;
+const Template = mustache.Template;
+
+/// Identifies a version of a file on disk.
+/// Any change in inode, size or modification time is considered a new version.
+pub const FileSignature = struct {
+    inode: std.fs.File.INode,
+    size: u64,
+    mtime: i128,
+
+    pub const Error = std.fs.File.OpenError || std.fs.File.StatError;
+
+    pub fn read(absolute_path: []const u8) Error!FileSignature {
+        var file = try std.fs.openFileAbsolute(absolute_path, .{});
+        defer file.close();
+
+        const stat = try file.stat();
+        return FileSignature{
+            .inode = stat.inode,
+            .size = stat.size,
+            .mtime = stat.mtime,
+        };
+    }
+
+    pub fn eql(self: FileSignature, other: FileSignature) bool {
+        return self.inode == other.inode and
+            self.size == other.size and
+            self.mtime == other.mtime;
+    }
+};
+
+/// A named collection of parsed templates shared between threads.
+///
+/// Readers call `acquire` and never block: each published set of templates is an immutable snapshot,
+/// and readers only announce themselves on one of two epoch counters.
+/// Writers are serialized by a mutex, publish a new snapshot with a single pointer swap,
+/// and free the replaced templates only after every reader of the previous epoch has released it.
+///
+/// Partials are resolved by name against the same snapshot at render time,
+/// so reloading a partial is immediately visible to all templates depending on it,
+/// without reparsing them.
+pub fn TemplateRegistry(comptime features: Features) type {
+    return struct {
+        const Self = @This();
+
+        pub const TemplateMap = std.StringHashMap(Template);
+
+        const Snapshot = struct {
+            templates: TemplateMap,
+        };
+
+        const FileSource = struct {
+            absolute_path: []const u8,
+            signature: FileSignature,
+        };
+
+        const Entry = struct {
+            template: Template,
+            file: ?FileSource,
+        };
+
+        /// A consistent view of the registry.
+        /// Templates obtained from a `Reader` are valid until `release` is called.
+        pub const Reader = struct {
+            registry: *Self,
+            snapshot: *const Snapshot,
+            slot: usize,
+
+            pub fn get(self: Reader, name: []const u8) ?Template {
+                return self.snapshot.templates.get(name);
+            }
+
+            /// Returns a map of all templates in this snapshot, suitable to be used as the `partials` argument
+            pub fn partials(self: Reader) TemplateMap {
+                return self.snapshot.templates;
+            }
+
+            pub fn release(self: Reader) void {
+                _ = @atomicRmw(usize, &self.registry.readers[self.slot], .Sub, 1, .SeqCst);
+            }
+        };
+
+        allocator: Allocator,
+        delimiters: Delimiters,
+
+        /// Serializes writers, readers never lock
+        mutex: Mutex = .{},
+
+        /// Owns all names, templates and file paths; only accessed while holding the mutex
+        entries: std.StringHashMapUnmanaged(Entry) = .{},
+
+        current: *Snapshot,
+        epoch: usize = 0,
+        readers: [2]usize = .{ 0, 0 },
+
+        pub fn init(allocator: Allocator, delimiters: Delimiters) Allocator.Error!Self {
+            var snapshot = try allocator.create(Snapshot);
+            snapshot.* = .{ .templates = TemplateMap.init(allocator) };
+
+            return Self{
+                .allocator = allocator,
+                .delimiters = delimiters,
+                .current = snapshot,
+            };
+        }
+
+        /// Frees all templates.
+        /// No reader can be active when calling this function.
+        pub fn deinit(self: *Self) void {
+            assert(self.readers[0] == 0 and self.readers[1] == 0);
+
+            var iterator = self.entries.iterator();
+            while (iterator.next()) |kv| {
+                self.allocator.free(kv.key_ptr.*);
+                self.destroyEntry(kv.value_ptr.*);
+            }
+
+            self.entries.deinit(self.allocator);
+            self.current.templates.deinit();
+            self.allocator.destroy(self.current);
+        }
+
+        /// Returns a snapshot of the current templates, without locking.
+        /// Must be paired with `Reader.release`.
+        pub fn acquire(self: *Self) Reader {
+            while (true) {
+                const epoch = @atomicLoad(usize, &self.epoch, .SeqCst);
+                const slot = epoch & 1;
+                _ = @atomicRmw(usize, &self.readers[slot], .Add, 1, .SeqCst);
+
+                // A writer flipped the epoch after we loaded it,
+                // and may not be waiting for this slot anymore
+                if (@atomicLoad(usize, &self.epoch, .SeqCst) == epoch) {
+                    return Reader{
+                        .registry = self,
+                        .snapshot = @atomicLoad(*Snapshot, &self.current, .SeqCst),
+                        .slot = slot,
+                    };
+                }
+
+                _ = @atomicRmw(usize, &self.readers[slot], .Sub, 1, .SeqCst);
+            }
+        }
+
+        /// Renders the template registered as `name`, using the registry itself as partials
+        pub fn render(self: *Self, name: []const u8, data: anytype, writer: anytype) !void {
+            const reader = self.acquire();
+            defer reader.release();
+
+            const template = reader.get(name) orelse return error.TemplateNotFound;
+            try mustache.renderPartials(template, reader.partials(), data, writer);
+        }
+
+        /// Parses `template_text` and registers it as `name`, replacing any previous template.
+        /// Returns the parse error, if any, leaving the registry unchanged.
+        pub fn putText(self: *Self, name: []const u8, template_text: []const u8) Allocator.Error!?ParseErrorDetail {
+            var template = switch (try mustache.parseText(self.allocator, template_text, self.delimiters, .{ .copy_strings = true, .features = features })) {
+                .success => |template| template,
+                .parse_error => |detail| return detail,
+            };
+            errdefer template.deinit(self.allocator);
+
+            self.mutex.lock();
+            defer self.mutex.unlock();
+
+            try self.replace(name, .{ .template = template, .file = null });
+            return null;
+        }
+
+        /// Parses the file and registers it as `name`, replacing any previous template.
+        /// The file is watched by `refresh`.
+        /// Returns the parse error, if any, leaving the registry unchanged.
+        pub fn putFile(self: *Self, name: []const u8, absolute_path: []const u8) (Allocator.Error || FileSignature.Error || std.fs.File.ReadError)!?ParseErrorDetail {
+            const signature = try FileSignature.read(absolute_path);
+            var template = switch (try mustache.parseFile(self.allocator, absolute_path, self.delimiters, .{ .features = features })) {
+                .success => |template| template,
+                .parse_error => |detail| return detail,
+            };
+            errdefer template.deinit(self.allocator);
+
+            const path = try self.allocator.dupe(u8, absolute_path);
+            errdefer self.allocator.free(path);
+
+            self.mutex.lock();
+            defer self.mutex.unlock();
+
+            try self.replace(name, .{
+                .template = template,
+                .file = .{ .absolute_path = path, .signature = signature },
+            });
+            return null;
+        }
+
+        /// Removes the template registered as `name`.
+        /// Returns false if there is no such template.
+        pub fn remove(self: *Self, name: []const u8) Allocator.Error!bool {
+            self.mutex.lock();
+            defer self.mutex.unlock();
+
+            if (!self.entries.contains(name)) return false;
+
+            var snapshot = try self.cloneSnapshot();
+            _ = snapshot.templates.remove(name);
+
+            const kv = self.entries.fetchRemove(name).?;
+            self.publish(snapshot);
+
+            self.allocator.free(kv.key);
+            self.destroyEntry(kv.value);
+            return true;
+        }
+
+        /// Checks all file templates for changes, reloading the modified ones in a single snapshot.
+        /// Files that can no longer be read or fail to parse keep serving their last good version.
+        /// Returns how many templates were reloaded.
+        pub fn refresh(self: *Self) Allocator.Error!usize {
+            self.mutex.lock();
+            defer self.mutex.unlock();
+
+            const Reload = struct {
+                name: []const u8,
+                entry: *Entry,
+                replacement: Entry,
+            };
+
+            var reloads = std.ArrayList(Reload).init(self.allocator);
+            defer reloads.deinit();
+
+            errdefer for (reloads.items) |reload| {
+                self.destroyEntry(reload.replacement);
+            };
+
+            var iterator = self.entries.iterator();
+            while (iterator.next()) |kv| {
+                const entry = kv.value_ptr;
+                const file = entry.file orelse continue;
+
+                const signature = FileSignature.read(file.absolute_path) catch continue;
+                if (signature.eql(file.signature)) continue;
+
+                const result = mustache.parseFile(self.allocator, file.absolute_path, self.delimiters, .{ .features = features }) catch |err| switch (err) {
+                    error.OutOfMemory => return error.OutOfMemory,
+                    else => continue,
+                };
+
+                switch (result) {
+                    .parse_error => continue,
+                    .success => |template| {
+                        errdefer template.deinit(self.allocator);
+
+                        const path = try self.allocator.dupe(u8, file.absolute_path);
+                        errdefer self.allocator.free(path);
+
+                        try reloads.append(.{
+                            .name = kv.key_ptr.*,
+                            .entry = entry,
+                            .replacement = .{
+                                .template = template,
+                                .file = .{ .absolute_path = path, .signature = signature },
+                            },
+                        });
+                    },
+                }
+            }
+
+            if (reloads.items.len == 0) return 0;
+
+            var snapshot = try self.cloneSnapshot();
+            errdefer self.destroySnapshot(snapshot);
+
+            for (reloads.items) |reload| {
+                try snapshot.templates.put(reload.name, reload.replacement.template);
+            }
+
+            for (reloads.items) |*reload| {
+                std.mem.swap(Entry, reload.entry, &reload.replacement);
+            }
+
+            self.publish(snapshot);
+
+            for (reloads.items) |reload| {
+                self.destroyEntry(reload.replacement);
+            }
+
+            return reloads.items.len;
+        }
+
+        fn replace(self: *Self, name: []const u8, entry: Entry) Allocator.Error!void {
+            var snapshot = try self.cloneSnapshot();
+            errdefer self.destroySnapshot(snapshot);
+
+            if (self.entries.getEntry(name)) |kv| {
+                try snapshot.templates.put(kv.key_ptr.*, entry.template);
+
+                const retired = kv.value_ptr.*;
+                kv.value_ptr.* = entry;
+                self.publish(snapshot);
+
+                self.destroyEntry(retired);
+            } else {
+                const key = try self.allocator.dupe(u8, name);
+                errdefer self.allocator.free(key);
+
+                try snapshot.templates.put(key, entry.template);
+                try self.entries.put(self.allocator, key, entry);
+                self.publish(snapshot);
+            }
+        }
+
+        fn cloneSnapshot(self: *Self) Allocator.Error!*Snapshot {
+            var snapshot = try self.allocator.create(Snapshot);
+            errdefer self.allocator.destroy(snapshot);
+
+            // Writers hold the mutex, there is no need to load `current` atomically
+            snapshot.* = .{ .templates = try self.current.templates.clone() };
+            return snapshot;
+        }
+
+        fn destroySnapshot(self: *Self, snapshot: *Snapshot) void {
+            snapshot.templates.deinit();
+            self.allocator.destroy(snapshot);
+        }
+
+        /// Swaps the current snapshot and waits until no reader can observe the previous one
+        fn publish(self: *Self, snapshot: *Snapshot) void {
+            const previous = self.current;
+            @atomicStore(*Snapshot, &self.current, snapshot, .SeqCst);
+
+            const epoch = @atomicRmw(usize, &self.epoch, .Add, 1, .SeqCst);
+            while (@atomicLoad(usize, &self.readers[epoch & 1], .SeqCst) != 0) {
+                std.atomic.spinLoopHint();
+            }
+
+            self.destroySnapshot(previous);
+        }
+
+        fn destroyEntry(self: *Self, entry: Entry) void {
+            entry.template.deinit(self.allocator);
+            if (entry.file) |file| self.allocator.free(file.absolute_path);
+        }
+    };
+}
+
+test {
+    _ = tests;
+}
+
+const tests = struct {
+    const Registry = TemplateRegistry(.{});
+
+    fn expectRender(registry: *Registry, name: []const u8, data: anytype, expected: []const u8) !void {
+        var list = std.ArrayList(u8).init(testing.allocator);
+        defer list.deinit();
+
+        try registry.render(name, data, list.writer());
+        try testing.expectEqualStrings(expected, list.items);
+    }
+
+    test "Put and render" {
+        var registry = try Registry.init(testing.allocator, .{});
+        defer registry.deinit();
+
+        try testing.expect((try registry.putText("hello", "Hello {{>name}}!")) == null);
+        try testing.expect((try registry.putText("name", "{{name}}")) == null);
+
+        try expectRender(&registry, "hello", .{ .name = "mustache" }, "Hello mustache!");
+        try testing.expectError(error.TemplateNotFound, expectRender(&registry, "missing", .{}, ""));
+    }
+
+    test "Parse error keeps the previous template" {
+        var registry = try Registry.init(testing.allocator, .{});
+        defer registry.deinit();
+
+        try testing.expect((try registry.putText("hello", "{{hello}}")) == null);
+
+        const detail = try registry.putText("hello", "{{#hello}}");
+        try testing.expect(detail != null);
+        try testing.expectEqual(mustache.ParseError.UnexpectedEof, detail.?.parse_error);
+
+        try expectRender(&registry, "hello", .{ .hello = "world" }, "world");
+    }
+
+    test "Replace a partial" {
+        var registry = try Registry.init(testing.allocator, .{});
+        defer registry.deinit();
+
+        _ = try registry.putText("main", "[{{>item}}]");
+        _ = try registry.putText("item", "one");
+        try expectRender(&registry, "main", .{}, "[one]");
+
+        // Dependents see the new partial without being reparsed
+        _ = try registry.putText("item", "two");
+        try expectRender(&registry, "main", .{}, "[two]");
+
+        try testing.expect(try registry.remove("item"));
+        try testing.expect(!try registry.remove("item"));
+        try expectRender(&registry, "main", .{}, "[]");
+    }
+
+    test "Readers keep their snapshot" {
+        var registry = try Registry.init(testing.allocator, .{});
+        defer registry.deinit();
+
+        _ = try registry.putText("hello", "first");
+
+        const reader = registry.acquire();
+        const template = reader.get("hello").?;
+        try testing.expectEqualStrings("first", template.elements[0].static_text);
+        reader.release();
+
+        _ = try registry.putText("hello", "second");
+
+        const other = registry.acquire();
+        defer other.release();
+        try testing.expectEqualStrings("second", other.get("hello").?.elements[0].static_text);
+    }
+
+    test "Concurrent readers" {
+        if (@import("builtin").single_threaded) return error.SkipZigTest;
+
+        var registry = try Registry.init(testing.allocator, .{});
+        defer registry.deinit();
+
+        _ = try registry.putText("counter", "{{value}}");
+
+        const Worker = struct {
+            fn run(target: *Registry) void {
+                var i: usize = 0;
+                while (i < 1000) : (i += 1) {
+                    var counting_writer = std.io.countingWriter(std.io.null_writer);
+                    target.render("counter", .{ .value = i }, counting_writer.writer()) catch unreachable;
+                }
+            }
+        };
+
+        var threads: [4]std.Thread = undefined;
+        for (threads) |*thread| {
+            thread.* = try std.Thread.spawn(.{}, Worker.run, .{&registry});
+        }
+
+        var i: usize = 0;
+        while (i < 100) : (i += 1) {
+            _ = try registry.putText("counter", if (i % 2 == 0) "{{value}}" else "<{{value}}>");
+        }
+
+        for (threads) |thread| thread.join();
+    }
+
+    test "Refresh file templates" {
+        var tmp = testing.tmpDir(.{});
+        defer tmp.cleanup();
+
+        {
+            var file = try tmp.dir.createFile("refresh.mustache", .{ .truncate = true });
+            defer file.close();
+            try file.writeAll("{{hello}}");
+        }
+
+        const absolute_path = try tmp.dir.realpathAlloc(testing.allocator, "refresh.mustache");
+        defer testing.allocator.free(absolute_path);
+
+        var registry = try Registry.init(testing.allocator, .{});
+        defer registry.deinit();
+
+        try testing.expect((try registry.putFile("file", absolute_path)) == null);
+        try testing.expectEqual(@as(usize, 0), try registry.refresh());
+        try expectRender(&registry, "file", .{ .hello = "world" }, "world");
+
+        {
+            var file = try tmp.dir.createFile("refresh.mustache", .{ .truncate = true });
+            defer file.close();
+            try file.writeAll("Hello {{hello}}");
+        }
+
+        try testing.expectEqual(@as(usize, 1), try registry.refresh());
+        try expectRender(&registry, "file", .{ .hello = "world" }, "Hello world");
+    }
+};
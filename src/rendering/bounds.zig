@@ -0,0 +1,324 @@
+const std = @import("std");
+const meta = std.meta;
+
+const testing = std.testing;
+
+const mustache = @import("../mustache.zig");
+const Element = mustache.Element;
+const Template = mustache.Template;
+
+const context = @import("context.zig");
+const Escape = context.Escape;
+const RawJson = context.RawJson;
+const MsgPack = context.MsgPack;
+const CsvRow = @import("csv_stream.zig").CsvRow;
+const JsonDocument = context.JsonDocument;
+const numbers = @import("numbers.zig");
+const iterators = @import("iterators.zig");
+const columns = @import("columns.zig");
+
+/// Max number of nested contexts followed by the analysis, including the root.
+/// Deeper sections and paths are considered unbounded.
+const max_depth = 3;
+
+/// Longest replacement produced by the HTML escape, `"` => `&quot;`
+const max_escape_len = 6;
+
+/// Returns an upper bound for the number of bytes rendered by the template with any value of type `Data`,
+/// or null if the output can't be bounded, such as when rendering slices, floats, lambdas, JSON values or partials.
+/// When both the template and the `Data` type are comptime-known, the bound can be computed at comptime
+/// to size the buffer passed to `bufRender`.
+pub fn outputBound(template: Template, comptime Data: type) ?usize {
+    return Bound(&[_]type{Data}).level(template.elements);
+}
+
+fn Bound(comptime stack: []const type) type {
+    return struct {
+        const Lookup = union(enum) {
+            found: ?usize,
+            not_found,
+        };
+
+        fn level(elements: []const Element) ?usize {
+            var size: usize = 0;
+
+            var index: usize = 0;
+            while (index < elements.len) {
+                const element = elements[index];
+                index += 1;
+
+                const children = elements[index .. index + element.childrenCount()];
+                index += children.len;
+
+                const element_size: ?usize = switch (element) {
+                    .static_text => |content| content.len,
+                    .interpolation => |path| lookup(path, Interpolation(.Escaped), {}),
+                    .unescaped_interpolation => |path| lookup(path, Interpolation(.Unescaped), {}),
+                    .section => |section| section: {
+                        const section_size = lookup(section.path, Section, children[0..section.children_count]) orelse return null;
+                        const else_size = level(children[section.children_count..]) orelse return null;
+                        break :section std.math.max(section_size, else_size);
+                    },
+                    .inverted_section, .block => level(children),
+
+                    // The templates of partials and parents are not known
+                    .partial, .parent => null,
+                };
+
+                size = std.math.add(usize, size, element_size orelse return null) catch return null;
+            }
+
+            return size;
+        }
+
+        /// Resolves the path from the top of the context stack down to the root, as the renderer does
+        fn lookup(path: Element.Path, comptime Visitor: type, arg: anytype) ?usize {
+            if (path.len == 0) return Visitor.visit(stack, stack[stack.len - 1], arg);
+
+            comptime var index = stack.len;
+            inline while (index > 0) : (index -= 1) {
+                switch (find(stack[index - 1], path, Visitor, arg, 1)) {
+                    .found => |size| return size,
+                    .not_found => {},
+                }
+            }
+
+            // Missing values render nothing
+            return 0;
+        }
+
+        fn find(comptime T: type, path: Element.Path, comptime Visitor: type, arg: anytype, comptime depth: usize) Lookup {
+            if (depth > max_depth or comptime isDynamic(T)) return .{ .found = null };
+
+            switch (@typeInfo(T)) {
+                .Pointer => |info| switch (info.size) {
+                    .One => return find(info.child, path, Visitor, arg, depth),
+                    .Slice => return findLen(path, Visitor, arg),
+                    else => {},
+                },
+                .Array, .Vector => return findLen(path, Visitor, arg),
+                .Optional => |info| return find(info.child, path, Visitor, arg, depth),
+                .Struct => |info| {
+                    inline for (info.fields) |field| {
+                        if (std.mem.eql(u8, field.name, path[0].name)) {
+                            if (path.len == 1) return Lookup{ .found = Visitor.visit(stack, field.field_type, arg) };
+
+                            // Broken chains render nothing
+                            return Lookup{
+                                .found = switch (find(field.field_type, path[1..], Visitor, arg, depth + 1)) {
+                                    .found => |size| size,
+                                    .not_found => 0,
+                                },
+                            };
+                        }
+                    }
+
+                    // Lambdas have unknown output
+                    inline for (comptime meta.declarations(T)) |decl| {
+                        if (decl.is_pub and std.mem.eql(u8, decl.name, path[0].name)) return Lookup{ .found = null };
+                    }
+
+                    return .not_found;
+                },
+                .Void, .Bool, .Int, .ComptimeInt, .Float, .ComptimeFloat, .Enum => return .not_found,
+                else => {},
+            }
+
+            // Dynamic values such as JSON can't be analyzed
+            return Lookup{ .found = null };
+        }
+
+        fn findLen(path: Element.Path, comptime Visitor: type, arg: anytype) Lookup {
+            return if (path.len == 1 and std.mem.eql(u8, "len", path[0].name))
+                Lookup{ .found = Visitor.visit(stack, usize, arg) }
+            else
+                .not_found;
+        }
+    };
+}
+
+fn Interpolation(comptime escape: Escape) type {
+    return struct {
+        fn visit(comptime stack: []const type, comptime T: type, arg: void) ?usize {
+            _ = stack;
+            _ = arg;
+            return valueBound(T, escape);
+        }
+    };
+}
+
+const Section = struct {
+    fn visit(comptime stack: []const type, comptime T: type, children: []const Element) ?usize {
+        if (stack.len >= max_depth or comptime isDynamic(T)) return null;
+
+        switch (@typeInfo(T)) {
+            .Pointer => |info| switch (info.size) {
+                .One => return visit(stack, info.child, children),
+
+                // Strings render once, other slices iterate over an unknown number of items
+                .Slice => return if (info.child == u8) Bound(stack ++ &[_]type{T}).level(children) else null,
+                else => return null,
+            },
+            .Optional => |info| return visit(stack, info.child, children),
+            .Array => |info| {
+                if (info.child == u8) return Bound(stack ++ &[_]type{T}).level(children);
+
+                const item_size = Bound(stack ++ &[_]type{info.child}).level(children) orelse return null;
+                return std.math.mul(usize, item_size, info.len) catch null;
+            },
+            .Vector => |info| {
+                const item_size = Bound(stack ++ &[_]type{info.child}).level(children) orelse return null;
+                return std.math.mul(usize, item_size, info.len) catch null;
+            },
+            .Struct => |info| {
+                if (info.is_tuple) {
+                    var size: usize = 0;
+                    inline for (info.fields) |field| {
+                        const item_size = Bound(stack ++ &[_]type{field.field_type}).level(children) orelse return null;
+                        size = std.math.add(usize, size, item_size) catch return null;
+                    }
+
+                    return size;
+                }
+
+                // Iterators and struct-of-arrays containers render an unknown number of items
+                if (comptime iterators.isIterable(T) or columns.ElemOf(T) != null) return null;
+
+                return Bound(stack ++ &[_]type{T}).level(children);
+            },
+            .Void, .Bool, .Int, .ComptimeInt, .Float, .ComptimeFloat, .Enum => return Bound(stack ++ &[_]type{T}).level(children),
+
+            // Lambdas and dynamic values
+            else => return null,
+        }
+    }
+};
+
+/// Data sources resolved at runtime, whose shape is not known from the type
+fn isDynamic(comptime T: type) bool {
+    return T == std.json.Value or T == std.json.ValueTree or T == RawJson or T == MsgPack or T == CsvRow or T == JsonDocument;
+}
+
+fn valueBound(comptime T: type, comptime escape: Escape) ?usize {
+    return switch (@typeInfo(T)) {
+        .Void => 0,
+        .Bool => "false".len,
+        .Int => numbers.maxIntLen(T),
+        .Enum => |info| comptime tag: {
+            var len: usize = 0;
+            for (info.fields) |field| len = std.math.max(len, escapedLen(field.name, escape));
+            break :tag len;
+        },
+        .Pointer => |info| if (info.size == .One) valueBound(info.child, escape) else null,
+        .Optional => |info| valueBound(info.child, escape),
+        .Array => |info| if (info.child == u8) info.len * (if (escape == .Escaped) max_escape_len else 1) else 0,
+
+        // Floats, slices and comptime values have no useful bound
+        else => null,
+    };
+}
+
+fn escapedLen(comptime text: []const u8, comptime escape: Escape) usize {
+    comptime {
+        if (escape == .Unescaped) return text.len;
+
+        var len: usize = 0;
+        for (text) |char| {
+            len += switch (char) {
+                '<', '>' => "&lt;".len,
+                '&' => "&amp;".len,
+                '"' => "&quot;".len,
+                else => 1,
+            };
+        }
+
+        return len;
+    }
+}
+
+const comptime_tests_enabled = @import("build_comptime_tests").comptime_tests_enabled;
+
+test {
+    _ = tests;
+}
+
+const tests = struct {
+    const Item = struct { n: u8 };
+
+    const Data = struct {
+        id: u32,
+        flag: bool,
+        kind: enum { a, bbb },
+        items: [3]Item,
+        code: [4]u8,
+        name: []const u8,
+        ratio: f32,
+    };
+
+    fn expectBound(expected: ?usize, template_text: []const u8) !void {
+        var template = switch (try mustache.parseText(testing.allocator, template_text, .{}, .{ .copy_strings = false })) {
+            .success => |template| template,
+            .parse_error => return error.TestUnexpectedResult,
+        };
+        defer template.deinit(testing.allocator);
+
+        try testing.expectEqual(expected, outputBound(template, Data));
+        try testing.expectEqual(expected, outputBound(template, *const Data));
+    }
+
+    test "Bounded values" {
+        // u32 has 10 digits, bool 5, the enum 3, and three items of 1 + 3 + 1 bytes
+        try expectBound(10 + 1 + 5 + 1 + 3 + 1 + 15 + 2, "{{id}}-{{flag}}-{{kind}}:{{#items}}[{{n}}]{{/items}}{{^flag}}no{{/flag}}");
+        try expectBound(4 * 6, "{{code}}");
+        try expectBound(4, "{{{code}}}");
+        try expectBound(20, "{{items.len}}");
+    }
+
+    test "Else branch" {
+        try expectBound(3, "{{#flag}}yes{{/flag}}{{^flag}}no{{/flag}}");
+    }
+
+    test "Missing values" {
+        try expectBound(2, "[{{missing}}{{items.missing}}]");
+    }
+
+    test "Unbounded values" {
+        try expectBound(null, "{{name}}");
+        try expectBound(null, "{{ratio}}");
+        try expectBound(null, "{{>partial}}");
+        try expectBound(null, "{{#items}}{{name}}{{/items}}");
+    }
+
+    test "Preallocated render" {
+        const data = Data{
+            .id = 42,
+            .flag = false,
+            .kind = .bbb,
+            .items = .{ .{ .n = 1 }, .{ .n = 2 }, .{ .n = 3 } },
+            .code = "a<b>".*,
+            .name = "unused",
+            .ratio = 0,
+        };
+
+        const template_text = "{{id}}-{{kind}}-{{code}}:{{#items}}[{{n}}]{{/items}}{{#flag}}yes{{/flag}}{{^flag}}no{{/flag}}";
+        const expected = "42-bbb-a&lt;b&gt;:[1][2][3]no";
+
+        var template = (try mustache.parseText(testing.allocator, template_text, .{}, .{ .copy_strings = false })).success;
+        defer template.deinit(testing.allocator);
+
+        const result = try mustache.allocRenderWithOptions(testing.allocator, template, data, .{ .preallocation = .output_bound });
+        defer testing.allocator.free(result);
+        try testing.expectEqualStrings(expected, result);
+
+        if (comptime_tests_enabled) {
+            const comptime_template = comptime mustache.parseComptime(template_text, .{}, .{});
+            const bound = comptime bound: {
+                @setEvalBranchQuota(99999);
+                break :bound outputBound(comptime_template, Data).?;
+            };
+
+            var buffer: [bound]u8 = undefined;
+            try testing.expectEqualStrings(expected, try mustache.bufRender(&buffer, comptime_template, data));
+        }
+    }
+};
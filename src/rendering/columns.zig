@@ -0,0 +1,184 @@
+const std = @import("std");
+const meta = std.meta;
+const trait = std.meta.trait;
+
+const testing = std.testing;
+
+const mustache = @import("../mustache.zig");
+
+/// Returns the element type of a `std.MultiArrayList` or `std.MultiArrayList.Slice`,
+/// or null if `T` is neither
+pub fn ElemOf(comptime T: type) ?type {
+    comptime {
+        if (@typeInfo(T) != .Struct) return null;
+
+        if (@hasDecl(T, "Elem") and @TypeOf(T.Elem) == type and @typeInfo(T.Elem) == .Struct and T == std.MultiArrayList(T.Elem)) {
+            return T.Elem;
+        }
+
+        if (trait.hasFn("toMultiArrayList")(T)) {
+            const List = @typeInfo(@TypeOf(T.toMultiArrayList)).Fn.return_type orelse return null;
+            if (ElemOf(List)) |Elem| {
+                if (List.Slice == T) return Elem;
+            }
+        }
+
+        return null;
+    }
+}
+
+/// Tags the `ColumnItem` types
+const ColumnItemMarker = opaque {};
+
+/// An item of a struct-of-arrays container, reading each field from its column by index
+pub fn ColumnItem(comptime Container: type) type {
+    return struct {
+        const Self = @This();
+
+        pub const Marker = ColumnItemMarker;
+        pub const Elem = ElemOf(Container).?;
+        pub const Field = meta.FieldEnum(Elem);
+
+        container: *const Container,
+        index: usize,
+
+        pub fn FieldValue(comptime field: Field) type {
+            return *const meta.fieldInfo(Elem, field).field_type;
+        }
+
+        pub fn fieldPtr(self: Self, comptime field: Field) FieldValue(field) {
+            return &self.container.items(field)[self.index];
+        }
+
+        /// Gathers all the fields into an `Elem`, to call the functions it declares
+        pub fn row(self: Self) Elem {
+            return if (comptime Container == std.MultiArrayList(Elem))
+                self.container.get(self.index)
+            else
+                self.container.toMultiArrayList().get(self.index);
+        }
+    };
+}
+
+pub fn isColumnItem(comptime T: type) bool {
+    return @typeInfo(T) == .Struct and @hasDecl(T, "Marker") and @TypeOf(T.Marker) == type and T.Marker == ColumnItemMarker;
+}
+
+test {
+    _ = tests;
+}
+
+const tests = struct {
+    const Point = struct {
+        x: i32,
+        label: []const u8,
+        tags: []const []const u8,
+
+        pub fn describe(self: Point, ctx: mustache.LambdaContext) !void {
+            try ctx.writeFormat("{s}={d}", .{ self.label, self.x });
+        }
+
+        pub fn shout(ctx: mustache.LambdaContext) !void {
+            try ctx.renderFormat(testing.allocator, "{s}!", .{ctx.inner_text});
+        }
+
+        pub fn invalid(self: Point) i32 {
+            return self.x;
+        }
+    };
+
+    const Points = std.MultiArrayList(Point);
+
+    test "Column types" {
+        try testing.expect(ElemOf(Points).? == Point);
+        try testing.expect(ElemOf(Points.Slice).? == Point);
+        try testing.expect(ElemOf(Point) == null);
+        try testing.expect(ElemOf(std.ArrayList(Point)) == null);
+
+        try testing.expect(isColumnItem(ColumnItem(Points)));
+        try testing.expect(!isColumnItem(Point));
+    }
+
+    test "Render" {
+        const allocator = testing.allocator;
+
+        var points = Points{};
+        defer points.deinit(allocator);
+
+        try points.append(allocator, .{ .x = 1, .label = "a", .tags = &[_][]const u8{"t"} });
+        try points.append(allocator, .{ .x = 2, .label = "<b>", .tags = &[_][]const u8{} });
+
+        const Data = struct {
+            title: []const u8,
+            points: Points,
+            slice: Points.Slice,
+            empty: Points,
+        };
+
+        const data = Data{
+            .title = "Points",
+            .points = points,
+            .slice = points.slice(),
+            .empty = .{},
+        };
+
+        const template_text = "{{#points}}{{x}}:{{label}}[{{#tags}}{{.}}{{/tags}}]({{title}}){{/points}}|{{points.len}}|{{#slice}}{{x}},{{/slice}}|{{^empty}}none{{/empty}}";
+
+        var template = (try mustache.parseText(allocator, template_text, .{}, .{ .copy_strings = false })).success;
+        defer template.deinit(allocator);
+
+        const result = try mustache.allocRender(allocator, template, data);
+        defer allocator.free(result);
+
+        try testing.expectEqualStrings("1:a[t](Points)2:&lt;b&gt;[](Points)|2|1,2,|none", result);
+    }
+
+    test "Broken chain" {
+        const allocator = testing.allocator;
+
+        var points = Points{};
+        defer points.deinit(allocator);
+
+        try points.append(allocator, .{ .x = 1, .label = "a", .tags = &[_][]const u8{} });
+
+        const Data = struct {
+            points: Points,
+            x: struct { len: u32 },
+        };
+
+        // The item's `x` has no `len`, the parent's `x` is not looked up
+        var template = (try mustache.parseText(allocator, "{{#points}}{{label.len}}|{{x.len}}{{/points}}", .{}, .{ .copy_strings = false })).success;
+        defer template.deinit(allocator);
+
+        const result = try mustache.allocRender(allocator, template, Data{ .points = points, .x = .{ .len = 9 } });
+        defer allocator.free(result);
+
+        try testing.expectEqualStrings("1|", result);
+    }
+
+    test "Lambdas" {
+        const allocator = testing.allocator;
+
+        var points = Points{};
+        defer points.deinit(allocator);
+
+        try points.append(allocator, .{ .x = 1, .label = "a", .tags = &[_][]const u8{} });
+        try points.append(allocator, .{ .x = 2, .label = "b", .tags = &[_][]const u8{} });
+
+        const Data = struct {
+            points: Points,
+            invalid: []const u8 = "parent",
+        };
+
+        // Lambdas declared by the element type are resolved against the row, as for a slice of structs,
+        // both when interpolated and as sections, which expand after the lookup returns.
+        // Functions that are not lambdas break the chain instead of falling back to the parent
+        var template = (try mustache.parseText(allocator, "{{#points}}{{describe}} {{#shout}}{{label}}{{/shout}} [{{invalid}}] ({{#describe}}-{{/describe}});{{/points}}", .{}, .{ .copy_strings = false })).success;
+        defer template.deinit(allocator);
+
+        const result = try mustache.allocRender(allocator, template, Data{ .points = points });
+        defer allocator.free(result);
+
+        try testing.expectEqualStrings("a=1 a! [] (a=1);b=2 b! [] (b=2);", result);
+    }
+};
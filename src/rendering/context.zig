@@ -24,6 +24,21 @@ const FlattenedType = invoker.FlattenedType;
 
 const map = @import("partials_map.zig");
 
+const iterators = @import("iterators.zig");
+const columns = @import("columns.zig");
+
+const raw_json = @import("raw_json.zig");
+pub const RawJson = raw_json.RawJson;
+
+const json_document = @import("json_document.zig");
+pub const JsonDocument = json_document.JsonDocument;
+
+const msgpack = @import("msgpack.zig");
+pub const MsgPack = msgpack.MsgPack;
+
+const csv_stream = @import("csv_stream.zig");
+const CsvRow = csv_stream.CsvRow;
+
 pub fn PathResolution(comptime Payload: type) type {
     return union(enum) {
         /// The path could no be found on the current context
@@ -62,6 +77,27 @@ pub const Escape = enum {
     Unescaped,
 };
 
+/// Trusted content known to be HTML-safe.
+/// Interpolated as-is, without scanning for chars to escape, even by `{{value}}` tags.
+pub const SafeHtml = struct {
+    value: []const u8,
+};
+
+/// A range of a file, streamed into the output when interpolated, without reading it into memory.
+/// Unescaped interpolations rendered into a file are copied by the kernel.
+/// Fields holding a `std.io.Reader` are streamed the same way.
+pub const FileRange = struct {
+    file: std.fs.File,
+    offset: u64 = 0,
+
+    /// Number of bytes to render, or null to render until the end of the file
+    len: ?u64 = null,
+};
+
+/// Errors reading a `FileRange` or a reader while streaming it into the output.
+/// Reader errors not declared by `std.fs.File.PReadError` are reported as `ReadFailed`
+pub const StreamError = std.fs.File.PReadError || error{ReadFailed};
+
 pub fn getContext(comptime Writer: type, data: anytype, comptime PartialsMap: type, comptime options: RenderOptions) Context: {
     const Data = @TypeOf(data);
     const by_value = Fields.byValue(Data);
@@ -78,6 +114,24 @@ pub fn getContext(comptime Writer: type, data: anytype, comptime PartialsMap: ty
     } else if (Data == json.ValueTree or (comptime trait.isSingleItemPtr(Data) and meta.Child(Data) == json.ValueTree)) {
         const Impl = JsonContextImpl(Writer, PartialsMap, options);
         return Impl.context(data.root);
+    } else if (Data == RawJson or (comptime trait.isSingleItemPtr(Data) and meta.Child(Data) == RawJson)) {
+        const Impl = RawJsonContextImpl(Writer, PartialsMap, options);
+        return Impl.context(data.root());
+    } else if (Data == MsgPack or (comptime trait.isSingleItemPtr(Data) and meta.Child(Data) == MsgPack)) {
+        const Impl = MsgPackContextImpl(Writer, PartialsMap, options);
+        return Impl.context(data.root());
+    } else if (comptime trait.isSingleItemPtr(Data) and meta.Child(Data) == CsvRow) {
+        const Impl = CsvRowContextImpl(Writer, PartialsMap, options);
+        return Impl.context(.{ .row = data.* });
+    } else if (comptime trait.isSingleItemPtr(Data) and columns.isColumnItem(meta.Child(Data))) {
+        const Impl = ColumnItemContextImpl(Writer, meta.Child(Data), PartialsMap, options);
+        return Impl.context(data.*);
+    } else if (comptime trait.isSingleItemPtr(Data) and iterators.isCursor(meta.Child(Data))) {
+        const Impl = CursorContextImpl(Writer, meta.Child(Data), PartialsMap, options);
+        return Impl.context(data.*);
+    } else if (comptime trait.isSingleItemPtr(Data) and meta.Child(Data) == JsonDocument) {
+        const Impl = JsonDocumentContextImpl(Writer, PartialsMap, options);
+        return Impl.context(data.root());
     } else {
         const Impl = ContextImpl(Writer, Data, PartialsMap, options);
         return Impl.context(data);
@@ -99,8 +153,16 @@ pub fn Context(comptime Writer: type, comptime PartialsMap: type, comptime optio
         const VTable = struct {
             get: fn (*const anyopaque, Element.Path, ?usize) PathResolution(Self),
             capacityHint: fn (*const anyopaque, *DataRender, Element.Path) PathResolution(usize),
-            interpolate: fn (*const anyopaque, *DataRender, Element.Path, Escape) (Allocator.Error || Writer.Error)!PathResolution(void),
-            expandLambda: fn (*const anyopaque, *DataRender, Element.Path, []const u8, Escape, Delimiters) (Allocator.Error || Writer.Error)!PathResolution(void),
+            interpolate: fn (*const anyopaque, *DataRender, Element.Path, Escape) (Allocator.Error || Writer.Error || StreamError)!PathResolution(void),
+            expandLambda: fn (*const anyopaque, *DataRender, Element.Path, []const u8, Escape, Delimiters) (Allocator.Error || Writer.Error || StreamError)!PathResolution(void),
+
+            /// Returns the item following this one in a sequence,
+            /// for data sources faster to walk forward than to index
+            next: ?fn (*const anyopaque) ?Self = null,
+
+            /// Returns whether a forward-only sequence has items, without fetching from it.
+            /// Set only by sequences that can't be walked twice, such as iterators
+            peek: ?fn (*const anyopaque) bool = null,
         };
 
         pub const Iterator = struct {
@@ -114,6 +176,10 @@ pub fn Context(comptime Writer: type, comptime PartialsMap: type, comptime optio
                         fetching: struct {
                             item: Self,
                             index: usize,
+
+                            /// The item was already returned, the following one is fetched by the next call.
+                            /// Fetching lazily keeps a forward-only source from overwriting an item still being rendered
+                            returned: bool = false,
                         },
                         finished,
                     },
@@ -183,91 +249,1117 @@ pub fn Context(comptime Writer: type, comptime PartialsMap: type, comptime optio
                 }
             }
 
-            pub fn next(self: *Iterator) ?Self {
-                switch (self.data) {
-                    .lambda, .empty => return null,
-                    .sequence => |*sequence| switch (sequence.state) {
-                        .fetching => |current| {
-                            const next_index = current.index + 1;
-                            if (sequence.fetch(next_index)) |item| {
-                                sequence.state = .{
-                                    .fetching = .{
-                                        .item = item,
-                                        .index = next_index,
-                                    },
-                                };
-                            } else {
-                                sequence.state = .finished;
-                            }
+            pub fn next(self: *Iterator) ?Self {
+                switch (self.data) {
+                    .lambda, .empty => return null,
+                    .sequence => |*sequence| switch (sequence.state) {
+                        .fetching => |*current| {
+                            if (current.returned) {
+                                const next_index = current.index + 1;
+                                const next_item = if (current.item.vtable.next) |next_fn|
+                                    next_fn(&current.item.ctx)
+                                else
+                                    sequence.fetch(next_index);
+
+                                if (next_item) |item| {
+                                    current.item = item;
+                                    current.index = next_index;
+                                } else {
+                                    sequence.state = .finished;
+                                    return null;
+                                }
+                            }
+
+                            current.returned = true;
+                            return current.item;
+                        },
+                        .finished => return null,
+                    },
+                }
+            }
+        };
+
+        ctx: FlattenedType = undefined,
+        vtable: *const VTable,
+
+        pub inline fn get(self: Self, path: Element.Path) PathResolution(Self) {
+            return self.vtable.get(&self.ctx, path, null);
+        }
+
+        /// Returns true if the context is a forward-only sequence, that must be iterated only once
+        pub inline fn isForwardOnly(self: Self) bool {
+            return self.vtable.peek != null;
+        }
+
+        /// Returns whether a forward-only sequence has items, leaving it untouched
+        pub inline fn peek(self: *const Self) bool {
+            return self.vtable.peek.?(&self.ctx);
+        }
+
+        pub inline fn capacityHint(
+            self: Self,
+            data_render: *DataRender,
+            path: Element.Path,
+        ) PathResolution(usize) {
+            return self.vtable.capacityHint(&self.ctx, data_render, path);
+        }
+
+        pub fn iterator(self: *const Self, path: Element.Path) PathResolution(Iterator) {
+            const result = self.vtable.get(&self.ctx, path, 0);
+
+            return switch (result) {
+                .field => |item| .{
+                    .field = Iterator.initSequence(self, path, item),
+                },
+                .iterator_consumed => .{
+                    .field = Iterator.initEmpty(),
+                },
+                .lambda => |item| .{
+                    .field = Iterator.initLambda(item),
+                },
+                .chain_broken => .chain_broken,
+                .not_found_in_context => .not_found_in_context,
+            };
+        }
+
+        pub inline fn interpolate(
+            self: Self,
+            data_render: *DataRender,
+            path: Element.Path,
+            escape: Escape,
+        ) (Allocator.Error || Writer.Error || StreamError)!PathResolution(void) {
+            return try self.vtable.interpolate(&self.ctx, data_render, path, escape);
+        }
+
+        pub inline fn expandLambda(
+            self: Self,
+            data_render: *DataRender,
+            path: Element.Path,
+            inner_text: []const u8,
+            escape: Escape,
+            delimiters: Delimiters,
+        ) (Allocator.Error || Writer.Error || StreamError)!PathResolution(void) {
+            return try self.vtable.expandLambda(&self.ctx, data_render, path, inner_text, escape, delimiters);
+        }
+    };
+}
+
+fn ContextImpl(comptime Writer: type, comptime Data: type, comptime PartialsMap: type, comptime options: RenderOptions) type {
+    const RenderEngine = rendering.RenderEngine(Writer, PartialsMap, options);
+    const ContextInterface = RenderEngine.Context;
+    const DataRender = RenderEngine.DataRender;
+    const Invoker = RenderEngine.Invoker;
+
+    return struct {
+        const vtable = ContextInterface.VTable{
+            .get = get,
+            .capacityHint = capacityHint,
+            .interpolate = interpolate,
+            .expandLambda = expandLambda,
+            .peek = if (comptime iterators.isForwardOnly(Data)) peek else null,
+        };
+
+        const is_zero_size = @sizeOf(Data) == 0;
+        const Self = @This();
+
+        pub fn context(data: Data) ContextInterface {
+            var interface = ContextInterface{
+                .vtable = &vtable,
+            };
+
+            if (!is_zero_size) {
+                if (comptime @sizeOf(Data) > @sizeOf(FlattenedType)) @compileError(std.fmt.comptimePrint("Type {s} size {} exceeds the maxinum by-val size of {}", .{ @typeName(Data), @sizeOf(Data), @sizeOf(FlattenedType) }));
+                var ptr = @ptrCast(*Data, @alignCast(@alignOf(Data), &interface.ctx));
+                ptr.* = data;
+            }
+
+            return interface;
+        }
+
+        fn get(ctx: *const anyopaque, path: Element.Path, index: ?usize) PathResolution(ContextInterface) {
+            return Invoker.get(
+                getData(ctx),
+                path,
+                index,
+            );
+        }
+
+        fn capacityHint(
+            ctx: *const anyopaque,
+            data_render: *DataRender,
+            path: Element.Path,
+        ) PathResolution(usize) {
+            return Invoker.capacityHint(
+                data_render,
+                getData(ctx),
+                path,
+            );
+        }
+
+        fn interpolate(
+            ctx: *const anyopaque,
+            data_render: *DataRender,
+            path: Element.Path,
+            escape: Escape,
+        ) (Allocator.Error || Writer.Error || StreamError)!PathResolution(void) {
+            return try Invoker.interpolate(
+                data_render,
+                getData(ctx),
+                path,
+                escape,
+            );
+        }
+
+        fn expandLambda(
+            ctx: *const anyopaque,
+            data_render: *DataRender,
+            path: Element.Path,
+            inner_text: []const u8,
+            escape: Escape,
+            delimiters: Delimiters,
+        ) (Allocator.Error || Writer.Error || StreamError)!PathResolution(void) {
+            return try Invoker.expandLambda(
+                data_render,
+                getData(ctx),
+                inner_text,
+                escape,
+                delimiters,
+                path,
+            );
+        }
+
+        fn peek(ctx: *const anyopaque) bool {
+            return iterators.peek(getData(ctx));
+        }
+
+        inline fn getData(ctx: *const anyopaque) Data {
+            return if (is_zero_size) undefined else (@ptrCast(*const Data, @alignCast(@alignOf(Data), ctx))).*;
+        }
+    };
+}
+
+fn ColumnItemContextImpl(comptime Writer: type, comptime Item: type, comptime PartialsMap: type, comptime options: RenderOptions) type {
+    const RenderEngine = rendering.RenderEngine(Writer, PartialsMap, options);
+    const ContextInterface = RenderEngine.Context;
+    const DataRender = RenderEngine.DataRender;
+    const Invoker = RenderEngine.Invoker;
+    const fields = meta.fields(Item.Elem);
+    const decls = meta.declarations(Item.Elem);
+
+    return struct {
+        const vtable = ContextInterface.VTable{
+            .get = get,
+            .capacityHint = capacityHint,
+            .interpolate = interpolate,
+            .expandLambda = expandLambda,
+        };
+
+        pub fn context(item: Item) ContextInterface {
+            var interface = ContextInterface{
+                .vtable = &vtable,
+            };
+
+            var ptr = @ptrCast(*Item, @alignCast(@alignOf(Item), &interface.ctx));
+            ptr.* = item;
+
+            return interface;
+        }
+
+        fn get(ctx: *const anyopaque, path: Element.Path, index: ?usize) PathResolution(ContextInterface) {
+            const item = getItem(ctx);
+
+            if (path.len == 0) {
+                return if (index == null or index.? == 0) .{ .field = context(item) } else .iterator_consumed;
+            }
+
+            inline for (fields) |field| {
+                if (std.mem.eql(u8, field.name, path[0].name)) {
+                    const value = item.fieldPtr(@field(Item.Field, field.name));
+                    return leaf(ContextInterface, Invoker.get(value, path[1..], index));
+                }
+            }
+
+            if (isPubDecl(path[0].name)) {
+                const row = item.row();
+
+                // The returned lambda would point to this copy of the row,
+                // it is bound to the item instead, gathering the row again when expanded
+                return switch (Invoker.get(&row, path, index)) {
+                    .lambda => .{ .lambda = ColumnLambdaContextImpl(Writer, Item, PartialsMap, options).context(item, &path[0]) },
+                    .not_found_in_context => .not_found_in_context,
+                    .iterator_consumed => .iterator_consumed,
+                    .chain_broken, .field => .chain_broken,
+                };
+            }
+
+            return .not_found_in_context;
+        }
+
+        fn capacityHint(
+            ctx: *const anyopaque,
+            data_render: *DataRender,
+            path: Element.Path,
+        ) PathResolution(usize) {
+            const item = getItem(ctx);
+            if (path.len == 0) return .{ .field = 0 };
+
+            inline for (fields) |field| {
+                if (std.mem.eql(u8, field.name, path[0].name)) {
+                    const value = item.fieldPtr(@field(Item.Field, field.name));
+                    return leaf(usize, Invoker.capacityHint(data_render, value, path[1..]));
+                }
+            }
+
+            if (isPubDecl(path[0].name)) {
+                const row = item.row();
+                return Invoker.capacityHint(data_render, &row, path);
+            }
+
+            return .not_found_in_context;
+        }
+
+        fn interpolate(
+            ctx: *const anyopaque,
+            data_render: *DataRender,
+            path: Element.Path,
+            escape: Escape,
+        ) (Allocator.Error || Writer.Error || StreamError)!PathResolution(void) {
+            const item = getItem(ctx);
+            if (path.len == 0) return .field;
+
+            inline for (fields) |field| {
+                if (std.mem.eql(u8, field.name, path[0].name)) {
+                    const value = item.fieldPtr(@field(Item.Field, field.name));
+                    return leaf(void, try Invoker.interpolate(data_render, value, path[1..], escape));
+                }
+            }
+
+            if (isPubDecl(path[0].name)) {
+                const row = item.row();
+                return try Invoker.interpolate(data_render, &row, path, escape);
+            }
+
+            return .not_found_in_context;
+        }
+
+        fn expandLambda(
+            ctx: *const anyopaque,
+            data_render: *DataRender,
+            path: Element.Path,
+            inner_text: []const u8,
+            escape: Escape,
+            delimiters: Delimiters,
+        ) (Allocator.Error || Writer.Error || StreamError)!PathResolution(void) {
+            const item = getItem(ctx);
+            if (path.len == 0) return .field;
+
+            inline for (fields) |field| {
+                if (std.mem.eql(u8, field.name, path[0].name)) {
+                    const value = item.fieldPtr(@field(Item.Field, field.name));
+                    return leaf(void, try Invoker.expandLambda(data_render, value, inner_text, escape, delimiters, path[1..]));
+                }
+            }
+
+            if (isPubDecl(path[0].name)) {
+                const row = item.row();
+                return try Invoker.expandLambda(data_render, &row, inner_text, escape, delimiters, path);
+            }
+
+            return .not_found_in_context;
+        }
+
+        /// Functions declared by the element type are resolved as the `Invoker` does for a struct,
+        /// against a row gathered from the columns only when the name matches one
+        fn isPubDecl(name: []const u8) bool {
+            inline for (decls) |decl| {
+                if (comptime decl.is_pub) {
+                    if (std.mem.eql(u8, decl.name, name)) return true;
+                }
+            }
+
+            return false;
+        }
+
+        /// The remaining path parts are resolved against the field only,
+        /// a part not found there breaks the chain instead of falling back to the parent context
+        fn leaf(comptime T: type, result: PathResolution(T)) PathResolution(T) {
+            return if (result == .not_found_in_context) .chain_broken else result;
+        }
+
+        inline fn getItem(ctx: *const anyopaque) Item {
+            return (@ptrCast(*const Item, @alignCast(@alignOf(Item), ctx))).*;
+        }
+    };
+}
+
+/// A lambda declared by the element type of a column item, expanded against a row gathered when called
+fn ColumnLambdaContextImpl(comptime Writer: type, comptime Item: type, comptime PartialsMap: type, comptime options: RenderOptions) type {
+    const RenderEngine = rendering.RenderEngine(Writer, PartialsMap, options);
+    const ContextInterface = RenderEngine.Context;
+    const DataRender = RenderEngine.DataRender;
+    const Invoker = RenderEngine.Invoker;
+
+    const Bound = struct {
+        item: Item,
+
+        /// The lambda's name, from the template's path
+        part: *const Element.PathPart,
+    };
+
+    return struct {
+        const vtable = ContextInterface.VTable{
+            .get = get,
+            .capacityHint = capacityHint,
+            .interpolate = interpolate,
+            .expandLambda = expandLambda,
+        };
+
+        pub fn context(item: Item, part: *const Element.PathPart) ContextInterface {
+            if (comptime @sizeOf(Bound) > @sizeOf(FlattenedType)) @compileError("Column lambda exceeds the maxinum by-val size");
+
+            var interface = ContextInterface{
+                .vtable = &vtable,
+            };
+
+            var ptr = @ptrCast(*Bound, @alignCast(@alignOf(Bound), &interface.ctx));
+            ptr.* = .{ .item = item, .part = part };
+
+            return interface;
+        }
+
+        fn get(ctx: *const anyopaque, path: Element.Path, index: ?usize) PathResolution(ContextInterface) {
+            _ = index;
+
+            // Lambdas cannot be used for navigation through a path
+            if (path.len > 0) return .chain_broken;
+
+            const bound = getBound(ctx);
+            return .{ .lambda = context(bound.item, bound.part) };
+        }
+
+        fn capacityHint(
+            ctx: *const anyopaque,
+            data_render: *DataRender,
+            path: Element.Path,
+        ) PathResolution(usize) {
+            _ = ctx;
+            _ = data_render;
+
+            return if (path.len > 0) .chain_broken else .{ .lambda = 0 };
+        }
+
+        fn interpolate(
+            ctx: *const anyopaque,
+            data_render: *DataRender,
+            path: Element.Path,
+            escape: Escape,
+        ) (Allocator.Error || Writer.Error || StreamError)!PathResolution(void) {
+            _ = ctx;
+            _ = data_render;
+            _ = escape;
+
+            return if (path.len > 0) .chain_broken else .{ .lambda = {} };
+        }
+
+        fn expandLambda(
+            ctx: *const anyopaque,
+            data_render: *DataRender,
+            path: Element.Path,
+            inner_text: []const u8,
+            escape: Escape,
+            delimiters: Delimiters,
+        ) (Allocator.Error || Writer.Error || StreamError)!PathResolution(void) {
+            if (path.len > 0) return .chain_broken;
+
+            const bound = getBound(ctx);
+            const row = bound.item.row();
+            const lambda_path: Element.Path = @as(*const [1]Element.PathPart, bound.part);
+            return try Invoker.expandLambda(data_render, &row, inner_text, escape, delimiters, lambda_path);
+        }
+
+        inline fn getBound(ctx: *const anyopaque) *const Bound {
+            return @ptrCast(*const Bound, @alignCast(@alignOf(Bound), ctx));
+        }
+    };
+}
+
+fn CursorContextImpl(comptime Writer: type, comptime Cursor: type, comptime PartialsMap: type, comptime options: RenderOptions) type {
+    const RenderEngine = rendering.RenderEngine(Writer, PartialsMap, options);
+    const ContextInterface = RenderEngine.Context;
+    const DataRender = RenderEngine.DataRender;
+    const Invoker = RenderEngine.Invoker;
+
+    // Items are kept inside the context, and referenced by pointer while rendered
+    const Item = if (Fields.byValue(Cursor.Item)) Cursor.Item else *const Cursor.Item;
+
+    return struct {
+        const vtable = ContextInterface.VTable{
+            .get = get,
+            .capacityHint = capacityHint,
+            .interpolate = interpolate,
+            .expandLambda = expandLambda,
+            .next = next,
+        };
+
+        pub fn context(cursor: Cursor) ContextInterface {
+            if (comptime @sizeOf(Cursor) > @sizeOf(FlattenedType)) @compileError(std.fmt.comptimePrint(
+                "Iterator {s} and its item exceed the maxinum by-val size of {}, iterate it through a pointer or return items by pointer",
+                .{ @typeName(Cursor.State), @sizeOf(FlattenedType) },
+            ));
+
+            var interface = ContextInterface{
+                .vtable = &vtable,
+            };
+
+            var ptr = @ptrCast(*Cursor, @alignCast(@alignOf(Cursor), &interface.ctx));
+            ptr.* = cursor;
+
+            return interface;
+        }
+
+        fn get(ctx: *const anyopaque, path: Element.Path, index: ?usize) PathResolution(ContextInterface) {
+            return Invoker.get(
+                getItem(ctx),
+                path,
+                index,
+            );
+        }
+
+        fn next(ctx: *const anyopaque) ?ContextInterface {
+            const following = getCursor(ctx).following() orelse return null;
+            return context(following);
+        }
+
+        fn capacityHint(
+            ctx: *const anyopaque,
+            data_render: *DataRender,
+            path: Element.Path,
+        ) PathResolution(usize) {
+            return Invoker.capacityHint(
+                data_render,
+                getItem(ctx),
+                path,
+            );
+        }
+
+        fn interpolate(
+            ctx: *const anyopaque,
+            data_render: *DataRender,
+            path: Element.Path,
+            escape: Escape,
+        ) (Allocator.Error || Writer.Error || StreamError)!PathResolution(void) {
+            return try Invoker.interpolate(
+                data_render,
+                getItem(ctx),
+                path,
+                escape,
+            );
+        }
+
+        fn expandLambda(
+            ctx: *const anyopaque,
+            data_render: *DataRender,
+            path: Element.Path,
+            inner_text: []const u8,
+            escape: Escape,
+            delimiters: Delimiters,
+        ) (Allocator.Error || Writer.Error || StreamError)!PathResolution(void) {
+            return try Invoker.expandLambda(
+                data_render,
+                getItem(ctx),
+                inner_text,
+                escape,
+                delimiters,
+                path,
+            );
+        }
+
+        inline fn getCursor(ctx: *const anyopaque) *const Cursor {
+            return @ptrCast(*const Cursor, @alignCast(@alignOf(Cursor), ctx));
+        }
+
+        inline fn getItem(ctx: *const anyopaque) Item {
+            return if (comptime Fields.byValue(Cursor.Item)) getCursor(ctx).item else &getCursor(ctx).item;
+        }
+    };
+}
+
+fn JsonContextImpl(comptime Writer: type, comptime PartialsMap: type, comptime options: RenderOptions) type {
+    const RenderEngine = rendering.RenderEngine(Writer, PartialsMap, options);
+    const ContextInterface = RenderEngine.Context;
+    const DataRender = RenderEngine.DataRender;
+    const Depth = enum { Root, Leaf };
+
+    return struct {
+        const vtable = ContextInterface.VTable{
+            .get = get,
+            .capacityHint = capacityHint,
+            .interpolate = interpolate,
+            .expandLambda = expandLambda,
+        };
+
+        const Self = @This();
+
+        pub fn context(json_value: json.Value) ContextInterface {
+            var interface = ContextInterface{
+                .vtable = &vtable,
+                .ctx = undefined,
+            };
+
+            const Data = json.Value;
+            var ptr = @ptrCast(*Data, @alignCast(@alignOf(Data), &interface.ctx));
+            ptr.* = json_value;
+
+            return interface;
+        }
+
+        fn get(ctx: *const anyopaque, path: Element.Path, index: ?usize) PathResolution(ContextInterface) {
+            const root = getJsonRoot(ctx);
+            const value = getJsonValue(.Root, root, path, index, null);
+
+            return switch (value) {
+                .not_found_in_context => .not_found_in_context,
+                .chain_broken => .chain_broken,
+                .iterator_consumed => .iterator_consumed,
+                .field => |content| .{ .field = getContext(Writer, content, PartialsMap, options) },
+                .lambda => {
+                    assert(false);
+                    unreachable;
+                },
+            };
+        }
+
+        fn capacityHint(
+            ctx: *const anyopaque,
+            data_render: *DataRender,
+            path: Element.Path,
+        ) PathResolution(usize) {
+            const root = getJsonRoot(ctx);
+            const value = getJsonValue(.Root, root, path, null, data_render.objectSlots());
+
+            return switch (value) {
+                .not_found_in_context => .not_found_in_context,
+                .chain_broken => .chain_broken,
+                .iterator_consumed => .iterator_consumed,
+                .field => |content| switch (content) {
+                    .Bool => |boolean| return .{ .field = data_render.valueCapacityHint(boolean) },
+                    .Integer => |integer| return .{ .field = data_render.valueCapacityHint(integer) },
+                    .Float => |float| return .{ .field = data_render.valueCapacityHint(float) },
+                    .NumberString => |number_string| return .{ .field = data_render.valueCapacityHint(number_string) },
+                    .String => |string| return .{ .field = data_render.valueCapacityHint(string) },
+                    .Array => |array| return .{ .field = data_render.valueCapacityHint(array.items) },
+                    else => return .{ .field = 0 },
+                },
+                .lambda => {
+                    assert(false);
+                    unreachable;
+                },
+            };
+        }
+
+        fn interpolate(
+            ctx: *const anyopaque,
+            data_render: *DataRender,
+            path: Element.Path,
+            escape: Escape,
+        ) (Allocator.Error || Writer.Error || StreamError)!PathResolution(void) {
+            const root = getJsonRoot(ctx);
+            const value = getJsonValue(.Root, root, path, null, data_render.objectSlots());
+
+            switch (value) {
+                .not_found_in_context => return .not_found_in_context,
+                .chain_broken => return .chain_broken,
+                .iterator_consumed => return .iterator_consumed,
+                .field => |content| switch (content) {
+                    .Bool => |boolean| try data_render.write(boolean, escape),
+                    .Integer => |integer| try data_render.write(integer, escape),
+                    .Float => |float| try data_render.write(float, escape),
+                    .NumberString => |number_string| try data_render.write(number_string, escape),
+                    .String => |string| try data_render.write(string, escape),
+                    .Array => |array| try data_render.write(array.items, escape),
+                    else => {},
+                },
+                .lambda => {
+                    assert(false);
+                    unreachable;
+                },
+            }
+
+            return .field;
+        }
+
+        fn expandLambda(
+            ctx: *const anyopaque,
+            data_render: *DataRender,
+            path: Element.Path,
+            inner_text: []const u8,
+            escape: Escape,
+            delimiters: Delimiters,
+        ) (Allocator.Error || Writer.Error || StreamError)!PathResolution(void) {
+            _ = ctx;
+            _ = data_render;
+            _ = path;
+            _ = inner_text;
+            _ = escape;
+            _ = delimiters;
+
+            // Json objects cannot have declared lambdas
+            return PathResolution(void).chain_broken;
+        }
+
+        fn getJsonValue(depth: Depth, value: json.Value, path: Element.Path, index: ?usize, slots: ?*ObjectSlots) PathResolution(json.Value) {
+            if (path.len == 0) {
+                if (index) |current_index| {
+                    switch (value) {
+                        .Array => |array| if (array.items.len > current_index) {
+                            return .{ .field = array.items[current_index] };
+                        },
+                        .Bool => |boolean| if (boolean == true and current_index == 0) {
+                            return .{ .field = value };
+                        },
+                        else => if (current_index == 0) {
+                            return .{ .field = value };
+                        },
+                        .Null => {},
+                    }
+
+                    return .iterator_consumed;
+                } else {
+                    return .{ .field = value };
+                }
+            } else {
+                switch (value) {
+                    .Object => |obj| {
+                        const found = if (slots) |object_slots|
+                            object_slots.get(obj, &path[0])
+                        else
+                            obj.getAdapted(path[0], PathPartContext{});
+
+                        if (found) |next_value| {
+                            return getJsonValue(.Leaf, next_value, path[1..], index, slots);
+                        }
+                    },
+
+                    else => {},
+                }
+            }
+
+            return if (depth == .Root) .not_found_in_context else .chain_broken;
+        }
+
+        inline fn getJsonRoot(ctx: *const anyopaque) json.Value {
+            const Data = json.Value;
+            return (@ptrCast(*const Data, @alignCast(@alignOf(Data), ctx))).*;
+        }
+    };
+}
+
+/// Looks up `std.json.ObjectMap` keys using the hash computed at parse time
+const PathPartContext = struct {
+    pub fn hash(self: PathPartContext, part: Element.PathPart) u32 {
+        _ = self;
+        return part.hash;
+    }
+
+    pub fn eql(self: PathPartContext, part: Element.PathPart, key: []const u8, key_index: usize) bool {
+        _ = self;
+        _ = key_index;
+        return std.mem.eql(u8, part.name, key);
+    }
+};
+
+/// Inline cache for `std.json.ObjectMap` lookups, kept by each render.
+/// Remembers, for each name, the index where its key was last found.
+/// Objects from the same source usually share the same key order,
+/// so the next object is checked at that index before falling back to the hash lookup.
+/// Names are keyed by the hash computed at parse time, each one keeps its own entry;
+/// once the table is full, new names are looked up by hash only.
+/// Hints are always verified against the key, a stale entry just costs a miss.
+pub const ObjectSlots = struct {
+    const len = 64;
+    const max_used = len * 3 / 4;
+
+    /// No hint yet, always fails the bounds check
+    const no_index = std.math.maxInt(u32);
+
+    const Entry = struct {
+        hash: u32 = 0,
+        index: u32 = no_index,
+        used: bool = false,
+    };
+
+    entries: [len]Entry = [_]Entry{.{}} ** len,
+    used: usize = 0,
+
+    pub fn get(self: *ObjectSlots, obj: json.ObjectMap, part: *const Element.PathPart) ?json.Value {
+        const entry = self.find(part.hash) orelse return obj.getAdapted(part.*, PathPartContext{});
+
+        const keys = obj.keys();
+        if (entry.index < keys.len and std.mem.eql(u8, keys[entry.index], part.name)) {
+            return obj.values()[entry.index];
+        }
+
+        const index = obj.getIndexAdapted(part.*, PathPartContext{}) orelse return null;
+        entry.index = @intCast(u32, index);
+
+        return obj.values()[index];
+    }
+
+    /// Returns the entry of the hash, claiming a free one if the table is not full
+    fn find(self: *ObjectSlots, hash: u32) ?*Entry {
+        var slot = hash % len;
+        while (true) : (slot = (slot + 1) % len) {
+            const entry = &self.entries[slot];
+
+            if (!entry.used) {
+                if (self.used >= max_used) return null;
+
+                self.used += 1;
+                entry.* = .{ .hash = hash, .used = true };
+                return entry;
+            }
+
+            if (entry.hash == hash) return entry;
+        }
+    }
+};
+
+fn RawJsonContextImpl(comptime Writer: type, comptime PartialsMap: type, comptime options: RenderOptions) type {
+    const RenderEngine = rendering.RenderEngine(Writer, PartialsMap, options);
+    const ContextInterface = RenderEngine.Context;
+    const DataRender = RenderEngine.DataRender;
+    const Depth = enum { Root, Leaf };
+    const Node = raw_json.Node;
+
+    return struct {
+        const vtable = ContextInterface.VTable{
+            .get = get,
+            .capacityHint = capacityHint,
+            .interpolate = interpolate,
+            .expandLambda = expandLambda,
+            .next = next,
+        };
+
+        pub fn context(node: Node) ContextInterface {
+            if (comptime @sizeOf(Node) > @sizeOf(FlattenedType)) @compileError("Node exceeds the maxinum by-val size");
+
+            var interface = ContextInterface{
+                .vtable = &vtable,
+                .ctx = undefined,
+            };
+
+            var ptr = @ptrCast(*Node, @alignCast(@alignOf(Node), &interface.ctx));
+            ptr.* = node;
+
+            return interface;
+        }
+
+        fn get(ctx: *const anyopaque, path: Element.Path, index: ?usize) PathResolution(ContextInterface) {
+            return switch (getNode(.Root, getRoot(ctx), path, index)) {
+                .not_found_in_context => .not_found_in_context,
+                .chain_broken => .chain_broken,
+                .iterator_consumed => .iterator_consumed,
+                .field => |node| .{ .field = context(node) },
+                .lambda => unreachable,
+            };
+        }
+
+        fn next(ctx: *const anyopaque) ?ContextInterface {
+            const node = getRoot(ctx).next() orelse return null;
+            return context(node);
+        }
+
+        fn capacityHint(
+            ctx: *const anyopaque,
+            data_render: *DataRender,
+            path: Element.Path,
+        ) PathResolution(usize) {
+            _ = data_render;
+
+            return switch (getNode(.Root, getRoot(ctx), path, null)) {
+                .not_found_in_context => .not_found_in_context,
+                .chain_broken => .chain_broken,
+                .iterator_consumed => .iterator_consumed,
+                .field => |node| .{
+                    .field = switch (node.kind()) {
+                        .Bool => 5,
+                        .Integer, .Float => node.value.len,
+                        .String => node.rawString().len,
+                        .Null, .Array, .Object => 0,
+                    },
+                },
+                .lambda => unreachable,
+            };
+        }
+
+        fn interpolate(
+            ctx: *const anyopaque,
+            data_render: *DataRender,
+            path: Element.Path,
+            escape: Escape,
+        ) (Allocator.Error || Writer.Error || StreamError)!PathResolution(void) {
+            switch (getNode(.Root, getRoot(ctx), path, null)) {
+                .not_found_in_context => return .not_found_in_context,
+                .chain_broken => return .chain_broken,
+                .iterator_consumed => return .iterator_consumed,
+                .field => |node| switch (node.kind()) {
+                    .Bool => try data_render.write(node.isTrue(), escape),
+                    .Integer => try data_render.write(node.value, escape),
+
+                    // Floats are rendered as parsed by `std.json`, not as they were written
+                    .Float => if (std.fmt.parseFloat(f64, node.value)) |float| {
+                        try data_render.write(float, escape);
+                    } else |_| {},
+
+                    .String => try writeString(data_render, node.rawString(), escape),
+                    .Null, .Array, .Object => {},
+                },
+                .lambda => unreachable,
+            }
+
+            return .field;
+        }
+
+        /// Writes the string straight from the JSON text, or decoded in chunks if it has escape sequences.
+        /// The chunks live in a stack buffer, so they bypass the escape cache
+        fn writeString(data_render: *DataRender, raw: []const u8, escape: Escape) (Allocator.Error || Writer.Error || StreamError)!void {
+            if (std.mem.indexOfScalar(u8, raw, '\\') == null) return try data_render.write(raw, escape);
+
+            var buffer: [256]u8 = undefined;
+            var len: usize = 0;
+
+            var unescaper = raw_json.Unescaper{ .text = raw };
+            var char_buffer: [4]u8 = undefined;
+            while (unescaper.next(&char_buffer)) |bytes| {
+                if (len + bytes.len > buffer.len) {
+                    try data_render.writeTransient(buffer[0..len], escape);
+                    len = 0;
+                }
+
+                std.mem.copy(u8, buffer[len..], bytes);
+                len += bytes.len;
+            }
+
+            try data_render.writeTransient(buffer[0..len], escape);
+        }
+
+        fn expandLambda(
+            ctx: *const anyopaque,
+            data_render: *DataRender,
+            path: Element.Path,
+            inner_text: []const u8,
+            escape: Escape,
+            delimiters: Delimiters,
+        ) (Allocator.Error || Writer.Error || StreamError)!PathResolution(void) {
+            _ = ctx;
+            _ = data_render;
+            _ = path;
+            _ = inner_text;
+            _ = escape;
+            _ = delimiters;
+
+            // Json objects cannot have declared lambdas
+            return PathResolution(void).chain_broken;
+        }
+
+        fn getNode(depth: Depth, node: Node, path: Element.Path, index: ?usize) PathResolution(Node) {
+            if (path.len == 0) {
+                if (index) |current_index| {
+                    switch (node.kind()) {
+                        .Array => if (node.at(current_index)) |item| {
+                            return .{ .field = item };
+                        },
+                        .Bool => if (node.isTrue() and current_index == 0) {
+                            return .{ .field = .{ .value = node.value } };
+                        },
+                        .Null => {},
+                        else => if (current_index == 0) {
+                            return .{ .field = .{ .value = node.value } };
+                        },
+                    }
+
+                    return .iterator_consumed;
+                } else {
+                    return .{ .field = node };
+                }
+            } else if (node.get(path[0].name)) |member| {
+                return getNode(.Leaf, member, path[1..], index);
+            }
+
+            return if (depth == .Root) .not_found_in_context else .chain_broken;
+        }
+
+        inline fn getRoot(ctx: *const anyopaque) Node {
+            return (@ptrCast(*const Node, @alignCast(@alignOf(Node), ctx))).*;
+        }
+    };
+}
+
+fn MsgPackContextImpl(comptime Writer: type, comptime PartialsMap: type, comptime options: RenderOptions) type {
+    const RenderEngine = rendering.RenderEngine(Writer, PartialsMap, options);
+    const ContextInterface = RenderEngine.Context;
+    const DataRender = RenderEngine.DataRender;
+    const Depth = enum { Root, Leaf };
+    const Node = msgpack.Node;
+
+    return struct {
+        const vtable = ContextInterface.VTable{
+            .get = get,
+            .capacityHint = capacityHint,
+            .interpolate = interpolate,
+            .expandLambda = expandLambda,
+            .next = next,
+        };
+
+        pub fn context(node: Node) ContextInterface {
+            if (comptime @sizeOf(Node) > @sizeOf(FlattenedType)) @compileError("Node exceeds the maxinum by-val size");
+
+            var interface = ContextInterface{
+                .vtable = &vtable,
+                .ctx = undefined,
+            };
+
+            var ptr = @ptrCast(*Node, @alignCast(@alignOf(Node), &interface.ctx));
+            ptr.* = node;
 
-                            return current.item;
-                        },
-                        .finished => return null,
-                    },
-                }
-            }
-        };
+            return interface;
+        }
 
-        ctx: FlattenedType = undefined,
-        vtable: *const VTable,
+        fn get(ctx: *const anyopaque, path: Element.Path, index: ?usize) PathResolution(ContextInterface) {
+            return switch (getNode(.Root, getRoot(ctx), path, index)) {
+                .not_found_in_context => .not_found_in_context,
+                .chain_broken => .chain_broken,
+                .iterator_consumed => .iterator_consumed,
+                .field => |node| .{ .field = context(node) },
+                .lambda => unreachable,
+            };
+        }
 
-        pub inline fn get(self: Self, path: Element.Path) PathResolution(Self) {
-            return self.vtable.get(&self.ctx, path, null);
+        fn next(ctx: *const anyopaque) ?ContextInterface {
+            const node = getRoot(ctx).next() orelse return null;
+            return context(node);
         }
 
-        pub inline fn capacityHint(
-            self: Self,
+        fn capacityHint(
+            ctx: *const anyopaque,
             data_render: *DataRender,
             path: Element.Path,
         ) PathResolution(usize) {
-            return self.vtable.capacityHint(&self.ctx, data_render, path);
-        }
-
-        pub fn iterator(self: *const Self, path: Element.Path) PathResolution(Iterator) {
-            const result = self.vtable.get(&self.ctx, path, 0);
-
-            return switch (result) {
-                .field => |item| .{
-                    .field = Iterator.initSequence(self, path, item),
-                },
-                .iterator_consumed => .{
-                    .field = Iterator.initEmpty(),
-                },
-                .lambda => |item| .{
-                    .field = Iterator.initLambda(item),
-                },
-                .chain_broken => .chain_broken,
+            return switch (getNode(.Root, getRoot(ctx), path, null)) {
                 .not_found_in_context => .not_found_in_context,
+                .chain_broken => .chain_broken,
+                .iterator_consumed => .iterator_consumed,
+                .field => |node| .{
+                    .field = switch (node.kind()) {
+                        .Bool => data_render.valueCapacityHint(node.isTrue()),
+                        .Integer => switch (node.integer()) {
+                            .signed => |signed| data_render.valueCapacityHint(signed),
+                            .unsigned => |unsigned| data_render.valueCapacityHint(unsigned),
+                        },
+                        .Float => data_render.valueCapacityHint(node.float()),
+                        .String, .Binary => data_render.valueCapacityHint(node.string()),
+                        .Null, .Array, .Map, .Extension => 0,
+                    },
+                },
+                .lambda => unreachable,
             };
         }
 
-        pub inline fn interpolate(
-            self: Self,
+        fn interpolate(
+            ctx: *const anyopaque,
             data_render: *DataRender,
             path: Element.Path,
             escape: Escape,
-        ) (Allocator.Error || Writer.Error)!PathResolution(void) {
-            return try self.vtable.interpolate(&self.ctx, data_render, path, escape);
+        ) (Allocator.Error || Writer.Error || StreamError)!PathResolution(void) {
+            switch (getNode(.Root, getRoot(ctx), path, null)) {
+                .not_found_in_context => return .not_found_in_context,
+                .chain_broken => return .chain_broken,
+                .iterator_consumed => return .iterator_consumed,
+                .field => |node| switch (node.kind()) {
+                    .Bool => try data_render.write(node.isTrue(), escape),
+                    .Integer => switch (node.integer()) {
+                        .signed => |signed| try data_render.write(signed, escape),
+                        .unsigned => |unsigned| try data_render.write(unsigned, escape),
+                    },
+                    .Float => try data_render.write(node.float(), escape),
+
+                    // Strings are written straight from the input bytes
+                    .String, .Binary => try data_render.write(node.string(), escape),
+                    .Null, .Array, .Map, .Extension => {},
+                },
+                .lambda => unreachable,
+            }
+
+            return .field;
         }
 
-        pub inline fn expandLambda(
-            self: Self,
+        fn expandLambda(
+            ctx: *const anyopaque,
             data_render: *DataRender,
             path: Element.Path,
             inner_text: []const u8,
             escape: Escape,
             delimiters: Delimiters,
-        ) (Allocator.Error || Writer.Error)!PathResolution(void) {
-            return try self.vtable.expandLambda(&self.ctx, data_render, path, inner_text, escape, delimiters);
+        ) (Allocator.Error || Writer.Error || StreamError)!PathResolution(void) {
+            _ = ctx;
+            _ = data_render;
+            _ = path;
+            _ = inner_text;
+            _ = escape;
+            _ = delimiters;
+
+            // MessagePack maps cannot have declared lambdas
+            return PathResolution(void).chain_broken;
+        }
+
+        fn getNode(depth: Depth, node: Node, path: Element.Path, index: ?usize) PathResolution(Node) {
+            if (path.len == 0) {
+                if (index) |current_index| {
+                    switch (node.kind()) {
+                        .Array => if (node.at(current_index)) |item| {
+                            return .{ .field = item };
+                        },
+                        .Bool => if (node.isTrue() and current_index == 0) {
+                            return .{ .field = .{ .value = node.value } };
+                        },
+                        .Null => {},
+                        else => if (current_index == 0) {
+                            return .{ .field = .{ .value = node.value } };
+                        },
+                    }
+
+                    return .iterator_consumed;
+                } else {
+                    return .{ .field = node };
+                }
+            } else if (node.get(path[0].name)) |member| {
+                return getNode(.Leaf, member, path[1..], index);
+            }
+
+            return if (depth == .Root) .not_found_in_context else .chain_broken;
+        }
+
+        inline fn getRoot(ctx: *const anyopaque) Node {
+            return (@ptrCast(*const Node, @alignCast(@alignOf(Node), ctx))).*;
         }
     };
 }
 
-fn ContextImpl(comptime Writer: type, comptime Data: type, comptime PartialsMap: type, comptime options: RenderOptions) type {
+fn CsvRowContextImpl(comptime Writer: type, comptime PartialsMap: type, comptime options: RenderOptions) type {
     const RenderEngine = rendering.RenderEngine(Writer, PartialsMap, options);
     const ContextInterface = RenderEngine.Context;
     const DataRender = RenderEngine.DataRender;
-    const Invoker = RenderEngine.Invoker;
+    const Depth = enum { Root, Leaf };
+
+    /// The row, or one of its fields
+    const Node = struct {
+        row: CsvRow,
+        column: ?u32 = null,
+
+        fn field(self: @This()) []const u8 {
+            return self.row.fields[self.column.?];
+        }
+    };
 
     return struct {
         const vtable = ContextInterface.VTable{
@@ -277,29 +1369,28 @@ fn ContextImpl(comptime Writer: type, comptime Data: type, comptime PartialsMap:
             .expandLambda = expandLambda,
         };
 
-        const is_zero_size = @sizeOf(Data) == 0;
-        const Self = @This();
+        pub fn context(node: Node) ContextInterface {
+            if (comptime @sizeOf(Node) > @sizeOf(FlattenedType)) @compileError("Node exceeds the maxinum by-val size");
 
-        pub fn context(data: Data) ContextInterface {
             var interface = ContextInterface{
                 .vtable = &vtable,
+                .ctx = undefined,
             };
 
-            if (!is_zero_size) {
-                if (comptime @sizeOf(Data) > @sizeOf(FlattenedType)) @compileError(std.fmt.comptimePrint("Type {s} size {} exceeds the maxinum by-val size of {}", .{ @typeName(Data), @sizeOf(Data), @sizeOf(FlattenedType) }));
-                var ptr = @ptrCast(*Data, @alignCast(@alignOf(Data), &interface.ctx));
-                ptr.* = data;
-            }
+            var ptr = @ptrCast(*Node, @alignCast(@alignOf(Node), &interface.ctx));
+            ptr.* = node;
 
             return interface;
         }
 
         fn get(ctx: *const anyopaque, path: Element.Path, index: ?usize) PathResolution(ContextInterface) {
-            return Invoker.get(
-                getData(ctx),
-                path,
-                index,
-            );
+            return switch (getNode(.Root, getRoot(ctx), path, index)) {
+                .not_found_in_context => .not_found_in_context,
+                .chain_broken => .chain_broken,
+                .iterator_consumed => .iterator_consumed,
+                .field => |node| .{ .field = context(node) },
+                .lambda => unreachable,
+            };
         }
 
         fn capacityHint(
@@ -307,11 +1398,15 @@ fn ContextImpl(comptime Writer: type, comptime Data: type, comptime PartialsMap:
             data_render: *DataRender,
             path: Element.Path,
         ) PathResolution(usize) {
-            return Invoker.capacityHint(
-                data_render,
-                getData(ctx),
-                path,
-            );
+            _ = data_render;
+
+            return switch (getNode(.Root, getRoot(ctx), path, null)) {
+                .not_found_in_context => .not_found_in_context,
+                .chain_broken => .chain_broken,
+                .iterator_consumed => .iterator_consumed,
+                .field => |node| .{ .field = if (node.column != null) node.field().len else 0 },
+                .lambda => unreachable,
+            };
         }
 
         fn interpolate(
@@ -319,13 +1414,16 @@ fn ContextImpl(comptime Writer: type, comptime Data: type, comptime PartialsMap:
             data_render: *DataRender,
             path: Element.Path,
             escape: Escape,
-        ) (Allocator.Error || Writer.Error)!PathResolution(void) {
-            return try Invoker.interpolate(
-                data_render,
-                getData(ctx),
-                path,
-                escape,
-            );
+        ) (Allocator.Error || Writer.Error || StreamError)!PathResolution(void) {
+            switch (getNode(.Root, getRoot(ctx), path, null)) {
+                .not_found_in_context => return .not_found_in_context,
+                .chain_broken => return .chain_broken,
+                .iterator_consumed => return .iterator_consumed,
+                .field => |node| if (node.column != null) try data_render.write(node.field(), escape),
+                .lambda => unreachable,
+            }
+
+            return .field;
         }
 
         fn expandLambda(
@@ -335,28 +1433,48 @@ fn ContextImpl(comptime Writer: type, comptime Data: type, comptime PartialsMap:
             inner_text: []const u8,
             escape: Escape,
             delimiters: Delimiters,
-        ) (Allocator.Error || Writer.Error)!PathResolution(void) {
-            return try Invoker.expandLambda(
-                data_render,
-                getData(ctx),
-                inner_text,
-                escape,
-                delimiters,
-                path,
-            );
+        ) (Allocator.Error || Writer.Error || StreamError)!PathResolution(void) {
+            _ = ctx;
+            _ = data_render;
+            _ = path;
+            _ = inner_text;
+            _ = escape;
+            _ = delimiters;
+
+            // CSV rows cannot have declared lambdas
+            return PathResolution(void).chain_broken;
         }
 
-        inline fn getData(ctx: *const anyopaque) Data {
-            return if (is_zero_size) undefined else (@ptrCast(*const Data, @alignCast(@alignOf(Data), ctx))).*;
+        fn getNode(depth: Depth, node: Node, path: Element.Path, index: ?usize) PathResolution(Node) {
+            if (path.len == 0) {
+                if (index) |current_index| {
+                    // Empty fields are the only way to express a missing value
+                    const truthy = node.column == null or node.field().len > 0;
+                    return if (truthy and current_index == 0) .{ .field = node } else .iterator_consumed;
+                } else {
+                    return .{ .field = node };
+                }
+            } else if (node.column == null) {
+                if (node.row.column(path[0].name)) |column| {
+                    return getNode(.Leaf, .{ .row = node.row, .column = column }, path[1..], index);
+                }
+            }
+
+            return if (depth == .Root) .not_found_in_context else .chain_broken;
+        }
+
+        inline fn getRoot(ctx: *const anyopaque) Node {
+            return (@ptrCast(*const Node, @alignCast(@alignOf(Node), ctx))).*;
         }
     };
 }
 
-fn JsonContextImpl(comptime Writer: type, comptime PartialsMap: type, comptime options: RenderOptions) type {
+fn JsonDocumentContextImpl(comptime Writer: type, comptime PartialsMap: type, comptime options: RenderOptions) type {
     const RenderEngine = rendering.RenderEngine(Writer, PartialsMap, options);
     const ContextInterface = RenderEngine.Context;
     const DataRender = RenderEngine.DataRender;
     const Depth = enum { Root, Leaf };
+    const Value = JsonDocument.Value;
 
     return struct {
         const vtable = ContextInterface.VTable{
@@ -366,34 +1484,25 @@ fn JsonContextImpl(comptime Writer: type, comptime PartialsMap: type, comptime o
             .expandLambda = expandLambda,
         };
 
-        const Self = @This();
-
-        pub fn context(json_value: json.Value) ContextInterface {
+        pub fn context(value: Value) ContextInterface {
             var interface = ContextInterface{
                 .vtable = &vtable,
                 .ctx = undefined,
             };
 
-            const Data = json.Value;
-            var ptr = @ptrCast(*Data, @alignCast(@alignOf(Data), &interface.ctx));
-            ptr.* = json_value;
+            var ptr = @ptrCast(*Value, @alignCast(@alignOf(Value), &interface.ctx));
+            ptr.* = value;
 
             return interface;
         }
 
         fn get(ctx: *const anyopaque, path: Element.Path, index: ?usize) PathResolution(ContextInterface) {
-            const root = getJsonRoot(ctx);
-            const value = getJsonValue(.Root, root, path, index);
-
-            return switch (value) {
+            return switch (getValue(.Root, getRoot(ctx), path, index)) {
                 .not_found_in_context => .not_found_in_context,
                 .chain_broken => .chain_broken,
                 .iterator_consumed => .iterator_consumed,
-                .field => |content| .{ .field = getContext(Writer, content, PartialsMap, options) },
-                .lambda => {
-                    assert(false);
-                    unreachable;
-                },
+                .field => |value| .{ .field = context(value) },
+                .lambda => unreachable,
             };
         }
 
@@ -402,26 +1511,20 @@ fn JsonContextImpl(comptime Writer: type, comptime PartialsMap: type, comptime o
             data_render: *DataRender,
             path: Element.Path,
         ) PathResolution(usize) {
-            const root = getJsonRoot(ctx);
-            const value = getJsonValue(.Root, root, path, null);
-
-            return switch (value) {
+            return switch (getValue(.Root, getRoot(ctx), path, null)) {
                 .not_found_in_context => .not_found_in_context,
                 .chain_broken => .chain_broken,
                 .iterator_consumed => .iterator_consumed,
-                .field => |content| switch (content) {
-                    .Bool => |boolean| return .{ .field = data_render.valueCapacityHint(boolean) },
-                    .Integer => |integer| return .{ .field = data_render.valueCapacityHint(integer) },
-                    .Float => |float| return .{ .field = data_render.valueCapacityHint(float) },
-                    .NumberString => |number_string| return .{ .field = data_render.valueCapacityHint(number_string) },
-                    .String => |string| return .{ .field = data_render.valueCapacityHint(string) },
-                    .Array => |array| return .{ .field = data_render.valueCapacityHint(array.items) },
-                    else => return .{ .field = 0 },
-                },
-                .lambda => {
-                    assert(false);
-                    unreachable;
+                .field => |value| .{
+                    .field = switch (value.kind()) {
+                        .Bool => data_render.valueCapacityHint(value.node().data.boolean),
+                        .Integer => data_render.valueCapacityHint(value.node().data.integer),
+                        .Float => data_render.valueCapacityHint(value.node().data.float),
+                        .NumberString, .String => data_render.valueCapacityHint(value.string()),
+                        .Null, .Array, .Object => 0,
+                    },
                 },
+                .lambda => unreachable,
             };
         }
 
@@ -430,27 +1533,19 @@ fn JsonContextImpl(comptime Writer: type, comptime PartialsMap: type, comptime o
             data_render: *DataRender,
             path: Element.Path,
             escape: Escape,
-        ) (Allocator.Error || Writer.Error)!PathResolution(void) {
-            const root = getJsonRoot(ctx);
-            const value = getJsonValue(.Root, root, path, null);
-
-            switch (value) {
+        ) (Allocator.Error || Writer.Error || StreamError)!PathResolution(void) {
+            switch (getValue(.Root, getRoot(ctx), path, null)) {
                 .not_found_in_context => return .not_found_in_context,
                 .chain_broken => return .chain_broken,
                 .iterator_consumed => return .iterator_consumed,
-                .field => |content| switch (content) {
-                    .Bool => |boolean| try data_render.write(boolean, escape),
-                    .Integer => |integer| try data_render.write(integer, escape),
-                    .Float => |float| try data_render.write(float, escape),
-                    .NumberString => |number_string| try data_render.write(number_string, escape),
-                    .String => |string| try data_render.write(string, escape),
-                    .Array => |array| try data_render.write(array.items, escape),
-                    else => {},
-                },
-                .lambda => {
-                    assert(false);
-                    unreachable;
+                .field => |value| switch (value.kind()) {
+                    .Bool => try data_render.write(value.node().data.boolean, escape),
+                    .Integer => try data_render.write(value.node().data.integer, escape),
+                    .Float => try data_render.write(value.node().data.float, escape),
+                    .NumberString, .String => try data_render.write(value.string(), escape),
+                    .Null, .Array, .Object => {},
                 },
+                .lambda => unreachable,
             }
 
             return .field;
@@ -463,7 +1558,7 @@ fn JsonContextImpl(comptime Writer: type, comptime PartialsMap: type, comptime o
             inner_text: []const u8,
             escape: Escape,
             delimiters: Delimiters,
-        ) (Allocator.Error || Writer.Error)!PathResolution(void) {
+        ) (Allocator.Error || Writer.Error || StreamError)!PathResolution(void) {
             _ = ctx;
             _ = data_render;
             _ = path;
@@ -475,46 +1570,35 @@ fn JsonContextImpl(comptime Writer: type, comptime PartialsMap: type, comptime o
             return PathResolution(void).chain_broken;
         }
 
-        fn getJsonValue(depth: Depth, value: json.Value, path: Element.Path, index: ?usize) PathResolution(json.Value) {
+        fn getValue(depth: Depth, value: Value, path: Element.Path, index: ?usize) PathResolution(Value) {
             if (path.len == 0) {
                 if (index) |current_index| {
-                    switch (value) {
-                        .Array => |array| if (array.items.len > current_index) {
-                            return .{ .field = array.items[current_index] };
+                    switch (value.kind()) {
+                        .Array => if (value.at(current_index)) |item| {
+                            return .{ .field = item };
                         },
-                        .Bool => |boolean| if (boolean == true and current_index == 0) {
+                        .Bool => if (value.node().data.boolean and current_index == 0) {
                             return .{ .field = value };
                         },
+                        .Null => {},
                         else => if (current_index == 0) {
                             return .{ .field = value };
                         },
-                        .Null => {},
                     }
 
                     return .iterator_consumed;
                 } else {
                     return .{ .field = value };
                 }
-            } else {
-                switch (value) {
-                    .Object => |obj| {
-                        const key = path[0];
-
-                        if (obj.get(key)) |next_value| {
-                            return getJsonValue(.Leaf, next_value, path[1..], index);
-                        }
-                    },
-
-                    else => {},
-                }
+            } else if (value.getHashed(path[0].name, path[0].hash)) |member| {
+                return getValue(.Leaf, member, path[1..], index);
             }
 
             return if (depth == .Root) .not_found_in_context else .chain_broken;
         }
 
-        inline fn getJsonRoot(ctx: *const anyopaque) json.Value {
-            const Data = json.Value;
-            return (@ptrCast(*const Data, @alignCast(@alignOf(Data), ctx))).*;
+        inline fn getRoot(ctx: *const anyopaque) Value {
+            return (@ptrCast(*const Value, @alignCast(@alignOf(Value), ctx))).*;
         }
     };
 }
@@ -522,7 +1606,13 @@ fn JsonContextImpl(comptime Writer: type, comptime PartialsMap: type, comptime o
 test {
     _ = invoker;
     _ = lambda;
+    _ = raw_json;
+    _ = json_document;
+    _ = msgpack;
+    _ = iterators;
+    _ = columns;
     _ = struct_tests;
+    _ = json_tests;
 }
 
 const struct_tests = struct {
@@ -1635,3 +2725,53 @@ const struct_tests = struct {
         }
     }
 };
+
+const json_tests = struct {
+    test "Object slot cache" {
+        const allocator = testing.allocator;
+        var slots = ObjectSlots{};
+
+        var parser = json.Parser.init(allocator, false);
+        defer parser.deinit();
+
+        var tree = try parser.parse(
+            \\[{"id": 1, "name": "a"}, {"id": 2, "name": "b"}, {"name": "c", "id": 3}, {"id": 4}]
+        );
+        defer tree.deinit();
+
+        const parts = [_]Element.PathPart{ Element.PathPart.init("name"), Element.PathPart.init("id") };
+        const items = tree.root.Array.items;
+
+        // Same shape, served from the hint
+        try testing.expectEqualStrings("a", slots.get(items[0].Object, &parts[0]).?.String);
+        try testing.expectEqualStrings("b", slots.get(items[1].Object, &parts[0]).?.String);
+
+        // Different key order, hint refreshed
+        try testing.expectEqualStrings("c", slots.get(items[2].Object, &parts[0]).?.String);
+        try testing.expectEqual(@as(i64, 3), slots.get(items[2].Object, &parts[1]).?.Integer);
+
+        // Hint out of bounds
+        try testing.expect(slots.get(items[3].Object, &parts[0]) == null);
+        try testing.expectEqual(@as(i64, 4), slots.get(items[3].Object, &parts[1]).?.Integer);
+    }
+
+    test "Object slot entries" {
+        var slots = ObjectSlots{};
+
+        // Hashes sharing a slot keep their own entries
+        const first = slots.find(1).?;
+        const second = slots.find(1 + ObjectSlots.len).?;
+        try testing.expect(first != second);
+        try testing.expect(slots.find(1).? == first);
+        try testing.expect(slots.find(1 + ObjectSlots.len).? == second);
+
+        // New hashes are not cached once the table is full
+        var hash: u32 = 2;
+        while (slots.used < ObjectSlots.max_used) : (hash += 1) {
+            _ = slots.find(hash).?;
+        }
+
+        try testing.expect(slots.find(hash) == null);
+        try testing.expect(slots.find(1).? == first);
+    }
+};
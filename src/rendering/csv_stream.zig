@@ -0,0 +1,417 @@
+const std = @import("std");
+const Allocator = std.mem.Allocator;
+const json = std.json;
+
+const testing = std.testing;
+
+const mustache = @import("../mustache.zig");
+const RenderOptions = mustache.options.RenderOptions;
+const RenderFromTemplateOptions = mustache.options.RenderFromTemplateOptions;
+const Template = mustache.Template;
+
+const rendering = @import("rendering.zig");
+const context = @import("context.zig");
+const map = @import("partials_map.zig");
+const json_stream = @import("json_stream.zig");
+
+pub const CsvStreamError = error{InvalidCsv};
+
+pub const CsvFormat = struct {
+    /// Use '\t' for TSV
+    delimiter: u8 = ',',
+    quote: u8 = '"',
+};
+
+/// A record, with its fields named by the header row
+pub const CsvRow = struct {
+    names: []const []const u8,
+    fields: []const []const u8,
+
+    /// Returns the index of the field named `name`.
+    /// Missing when the record is shorter than the header
+    pub fn column(self: CsvRow, name: []const u8) ?u32 {
+        for (self.names) |field_name, index| {
+            if (index >= self.fields.len) return null;
+            if (std.mem.eql(u8, field_name, name)) return @intCast(u32, index);
+        }
+
+        return null;
+    }
+};
+
+/// Renders the `Template` with the CSV rows read from `csv_reader` to a `writer`,
+/// without loading the whole file in memory.
+/// See `renderCsvStreamPartialsWithOptions`
+pub fn renderCsvStream(allocator: Allocator, template: Template, format: CsvFormat, csv_reader: anytype, writer: anytype) !void {
+    try renderCsvStreamPartialsWithOptions(allocator, template, {}, format, csv_reader, writer, .{});
+}
+
+/// Renders the `Template` with the CSV rows read from `csv_reader` to a `writer`,
+/// without loading the whole file in memory.
+/// `options` defines the behavior of the render process
+/// See `renderCsvStreamPartialsWithOptions`
+pub fn renderCsvStreamWithOptions(allocator: Allocator, template: Template, format: CsvFormat, csv_reader: anytype, writer: anytype, comptime options: RenderFromTemplateOptions) !void {
+    try renderCsvStreamPartialsWithOptions(allocator, template, {}, format, csv_reader, writer, options);
+}
+
+/// Renders the `Template` with the CSV rows read from `csv_reader` to a `writer`,
+/// without loading the whole file in memory.
+/// `partials` can be a tuple, an array, slice or a HashMap containing the partial's name as key and the `Template` as value
+/// See `renderCsvStreamPartialsWithOptions`
+pub fn renderCsvStreamPartials(allocator: Allocator, template: Template, partials: anytype, format: CsvFormat, csv_reader: anytype, writer: anytype) !void {
+    try renderCsvStreamPartialsWithOptions(allocator, template, partials, format, csv_reader, writer, .{});
+}
+
+/// Renders the `Template` with the CSV rows read from `csv_reader` to a `writer`,
+/// without loading the whole file in memory.
+///
+/// The first row is the header, naming the fields of the following rows.
+/// The first top-level section of the template, such as `{{#rows}}...{{/rows}}`, is rendered once per row,
+/// each row read, rendered and discarded one at a time, so memory use is bounded by the longest row.
+/// Fields are slices of the row's text, and empty fields evaluate as `false`.
+///
+/// Elements after the section only see whether there were any rows, by the section's name.
+///
+/// `partials` can be a tuple, an array, slice or a HashMap containing the partial's name as key and the `Template` as value
+/// `options` defines the behavior of the render process
+pub fn renderCsvStreamPartialsWithOptions(allocator: Allocator, template: Template, partials: anytype, format: CsvFormat, csv_reader: anytype, writer: anytype, comptime options: RenderFromTemplateOptions) !void {
+    const render_options = RenderOptions{ .template = options };
+    const PartialsMap = map.PartialsMap(@TypeOf(partials), render_options);
+    const Render = CsvStreamRender(@TypeOf(writer), PartialsMap, render_options);
+
+    var buffered = std.io.bufferedReader(csv_reader);
+    try Render.render(allocator, template, PartialsMap.init(partials), format, buffered.reader(), writer);
+}
+
+fn CsvStreamRender(comptime Writer: type, comptime PartialsMap: type, comptime options: RenderOptions) type {
+    const Engine = rendering.RenderEngine(Writer, PartialsMap, options);
+    const ContextStack = Engine.ContextStack;
+    const DataRender = Engine.DataRender;
+
+    return struct {
+        fn render(allocator: Allocator, template: Template, partials_map: PartialsMap, format: CsvFormat, reader: anytype, writer: Writer) !void {
+            var rows = RowReader(@TypeOf(reader)).init(allocator, reader, format);
+            defer rows.deinit();
+
+            var header = std.heap.ArenaAllocator.init(allocator);
+            defer header.deinit();
+
+            // The header's text is overwritten by the next row
+            const names: []const []const u8 = if (try rows.next()) |fields| names: {
+                const copy = try header.allocator().alloc([]const u8, fields.len);
+                for (fields) |field, index| copy[index] = try header.allocator().dupe(u8, field);
+                break :names copy;
+            } else &[0][]const u8{};
+
+            // Holds only the streamed section's name, once the rows were rendered
+            var root = json.ObjectMap.init(allocator);
+            defer root.deinit();
+
+            var root_stack = ContextStack{
+                .parent = null,
+                .ctx = context.getContext(Writer, json.Value{ .Object = root }, PartialsMap, options),
+            };
+
+            var indentation_queue = Engine.IndentationQueue{};
+            var data_render = DataRender{
+                .out_writer = .{ .writer = writer },
+                .partials_map = partials_map,
+                .stack = &root_stack,
+                .indentation_queue = &indentation_queue,
+                .template_options = template.options,
+            };
+
+            const section = json_stream.findStreamedSection(template.elements) orelse {
+                return try data_render.render(template.elements);
+            };
+
+            try data_render.render(template.elements[0..section.index]);
+
+            const children_start = section.index + 1;
+            const else_start = children_start + section.element.children_count;
+            const else_end = else_start + section.element.else_count;
+
+            var count: usize = 0;
+            while (try rows.next()) |fields| : (count += 1) {
+                const row = CsvRow{ .names = names, .fields = fields };
+
+                data_render.stack = &ContextStack{
+                    .parent = &root_stack,
+                    .ctx = context.getContext(Writer, &row, PartialsMap, options),
+                };
+                defer data_render.stack = &root_stack;
+
+                try data_render.render(template.elements[children_start..else_start]);
+            }
+
+            if (count == 0) {
+                try data_render.render(template.elements[else_start..else_end]);
+            }
+
+            try root.put(section.element.path[0].name, .{ .Bool = count > 0 });
+            root_stack.ctx = context.getContext(Writer, json.Value{ .Object = root }, PartialsMap, options);
+
+            try data_render.render(template.elements[else_end..]);
+        }
+    };
+}
+
+/// Reads CSV records from a stream, one at a time.
+/// Quoted fields may contain delimiters, line breaks and doubled quotes,
+/// line breaks may be either "\n" or "\r\n", and blank lines are skipped.
+pub fn RowReader(comptime Reader: type) type {
+    return struct {
+        const Self = @This();
+        pub const Error = Reader.Error || Allocator.Error || CsvStreamError;
+
+        reader: Reader,
+        format: CsvFormat,
+
+        /// Unquoted content of the current record
+        text: std.ArrayList(u8),
+
+        /// End of each field in `text`
+        ends: std.ArrayList(usize),
+
+        fields: std.ArrayList([]const u8),
+
+        /// The current record has a quoted field, so it is not blank even if empty
+        has_quote: bool = false,
+
+        pub fn init(allocator: Allocator, reader: Reader, format: CsvFormat) Self {
+            return .{
+                .reader = reader,
+                .format = format,
+                .text = std.ArrayList(u8).init(allocator),
+                .ends = std.ArrayList(usize).init(allocator),
+                .fields = std.ArrayList([]const u8).init(allocator),
+            };
+        }
+
+        pub fn deinit(self: *Self) void {
+            self.text.deinit();
+            self.ends.deinit();
+            self.fields.deinit();
+        }
+
+        /// Returns the fields of the next record, valid until the next call
+        pub fn next(self: *Self) Error!?[]const []const u8 {
+            while (try self.readRecord()) {
+                if (self.text.items.len == 0 and self.ends.items.len == 1 and !self.has_quote) continue;
+
+                self.fields.clearRetainingCapacity();
+                try self.fields.ensureTotalCapacity(self.ends.items.len);
+
+                var start: usize = 0;
+                for (self.ends.items) |end| {
+                    self.fields.appendAssumeCapacity(self.text.items[start..end]);
+                    start = end;
+                }
+
+                return self.fields.items;
+            }
+
+            return null;
+        }
+
+        /// Returns false at the end of the stream
+        fn readRecord(self: *Self) Error!bool {
+            self.text.clearRetainingCapacity();
+            self.ends.clearRetainingCapacity();
+            self.has_quote = false;
+
+            var field_start: usize = 0;
+            var quoted = false;
+
+            // A quote just closed, a second one is an escaped quote
+            var closed_quote = false;
+
+            var read_any = false;
+            while (true) {
+                const char = self.reader.readByte() catch |err| switch (err) {
+                    error.EndOfStream => {
+                        if (quoted) return error.InvalidCsv;
+                        if (!read_any) return false;
+                        break;
+                    },
+                    else => |read_error| return read_error,
+                };
+                read_any = true;
+
+                if (quoted) {
+                    if (char == self.format.quote) {
+                        quoted = false;
+                        closed_quote = true;
+                    } else {
+                        try self.text.append(char);
+                    }
+
+                    continue;
+                }
+
+                if (char == self.format.quote) {
+                    if (closed_quote) {
+                        try self.text.append(char);
+                        quoted = true;
+                        closed_quote = false;
+                        continue;
+                    } else if (self.text.items.len == field_start) {
+                        quoted = true;
+                        self.has_quote = true;
+                        continue;
+                    }
+                }
+
+                closed_quote = false;
+                if (char == self.format.delimiter) {
+                    try self.ends.append(self.text.items.len);
+                    field_start = self.text.items.len;
+                } else if (char == '\n') {
+                    break;
+                } else if (char != '\r') {
+                    try self.text.append(char);
+                }
+            }
+
+            try self.ends.append(self.text.items.len);
+            return true;
+        }
+    };
+}
+
+test {
+    _ = tests;
+}
+
+const tests = struct {
+    const template_text =
+        \\<h1>{{title}}</h1>
+        \\{{#rows}}
+        \\<p>{{id}}: {{name}}{{#note}} ({{note}}){{/note}}</p>
+        \\{{/rows}}
+        \\{{^rows}}
+        \\<p>None</p>
+        \\{{/rows}}
+        \\{{#rows}}Had rows{{/rows}}
+    ;
+
+    fn expectStreamRender(format: CsvFormat, csv_text: []const u8, expected: []const u8) !void {
+        const allocator = testing.allocator;
+
+        var template = (try mustache.parseText(allocator, template_text, .{}, .{ .copy_strings = false })).success;
+        defer template.deinit(allocator);
+
+        var result = std.ArrayList(u8).init(allocator);
+        defer result.deinit();
+
+        var stream = std.io.fixedBufferStream(csv_text);
+        try renderCsvStream(allocator, template, format, stream.reader(), result.writer());
+
+        try testing.expectEqualStrings(expected, result.items);
+    }
+
+    test "Stream rows" {
+        try expectStreamRender(.{},
+            \\id,name,note
+            \\1,a,
+            \\2,<b>,ok
+            \\
+        ,
+            \\<h1></h1>
+            \\<p>1: a</p>
+            \\<p>2: &lt;b&gt; (ok)</p>
+            \\Had rows
+        );
+    }
+
+    test "TSV" {
+        try expectStreamRender(.{ .delimiter = '\t' }, "id\tname\r\n1\ta,b\r\n\r\n2\tc",
+            \\<h1></h1>
+            \\<p>1: a,b</p>
+            \\<p>2: c</p>
+            \\Had rows
+        );
+    }
+
+    test "Quoted fields" {
+        try expectStreamRender(.{},
+            \\"id",name,note
+            \\1,"a, ""quoted""
+            \\line",""
+            \\2,b
+        ,
+            \\<h1></h1>
+            \\<p>1: a, &quot;quoted&quot;
+            \\line</p>
+            \\<p>2: b</p>
+            \\Had rows
+        );
+    }
+
+    test "Header only" {
+        try expectStreamRender(.{}, "id,name\n",
+            \\<h1></h1>
+            \\<p>None</p>
+            \\
+        );
+    }
+
+    test "Row reader" {
+        var stream = std.io.fixedBufferStream("a,,\"b\"\"\",c\n\n\"\"\n");
+        var rows = RowReader(@TypeOf(stream.reader())).init(testing.allocator, stream.reader(), .{});
+        defer rows.deinit();
+
+        const fields = (try rows.next()).?;
+        try testing.expectEqual(@as(usize, 4), fields.len);
+        try testing.expectEqualStrings("a", fields[0]);
+        try testing.expectEqualStrings("", fields[1]);
+        try testing.expectEqualStrings("b\"", fields[2]);
+        try testing.expectEqualStrings("c", fields[3]);
+
+        // The blank line is skipped, a single empty quoted field is a record
+        const empty = (try rows.next()).?;
+        try testing.expectEqual(@as(usize, 1), empty.len);
+        try testing.expectEqualStrings("", empty[0]);
+
+        try testing.expect((try rows.next()) == null);
+    }
+
+    test "Many rows" {
+        const allocator = testing.allocator;
+
+        var template = (try mustache.parseText(allocator, "{{#rows}}{{id}},{{/rows}}", .{}, .{ .copy_strings = false })).success;
+        defer template.deinit(allocator);
+
+        var csv_text = std.ArrayList(u8).init(allocator);
+        defer csv_text.deinit();
+
+        var expected = std.ArrayList(u8).init(allocator);
+        defer expected.deinit();
+
+        try csv_text.appendSlice("id\n");
+
+        var index: usize = 0;
+        while (index < 10_000) : (index += 1) {
+            try csv_text.writer().print("{d}\n", .{index});
+            try expected.writer().print("{d},", .{index});
+        }
+
+        var result = std.ArrayList(u8).init(allocator);
+        defer result.deinit();
+
+        var stream = std.io.fixedBufferStream(csv_text.items);
+        try renderCsvStream(allocator, template, .{}, stream.reader(), result.writer());
+
+        try testing.expectEqualStrings(expected.items, result.items);
+    }
+
+    test "Invalid CSV" {
+        const allocator = testing.allocator;
+
+        var template = (try mustache.parseText(allocator, "{{#rows}}{{id}}{{/rows}}", .{}, .{ .copy_strings = false })).success;
+        defer template.deinit(allocator);
+
+        var stream = std.io.fixedBufferStream("id\n\"1\n");
+        try testing.expectError(error.InvalidCsv, renderCsvStream(allocator, template, .{}, stream.reader(), std.io.null_writer));
+    }
+};
@@ -0,0 +1,242 @@
+const std = @import("std");
+const Allocator = std.mem.Allocator;
+const Wyhash = std.hash.Wyhash;
+
+const testing = std.testing;
+
+const mustache = @import("../mustache.zig");
+const EscapeCacheLimits = mustache.options.EscapeCacheLimits;
+const RenderFromTemplateOptions = mustache.options.RenderFromTemplateOptions;
+const Template = mustache.Template;
+const StreamError = mustache.StreamError;
+
+const rendering = @import("rendering.zig");
+
+pub const EscapeCacheStats = struct {
+    hits: u64 = 0,
+    misses: u64 = 0,
+    evictions: u64 = 0,
+
+    /// Fraction of the lookups served from the cache
+    pub fn hitRate(self: EscapeCacheStats) f64 {
+        const lookups = self.hits + self.misses;
+        return if (lookups == 0) 0 else @intToFloat(f64, self.hits) / @intToFloat(f64, lookups);
+    }
+};
+
+/// Keeps the HTML-escaped form of string values across renders,
+/// so a value interpolated over and over is escaped once and then copied as-is.
+/// Values are keyed by a hash of their content and compared against a copy of the original bytes,
+/// so equal values built fresh for each render share the same entry, and a value is never served stale.
+/// Each value maps to a single slot, a new value evicts the previous one.
+///
+/// Pass the cache to the render functions declared here, such as `allocRender`.
+/// Use one instance per thread.
+pub const EscapeCache = struct {
+    const Self = @This();
+
+    const Entry = struct {
+        hash: u64 = 0,
+        source_len: usize = 0,
+
+        /// Copy of the source value followed by its escaped form
+        buffer: []u8 = &.{},
+
+        fn source(self: *const Entry) []const u8 {
+            return self.buffer[0..self.source_len];
+        }
+
+        fn escaped(self: *const Entry) []const u8 {
+            return self.buffer[self.source_len..];
+        }
+    };
+
+    allocator: Allocator,
+    limits: EscapeCacheLimits,
+    entries: []Entry,
+    stats: EscapeCacheStats = .{},
+
+    pub fn init(allocator: Allocator, limits: EscapeCacheLimits) Allocator.Error!Self {
+        var entries = try allocator.alloc(Entry, std.math.max(limits.max_entries, 1));
+        std.mem.set(Entry, entries, .{});
+
+        return Self{
+            .allocator = allocator,
+            .limits = limits,
+            .entries = entries,
+        };
+    }
+
+    pub fn deinit(self: *Self) void {
+        for (self.entries) |entry| self.allocator.free(entry.buffer);
+        self.allocator.free(self.entries);
+    }
+
+    /// Renders the `Template` with the given `data` to a `writer`, looking up escaped strings in this cache
+    pub fn render(self: *Self, template: Template, data: anytype, writer: anytype) !void {
+        try self.renderPartialsWithOptions(template, {}, data, writer, .{});
+    }
+
+    /// Renders the `Template` with the given `data` to a `writer`, looking up escaped strings in this cache
+    /// `partials` can be a tuple, an array, slice or a HashMap containing the partial's name as key and the `Template` as value
+    /// `options` defines the behavior of the render process
+    pub fn renderPartialsWithOptions(self: *Self, template: Template, partials: anytype, data: anytype, writer: anytype, comptime options: RenderFromTemplateOptions) !void {
+        try rendering.renderWithEscapeCache(self, template, partials, data, writer, options);
+    }
+
+    /// Renders the `Template` with the given `data`, looking up escaped strings in this cache.
+    /// Returns an owned slice with the content, caller must free the memory
+    pub fn allocRender(self: *Self, allocator: Allocator, template: Template, data: anytype) (Allocator.Error || StreamError)![]const u8 {
+        return try self.allocRenderPartialsWithOptions(allocator, template, {}, data, .{});
+    }
+
+    /// Renders the `Template` with the given `data`, looking up escaped strings in this cache.
+    /// `partials` can be a tuple, an array, slice or a HashMap containing the partial's name as key and the `Template` as value
+    /// `options` defines the behavior of the render process
+    /// Returns an owned slice with the content, caller must free the memory
+    pub fn allocRenderPartialsWithOptions(self: *Self, allocator: Allocator, template: Template, partials: anytype, data: anytype, comptime options: RenderFromTemplateOptions) (Allocator.Error || StreamError)![]const u8 {
+        return try rendering.allocRenderWithEscapeCache(self, allocator, template, partials, data, options);
+    }
+
+    /// Returns the escaped form of `value`, escaping and storing it on a miss.
+    /// Returns null for values outside the size limits, or if there is no memory to store it
+    pub fn fetch(self: *Self, value: []const u8) ?[]const u8 {
+        if (value.len < self.limits.min_len or value.len > self.limits.max_len) return null;
+
+        const hash = Wyhash.hash(0, value);
+        const entry = &self.entries[hash % self.entries.len];
+
+        if (entry.hash == hash and std.mem.eql(u8, entry.source(), value)) {
+            self.stats.hits += 1;
+            return entry.escaped();
+        }
+
+        self.stats.misses += 1;
+
+        var buffer = self.allocator.alloc(u8, value.len + escapedLen(value)) catch return null;
+        std.mem.copy(u8, buffer, value);
+        escape(value, buffer[value.len..]);
+
+        if (entry.buffer.len > 0) {
+            self.allocator.free(entry.buffer);
+            self.stats.evictions += 1;
+        }
+
+        entry.* = .{
+            .hash = hash,
+            .source_len = value.len,
+            .buffer = buffer,
+        };
+
+        return entry.escaped();
+    }
+
+    fn escapedLen(value: []const u8) usize {
+        var len: usize = value.len;
+        for (value) |char| {
+            len += switch (char) {
+                '<', '>' => "&lt;".len - 1,
+                '&' => "&amp;".len - 1,
+                '"' => "&quot;".len - 1,
+                else => 0,
+            };
+        }
+
+        return len;
+    }
+
+    fn escape(value: []const u8, buffer: []u8) void {
+        var index: usize = 0;
+        for (value) |char| {
+            const replace = switch (char) {
+                '<' => "&lt;",
+                '>' => "&gt;",
+                '&' => "&amp;",
+                '"' => "&quot;",
+                else => {
+                    buffer[index] = char;
+                    index += 1;
+                    continue;
+                },
+            };
+
+            std.mem.copy(u8, buffer[index..], replace);
+            index += replace.len;
+        }
+    }
+};
+
+test {
+    _ = tests;
+}
+
+const tests = struct {
+    test "Fetch" {
+        var cache = try EscapeCache.init(testing.allocator, .{ .max_entries = 1, .min_len = 4 });
+        defer cache.deinit();
+
+        const value = "<a href=\"#\">";
+        try testing.expectEqualStrings("&lt;a href=&quot;#&quot;&gt;", cache.fetch(value).?);
+        try testing.expectEqualStrings("&lt;a href=&quot;#&quot;&gt;", cache.fetch(value).?);
+
+        // Below the threshold
+        try testing.expect(cache.fetch("<a>") == null);
+
+        // Same address with a different content
+        var buffer = "a & b".*;
+        try testing.expectEqualStrings("a &amp; b", cache.fetch(&buffer).?);
+        buffer[2] = '<';
+        try testing.expectEqualStrings("a &lt; b", cache.fetch(&buffer).?);
+
+        // Same content at a different address
+        var copy = "a < b".*;
+        try testing.expectEqualStrings("a &lt; b", cache.fetch(&copy).?);
+
+        try testing.expectEqual(@as(u64, 2), cache.stats.hits);
+        try testing.expectEqual(@as(u64, 3), cache.stats.misses);
+        try testing.expectEqual(@as(u64, 2), cache.stats.evictions);
+        try testing.expectApproxEqAbs(@as(f64, 0.4), cache.stats.hitRate(), 0.001);
+    }
+
+    test "Render" {
+        const allocator = testing.allocator;
+
+        var cache = try EscapeCache.init(allocator, .{ .min_len = 8 });
+        defer cache.deinit();
+
+        var template = (try mustache.parseText(allocator, "{{name}}|{{{name}}}|{{short}}", .{}, .{ .copy_strings = false })).success;
+        defer template.deinit(allocator);
+
+        const expected = "Fish &amp; Chips &quot;deluxe&quot;|Fish & Chips \"deluxe\"|&lt;b&gt;";
+
+        var count: usize = 0;
+        while (count < 3) : (count += 1) {
+
+            // Values built fresh for each render
+            const name = try allocator.dupe(u8, "Fish & Chips \"deluxe\"");
+            defer allocator.free(name);
+
+            const data = .{ .name = @as([]const u8, name), .short = @as([]const u8, "<b>") };
+
+            const result = try cache.allocRender(allocator, template, data);
+            defer allocator.free(result);
+
+            try testing.expectEqualStrings(expected, result);
+        }
+
+        var list = std.ArrayList(u8).init(allocator);
+        defer list.deinit();
+
+        try cache.render(template, .{ .name = @as([]const u8, "Fish & Chips \"deluxe\""), .short = @as([]const u8, "") }, list.writer());
+        try testing.expectEqualStrings("Fish &amp; Chips &quot;deluxe&quot;|Fish & Chips \"deluxe\"|", list.items);
+
+        // Unescaped and short values are not cached
+        try testing.expectEqual(@as(u64, 3), cache.stats.hits);
+        try testing.expectEqual(@as(u64, 1), cache.stats.misses);
+
+        // Renders without the cache don't touch it
+        const result = try mustache.allocRender(allocator, template, .{ .name = @as([]const u8, "Fish & Chips \"deluxe\""), .short = @as([]const u8, "") });
+        defer allocator.free(result);
+        try testing.expectEqual(@as(u64, 3), cache.stats.hits);
+    }
+};
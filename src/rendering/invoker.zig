@@ -11,6 +11,7 @@ const Delimiters = mustache.Delimiters;
 const context = @import("context.zig");
 const PathResolution = context.PathResolution;
 const Escape = context.Escape;
+const StreamError = context.StreamError;
 
 const rendering = @import("rendering.zig");
 const map = @import("partials_map.zig");
@@ -19,6 +20,9 @@ const lambda = @import("lambda.zig");
 const LambdaContext = lambda.LambdaContext;
 const LambdaInvoker = lambda.LambdaInvoker;
 
+const iterators = @import("iterators.zig");
+const columns = @import("columns.zig");
+
 const testing = std.testing;
 const assert = std.debug.assert;
 
@@ -66,7 +70,7 @@ pub fn Invoker(comptime Writer: type, comptime PartialsMap: type, comptime optio
                         return Result{ .lambda = try action_fn(action_param, ctx) };
                     } else {
                         if (path.len > 0) {
-                            return try recursiveFind(depth, Data, action_param, ctx, path[0], path[1..], index);
+                            return try recursiveFind(depth, Data, action_param, ctx, path[0].name, path[1..], index);
                         } else if (index) |current_index| {
                             return try iterateAt(Data, action_param, ctx, current_index);
                         } else {
@@ -218,6 +222,28 @@ pub fn Invoker(comptime Writer: type, comptime PartialsMap: type, comptime optio
                                 } else {
                                     return .iterator_consumed;
                                 }
+                            } else if (comptime columns.ElemOf(TValue) != null) {
+                                // Items read their fields from the columns by index, without building the rows.
+                                // The items keep a pointer to the container, a copy would not outlive this call
+                                if (comptime !trait.isSingleItemPtr(@TypeOf(data))) @compileError(
+                                    "Expected a pointer to " ++ @typeName(TValue) ++ ", optional struct-of-arrays containers are not supported",
+                                );
+
+                                if (index >= data.len) return .iterator_consumed;
+
+                                var item = columns.ColumnItem(TValue){ .container = data, .index = index };
+                                return Result{ .field = try action_fn(action_param, &item) };
+                            } else if (comptime iterators.ItemOf(TValue) != null) {
+                                // Iterators reached through a mutable pointer are advanced in place,
+                                // otherwise a copy is iterated, leaving the data untouched
+                                const Data = @TypeOf(data);
+                                if (comptime trait.isSingleItemPtr(Data) and !trait.isConstPtr(Data)) {
+                                    return try iterateCursor(iterators.Cursor(Data), action_param, data, index);
+                                } else {
+                                    return try iterateCursor(iterators.Cursor(TValue), action_param, if (comptime trait.isSingleItemPtr(Data)) data.* else data, index);
+                                }
+                            } else if (comptime iterators.IteratorOf(TValue)) |Iterator| {
+                                return try iterateCursor(iterators.Cursor(Iterator), action_param, data.iterator(), index);
                             }
                         },
 
@@ -278,6 +304,24 @@ pub fn Invoker(comptime Writer: type, comptime PartialsMap: type, comptime optio
                     else
                         .iterator_consumed;
                 }
+
+                /// Iterators are walked forward from the first item,
+                /// the engine fetches the following items through the cursor's context instead of by index
+                fn iterateCursor(
+                    comptime Cursor: type,
+                    action_param: anytype,
+                    state: Cursor.State,
+                    index: usize,
+                ) TError!Result {
+                    var cursor = Cursor.first(state) orelse return .iterator_consumed;
+
+                    var current: usize = 0;
+                    while (current < index) : (current += 1) {
+                        cursor = cursor.following() orelse return .iterator_consumed;
+                    }
+
+                    return Result{ .field = try action_fn(action_param, &cursor) };
+                }
             };
         }
 
@@ -300,8 +344,8 @@ pub fn Invoker(comptime Writer: type, comptime PartialsMap: type, comptime optio
             data: anytype,
             path: Element.Path,
             escape: Escape,
-        ) (Allocator.Error || Writer.Error)!PathResolution(void) {
-            const Interpolate = PathInvoker(Allocator.Error || Writer.Error, void, interpolateAction);
+        ) (Allocator.Error || Writer.Error || StreamError)!PathResolution(void) {
+            const Interpolate = PathInvoker(Allocator.Error || Writer.Error || StreamError, void, interpolateAction);
             return try Interpolate.call(
                 .{ data_render, escape },
                 data,
@@ -331,8 +375,8 @@ pub fn Invoker(comptime Writer: type, comptime PartialsMap: type, comptime optio
             escape: Escape,
             delimiters: Delimiters,
             path: Element.Path,
-        ) (Allocator.Error || Writer.Error)!PathResolution(void) {
-            const ExpandLambdaAction = PathInvoker(Allocator.Error || Writer.Error, void, expandLambdaAction);
+        ) (Allocator.Error || Writer.Error || StreamError)!PathResolution(void) {
+            const ExpandLambdaAction = PathInvoker(Allocator.Error || Writer.Error || StreamError, void, expandLambdaAction);
             return try ExpandLambdaAction.call(
                 .{ data_render, inner_text, escape, delimiters },
                 data,
@@ -349,7 +393,7 @@ pub fn Invoker(comptime Writer: type, comptime PartialsMap: type, comptime optio
         fn interpolateAction(
             params: anytype,
             value: anytype,
-        ) (Allocator.Error || Writer.Error)!void {
+        ) (Allocator.Error || Writer.Error || StreamError)!void {
             if (comptime !std.meta.trait.isTuple(@TypeOf(params)) and params.len != 2) @compileError("Incorrect params " ++ @typeName(@TypeOf(params)));
 
             var data_render: *DataRender = params.@"0";
@@ -367,11 +411,11 @@ pub fn Invoker(comptime Writer: type, comptime PartialsMap: type, comptime optio
         fn expandLambdaAction(
             params: anytype,
             value: anytype,
-        ) (Allocator.Error || Writer.Error)!void {
+        ) (Allocator.Error || Writer.Error || StreamError)!void {
             if (comptime !std.meta.trait.isTuple(@TypeOf(params)) and params.len != 4) @compileError("Incorrect params " ++ @typeName(@TypeOf(params)));
             if (comptime !lambda.isLambdaInvoker(@TypeOf(value))) return;
 
-            const Error = Allocator.Error || Writer.Error;
+            const Error = Allocator.Error || Writer.Error || StreamError;
 
             const data_render: *DataRender = params.@"0";
             const inner_text: []const u8 = params.@"1";
@@ -0,0 +1,276 @@
+const std = @import("std");
+const meta = std.meta;
+const trait = std.meta.trait;
+
+const testing = std.testing;
+
+const mustache = @import("../mustache.zig");
+
+/// Returns the type of the items produced by an iterator declaring `pub fn next(self: *T) ?Item`,
+/// or null if `T` is not an iterator
+pub fn ItemOf(comptime T: type) ?type {
+    comptime {
+        if (!trait.hasFn("next")(T)) return null;
+
+        const info = @typeInfo(@TypeOf(T.next)).Fn;
+        if (info.args.len != 1) return null;
+
+        const Self = info.args[0].arg_type orelse return null;
+        if (Self != *T) return null;
+
+        const Return = info.return_type orelse return null;
+        return if (@typeInfo(Return) == .Optional) meta.Child(Return) else null;
+    }
+}
+
+/// Returns the iterator type returned by `pub fn iterator(self: T) I` or `pub fn iterator(self: *const T) I`,
+/// or null if `T` doesn't declare such a method
+pub fn IteratorOf(comptime T: type) ?type {
+    comptime {
+        if (!trait.hasFn("iterator")(T)) return null;
+
+        const info = @typeInfo(@TypeOf(T.iterator)).Fn;
+        if (info.args.len != 1) return null;
+
+        const Self = info.args[0].arg_type orelse return null;
+        if (Self != T and Self != *const T) return null;
+
+        const Iterator = info.return_type orelse return null;
+        return if (ItemOf(Iterator) != null) Iterator else null;
+    }
+}
+
+pub fn isIterable(comptime T: type) bool {
+    return ItemOf(T) != null or IteratorOf(T) != null;
+}
+
+/// Returns true if `T` is iterable, or a pointer or optional to an iterable.
+/// Such sources can only be walked forward, and walking them may have side effects
+pub fn isForwardOnly(comptime T: type) bool {
+    return switch (@typeInfo(T)) {
+        .Pointer => |info| info.size == .One and isForwardOnly(info.child),
+        .Optional => |info| isForwardOnly(info.child),
+        else => isIterable(T),
+    };
+}
+
+/// Returns true if the iterable produces at least one item.
+/// Only a copy of the iterator is advanced, iterators referenced by a mutable pointer are left untouched
+pub fn peek(value: anytype) bool {
+    const T = @TypeOf(value);
+
+    switch (@typeInfo(T)) {
+        .Pointer => return peek(value.*),
+        .Optional => return if (value) |not_null| peek(not_null) else false,
+        else => {
+            if (comptime ItemOf(T) != null) {
+                var copy = value;
+                return copy.next() != null;
+            } else {
+                var iterator = value.iterator();
+                return iterator.next() != null;
+            }
+        },
+    }
+}
+
+/// Tags the `Cursor` types
+const CursorMarker = opaque {};
+
+/// An item produced by an iterator, along with the iterator's state to produce the following ones.
+/// `State` is either a pointer to the iterator, advanced in place, or a copy of it.
+pub fn Cursor(comptime IteratorState: type) type {
+    const Iterator = if (trait.isSingleItemPtr(IteratorState)) meta.Child(IteratorState) else IteratorState;
+
+    return struct {
+        const Self = @This();
+
+        pub const Marker = CursorMarker;
+        pub const State = IteratorState;
+        pub const Item = ItemOf(Iterator).?;
+
+        state: State,
+        item: Item,
+
+        pub fn first(state: State) ?Self {
+            return fetch(state);
+        }
+
+        /// Returns the cursor of the following item, leaving this one untouched if the state is a copy
+        pub fn following(self: *const Self) ?Self {
+            return fetch(self.state);
+        }
+
+        fn fetch(state: State) ?Self {
+            var current = state;
+            const item = current.next() orelse return null;
+
+            return Self{
+                .state = current,
+                .item = item,
+            };
+        }
+    };
+}
+
+pub fn isCursor(comptime T: type) bool {
+    return @typeInfo(T) == .Struct and @hasDecl(T, "Marker") and @TypeOf(T.Marker) == type and T.Marker == CursorMarker;
+}
+
+test {
+    _ = tests;
+}
+
+const tests = struct {
+    /// Produces the numbers from `from` up to `to`
+    const Range = struct {
+        from: u32,
+        to: u32,
+
+        pub fn next(self: *Range) ?u32 {
+            if (self.from > self.to) return null;
+
+            defer self.from += 1;
+            return self.from;
+        }
+    };
+
+    const Person = struct {
+        name: []const u8,
+        age: u32,
+    };
+
+    /// Returns items by value, larger than a pointer
+    const People = struct {
+        names: []const []const u8,
+        index: usize = 0,
+
+        pub fn next(self: *People) ?Person {
+            if (self.index >= self.names.len) return null;
+
+            defer self.index += 1;
+            return Person{ .name = self.names[self.index], .age = @intCast(u32, self.index) + 20 };
+        }
+    };
+
+    /// Not an iterator itself, but returns one
+    const Team = struct {
+        names: []const []const u8,
+
+        pub fn iterator(self: Team) People {
+            return .{ .names = self.names };
+        }
+    };
+
+    test "Iterator types" {
+        try testing.expect(ItemOf(Range).? == u32);
+        try testing.expect(ItemOf(People).? == Person);
+        try testing.expect(ItemOf(Team) == null);
+        try testing.expect(ItemOf(Person) == null);
+        try testing.expect(IteratorOf(Team).? == People);
+        try testing.expect(IteratorOf(Range) == null);
+
+        try testing.expect(isForwardOnly(Range));
+        try testing.expect(isForwardOnly(*const ?Team));
+        try testing.expect(!isForwardOnly(Person));
+        try testing.expect(!isForwardOnly([]const Range));
+
+        try testing.expect(isCursor(Cursor(Range)));
+        try testing.expect(isCursor(Cursor(*Range)));
+        try testing.expect(!isCursor(Range));
+    }
+
+    fn expectRender(template_text: []const u8, data: anytype, expected: []const u8) !void {
+        const allocator = testing.allocator;
+
+        var template = (try mustache.parseText(allocator, template_text, .{}, .{ .copy_strings = false })).success;
+        defer template.deinit(allocator);
+
+        const result = try mustache.allocRender(allocator, template, data);
+        defer allocator.free(result);
+
+        try testing.expectEqualStrings(expected, result);
+    }
+
+    /// Renders into a writer, skipping the capacity hint pass `allocRender` runs
+    fn expectWriterRender(template_text: []const u8, data: anytype, expected: []const u8) !void {
+        const allocator = testing.allocator;
+
+        var template = (try mustache.parseText(allocator, template_text, .{}, .{ .copy_strings = false })).success;
+        defer template.deinit(allocator);
+
+        var list = std.ArrayList(u8).init(allocator);
+        defer list.deinit();
+
+        try mustache.render(template, data, list.writer());
+        try testing.expectEqualStrings(expected, list.items);
+    }
+
+    test "Render" {
+        const Data = struct {
+            range: Range,
+            empty: Range,
+        };
+
+        const data = Data{
+            .range = .{ .from = 1, .to = 3 },
+            .empty = .{ .from = 1, .to = 0 },
+        };
+
+        // Iterators reached through a const pointer are copied, so they can be iterated again
+        try expectRender("{{#range}}{{.}},{{/range}}{{#range}}{{.}};{{/range}}", data, "1,2,3,1;2;3;");
+        try expectRender("{{#empty}}{{.}}{{/empty}}{{^empty}}none{{/empty}}", data, "none");
+        try expectRender("{{^range}}none{{/range}}", data, "");
+    }
+
+    test "Items by value" {
+        const names = [_][]const u8{ "Ana", "Bob" };
+
+        const Data = struct {
+            title: []const u8,
+            people: People,
+            team: Team,
+        };
+
+        const data = Data{
+            .title = "Team",
+            .people = .{ .names = &names },
+            .team = .{ .names = &names },
+        };
+
+        const template_text = "{{#people}}{{name}} ({{age}}) of {{title}}; {{/people}}";
+        try expectRender(template_text, data, "Ana (20) of Team; Bob (21) of Team; ");
+        try expectRender("{{#team}}{{name}},{{/team}}", data, "Ana,Bob,");
+    }
+
+    test "Advanced in place" {
+        const Data = struct {
+            range: *Range,
+        };
+
+        const template_text = "{{^range}}none{{/range}}{{#range}}{{.}},{{/range}}{{#range}}{{.}};{{/range}}{{^range}}none{{/range}}";
+
+        // The pointed iterator is consumed by the first section only,
+        // neither the capacity hint pass nor the inverted sections fetch from it
+        var range = Range{ .from = 1, .to = 3 };
+        try expectRender(template_text, Data{ .range = &range }, "1,2,3,none");
+        try testing.expect(range.next() == null);
+
+        range = Range{ .from = 1, .to = 3 };
+        try expectWriterRender(template_text, Data{ .range = &range }, "1,2,3,none");
+        try testing.expect(range.next() == null);
+    }
+
+    test "Peek" {
+        var range = Range{ .from = 1, .to = 2 };
+        try testing.expect(peek(&range));
+        try testing.expectEqual(@as(u32, 1), range.from);
+
+        const empty: ?Range = Range{ .from = 1, .to = 0 };
+        try testing.expect(!peek(empty));
+        try testing.expect(!peek(@as(?Range, null)));
+
+        const names = [_][]const u8{"Ana"};
+        try testing.expect(peek(Team{ .names = &names }));
+    }
+};
@@ -0,0 +1,352 @@
+const std = @import("std");
+const Allocator = std.mem.Allocator;
+const json = std.json;
+
+const testing = std.testing;
+const assert = std.debug.assert;
+
+const mustache = @import("../mustache.zig");
+
+/// Same tags as `std.json.Value`
+pub const Kind = enum(u8) {
+    Null,
+    Bool,
+    Integer,
+    Float,
+    NumberString,
+    String,
+    Array,
+    Object,
+};
+
+/// Hash stored for each key, the same used by `std.StringArrayHashMap`
+pub fn hashKey(key: []const u8) u32 {
+    return std.array_hash_map.hashString(key);
+}
+
+/// Immutable copy of a JSON value, built once and rendered against many templates.
+/// All values live in a single flat array, array items and object members are stored contiguously,
+/// and each object keeps its keys sorted by a precomputed hash,
+/// so a lookup is a binary search over a few cache lines instead of a hash map probe per path part.
+pub const JsonDocument = struct {
+    const Self = @This();
+
+    pub const Error = Allocator.Error || error{DocumentTooLarge};
+
+    pub const Node = struct {
+        kind: Kind,
+
+        /// Number of items, members, or bytes
+        len: u32 = 0,
+
+        data: Data = .{ .start = 0 },
+
+        pub const Data = extern union {
+            boolean: bool,
+            integer: i64,
+            float: f64,
+
+            /// Index of the first item, member, or byte
+            start: u32,
+        };
+    };
+
+    pub const Member = struct {
+        hash: u32,
+        key_start: u32,
+        key_len: u32,
+        node: u32,
+    };
+
+    allocator: Allocator,
+    nodes: []const Node,
+    members: []const Member,
+    strings: []const u8,
+
+    /// Copies the value, the document does not reference the `ValueTree` afterwards
+    pub fn fromValue(allocator: Allocator, value: json.Value) Error!Self {
+        var builder = Builder{ .allocator = allocator };
+        errdefer builder.deinit();
+
+        try builder.nodes.append(allocator, undefined);
+        const root_node = try builder.build(value);
+        builder.nodes.items[0] = root_node;
+
+        return Self{
+            .allocator = allocator,
+            .nodes = builder.nodes.toOwnedSlice(allocator),
+            .members = builder.members.toOwnedSlice(allocator),
+            .strings = builder.strings.toOwnedSlice(allocator),
+        };
+    }
+
+    pub fn parse(allocator: Allocator, text: []const u8) !Self {
+        var parser = json.Parser.init(allocator, false);
+        defer parser.deinit();
+
+        var tree = try parser.parse(text);
+        defer tree.deinit();
+
+        return try fromValue(allocator, tree.root);
+    }
+
+    pub fn deinit(self: *Self) void {
+        self.allocator.free(self.nodes);
+        self.allocator.free(self.members);
+        self.allocator.free(self.strings);
+    }
+
+    pub fn root(self: *const Self) Value {
+        return .{ .document = self, .index = 0 };
+    }
+
+    /// A value inside the document
+    pub const Value = struct {
+        document: *const JsonDocument,
+        index: u32,
+
+        pub fn node(self: Value) Node {
+            return self.document.nodes[self.index];
+        }
+
+        pub fn kind(self: Value) Kind {
+            return self.node().kind;
+        }
+
+        /// Returns the member named `key`
+        pub fn get(self: Value, key: []const u8) ?Value {
+            return self.getHashed(key, hashKey(key));
+        }
+
+        /// Same as `get`, with the key's hash computed by `hashKey` beforehand
+        pub fn getHashed(self: Value, key: []const u8, hash: u32) ?Value {
+            const object = self.node();
+            if (object.kind != .Object) return null;
+
+            const members = self.document.members[object.data.start .. object.data.start + object.len];
+
+            // Lower bound of the hash
+            var low: usize = 0;
+            var high: usize = members.len;
+            while (low < high) {
+                const middle = low + (high - low) / 2;
+                if (members[middle].hash < hash) {
+                    low = middle + 1;
+                } else {
+                    high = middle;
+                }
+            }
+
+            while (low < members.len and members[low].hash == hash) : (low += 1) {
+                const member = members[low];
+                if (std.mem.eql(u8, key, self.document.strings[member.key_start .. member.key_start + member.key_len])) {
+                    return Value{ .document = self.document, .index = member.node };
+                }
+            }
+
+            return null;
+        }
+
+        /// Returns the array item at `index`
+        pub fn at(self: Value, index: usize) ?Value {
+            const array = self.node();
+            if (array.kind != .Array or index >= array.len) return null;
+
+            return Value{ .document = self.document, .index = array.data.start + @intCast(u32, index) };
+        }
+
+        /// Content of a String or NumberString
+        pub fn string(self: Value) []const u8 {
+            const value = self.node();
+            assert(value.kind == .String or value.kind == .NumberString);
+
+            return self.document.strings[value.data.start .. value.data.start + value.len];
+        }
+    };
+
+    const Builder = struct {
+        allocator: Allocator,
+        nodes: std.ArrayListUnmanaged(Node) = .{},
+        members: std.ArrayListUnmanaged(Member) = .{},
+        strings: std.ArrayListUnmanaged(u8) = .{},
+
+        fn deinit(self: *Builder) void {
+            self.nodes.deinit(self.allocator);
+            self.members.deinit(self.allocator);
+            self.strings.deinit(self.allocator);
+        }
+
+        /// Returns the node for the value, storing its children beforehand
+        fn build(self: *Builder, value: json.Value) Error!Node {
+            switch (value) {
+                .Null => return Node{ .kind = .Null },
+                .Bool => |boolean| return Node{ .kind = .Bool, .data = .{ .boolean = boolean } },
+                .Integer => |integer| return Node{ .kind = .Integer, .data = .{ .integer = integer } },
+                .Float => |float| return Node{ .kind = .Float, .data = .{ .float = float } },
+                .NumberString => |number_string| return try self.buildString(.NumberString, number_string),
+                .String => |string| return try self.buildString(.String, string),
+                .Array => |array| {
+                    // Items are reserved first, so they are contiguous regardless of their own children
+                    const start = try self.reserveNodes(array.items.len);
+
+                    for (array.items) |item, index| {
+                        const item_node = try self.build(item);
+                        self.nodes.items[start + index] = item_node;
+                    }
+
+                    return Node{ .kind = .Array, .len = @intCast(u32, array.items.len), .data = .{ .start = start } };
+                },
+                .Object => |object| {
+                    const count = object.count();
+                    const start = try self.reserveNodes(count);
+                    const members_start = try self.reserveMembers(count);
+
+                    var iterator = object.iterator();
+                    var index: u32 = 0;
+                    while (iterator.next()) |entry| : (index += 1) {
+                        const key = entry.key_ptr.*;
+                        self.members.items[members_start + index] = .{
+                            .hash = hashKey(key),
+                            .key_start = try self.appendString(key),
+                            .key_len = @intCast(u32, key.len),
+                            .node = start + index,
+                        };
+
+                        const member_node = try self.build(entry.value_ptr.*);
+                        self.nodes.items[start + index] = member_node;
+                    }
+
+                    const strings: []const u8 = self.strings.items;
+                    std.sort.sort(Member, self.members.items[members_start .. members_start + count], strings, lessThan);
+
+                    return Node{ .kind = .Object, .len = @intCast(u32, count), .data = .{ .start = members_start } };
+                },
+            }
+        }
+
+        fn buildString(self: *Builder, kind: Kind, string: []const u8) Error!Node {
+            const start = try self.appendString(string);
+            return Node{ .kind = kind, .len = @intCast(u32, string.len), .data = .{ .start = start } };
+        }
+
+        fn appendString(self: *Builder, string: []const u8) Error!u32 {
+            const start = self.strings.items.len;
+            _ = try checkedLen(start + string.len);
+
+            try self.strings.appendSlice(self.allocator, string);
+            return @intCast(u32, start);
+        }
+
+        fn reserveNodes(self: *Builder, count: usize) Error!u32 {
+            const start = self.nodes.items.len;
+            _ = try checkedLen(start + count);
+
+            try self.nodes.resize(self.allocator, start + count);
+            return @intCast(u32, start);
+        }
+
+        fn reserveMembers(self: *Builder, count: usize) Error!u32 {
+            const start = self.members.items.len;
+            _ = try checkedLen(start + count);
+
+            try self.members.resize(self.allocator, start + count);
+            return @intCast(u32, start);
+        }
+
+        fn checkedLen(len: usize) Error!u32 {
+            if (len > std.math.maxInt(u32)) return error.DocumentTooLarge;
+            return @intCast(u32, len);
+        }
+
+        fn lessThan(strings: []const u8, left: Member, right: Member) bool {
+            if (left.hash != right.hash) return left.hash < right.hash;
+
+            return std.mem.lessThan(
+                u8,
+                strings[left.key_start .. left.key_start + left.key_len],
+                strings[right.key_start .. right.key_start + right.key_len],
+            );
+        }
+    };
+};
+
+test {
+    _ = tests;
+}
+
+const tests = struct {
+    const text =
+        \\{
+        \\  "name": "Fish & Chips",
+        \\  "tags": ["fish", {"nested": [1, 2]}, "chips"],
+        \\  "price": 9.5, "count": 12, "available": true, "notes": null,
+        \\  "huge": 123456789012345678901234567890,
+        \\  "empty": []
+        \\}
+    ;
+
+    test "Lookup" {
+        var document = try JsonDocument.parse(testing.allocator, text);
+        defer document.deinit();
+
+        const root = document.root();
+        try testing.expectEqual(Kind.Object, root.kind());
+
+        try testing.expectEqualStrings("Fish & Chips", root.get("name").?.string());
+        try testing.expectEqual(@as(f64, 9.5), root.get("price").?.node().data.float);
+        try testing.expectEqual(@as(i64, 12), root.get("count").?.node().data.integer);
+        try testing.expect(root.get("available").?.node().data.boolean);
+        try testing.expectEqual(Kind.Null, root.get("notes").?.kind());
+        try testing.expectEqualStrings("123456789012345678901234567890", root.get("huge").?.string());
+        try testing.expect(root.get("missing") == null);
+        try testing.expect(root.get("name").?.get("name") == null);
+
+        const name = "name";
+        try testing.expect(root.getHashed(name, hashKey(name)) != null);
+    }
+
+    test "Arrays" {
+        var document = try JsonDocument.parse(testing.allocator, text);
+        defer document.deinit();
+
+        const tags = document.root().get("tags").?;
+        try testing.expectEqualStrings("fish", tags.at(0).?.string());
+        try testing.expectEqualStrings("chips", tags.at(2).?.string());
+        try testing.expect(tags.at(3) == null);
+        try testing.expect(document.root().get("empty").?.at(0) == null);
+
+        const nested = tags.at(1).?.get("nested").?;
+        try testing.expectEqual(@as(i64, 2), nested.at(1).?.node().data.integer);
+
+        // Items are contiguous
+        try testing.expectEqual(tags.at(0).?.index + 2, tags.at(2).?.index);
+    }
+
+    test "Render" {
+        const allocator = testing.allocator;
+
+        var document = try JsonDocument.parse(allocator, text);
+        defer document.deinit();
+
+        const templates = [_][]const u8{
+            "{{name}}|{{#tags}}[{{.}}]{{/tags}}|{{price}}|{{count}}|{{#notes}}notes{{/notes}}{{^empty}}empty{{/empty}}",
+            "{{#available}}{{count}} available{{/available}}{{#tags}}{{#nested}}({{.}}){{/nested}}{{/tags}}",
+        };
+
+        const expected = [_][]const u8{
+            "Fish &amp; Chips|[fish][][chips]|9.5|12|empty",
+            "12 available(1)(2)",
+        };
+
+        // The same document rendered against several templates
+        for (templates) |template_text, index| {
+            var template = (try mustache.parseText(allocator, template_text, .{}, .{ .copy_strings = false })).success;
+            defer template.deinit(allocator);
+
+            const result = try mustache.allocRender(allocator, template, &document);
+            defer allocator.free(result);
+
+            try testing.expectEqualStrings(expected[index], result);
+        }
+    }
+};
@@ -0,0 +1,605 @@
+const std = @import("std");
+const Allocator = std.mem.Allocator;
+const json = std.json;
+
+const testing = std.testing;
+
+const mustache = @import("../mustache.zig");
+const RenderOptions = mustache.options.RenderOptions;
+const RenderFromTemplateOptions = mustache.options.RenderFromTemplateOptions;
+const Element = mustache.Element;
+const Template = mustache.Template;
+
+const rendering = @import("rendering.zig");
+const context = @import("context.zig");
+const map = @import("partials_map.zig");
+const raw_json = @import("raw_json.zig");
+
+pub const JsonStreamError = error{
+    InvalidJson,
+
+    /// A member following the streamed array is referenced by elements already rendered without it
+    MemberAfterStreamedArray,
+};
+
+/// Renders the `Template` with the JSON object read from `json_reader` to a `writer`,
+/// without loading the whole object in memory.
+/// See `renderJsonStreamPartialsWithOptions`
+pub fn renderJsonStream(allocator: Allocator, template: Template, json_reader: anytype, writer: anytype) !void {
+    try renderJsonStreamPartialsWithOptions(allocator, template, {}, json_reader, writer, .{});
+}
+
+/// Renders the `Template` with the JSON object read from `json_reader` to a `writer`,
+/// without loading the whole object in memory.
+/// `options` defines the behavior of the render process
+/// See `renderJsonStreamPartialsWithOptions`
+pub fn renderJsonStreamWithOptions(allocator: Allocator, template: Template, json_reader: anytype, writer: anytype, comptime options: RenderFromTemplateOptions) !void {
+    try renderJsonStreamPartialsWithOptions(allocator, template, {}, json_reader, writer, options);
+}
+
+/// Renders the `Template` with the JSON object read from `json_reader` to a `writer`,
+/// without loading the whole object in memory.
+/// `partials` can be a tuple, an array, slice or a HashMap containing the partial's name as key and the `Template` as value
+/// See `renderJsonStreamPartialsWithOptions`
+pub fn renderJsonStreamPartials(allocator: Allocator, template: Template, partials: anytype, json_reader: anytype, writer: anytype) !void {
+    try renderJsonStreamPartialsWithOptions(allocator, template, partials, json_reader, writer, .{});
+}
+
+/// Renders the `Template` with the JSON object read from `json_reader` to a `writer`,
+/// without loading the whole object in memory.
+///
+/// The first top-level section of the template, such as `{{#rows}}...{{/rows}}`, is streamed:
+/// the items of the array with the same name are read, rendered and discarded one at a time.
+/// All the other members are kept in memory, so memory use is bounded by the largest item, not by the array length.
+///
+/// Elements before the streamed section are rendered as soon as the array starts,
+/// seeing only the members that precede it in the JSON text.
+/// A member following the array whose name is referenced by those elements, or by the section,
+/// returns `error.MemberAfterStreamedArray`, since they were already rendered without it.
+/// Elements after the section see all the other members.
+///
+/// If any other element, or a partial, references the array's name, the section is not streamed.
+/// If the template has no such section, or the JSON has no such array, the whole object is read before rendering,
+/// rendering the same as `std.json`.
+///
+/// `partials` can be a tuple, an array, slice or a HashMap containing the partial's name as key and the `Template` as value
+/// `options` defines the behavior of the render process
+pub fn renderJsonStreamPartialsWithOptions(allocator: Allocator, template: Template, partials: anytype, json_reader: anytype, writer: anytype, comptime options: RenderFromTemplateOptions) !void {
+    const render_options = RenderOptions{ .template = options };
+    const PartialsMap = map.PartialsMap(@TypeOf(partials), render_options);
+    const Render = JsonStreamRender(@TypeOf(writer), PartialsMap, render_options);
+
+    var buffered = std.io.bufferedReader(json_reader);
+    try Render.render(allocator, template, PartialsMap.init(partials), buffered.reader(), writer);
+}
+
+fn JsonStreamRender(comptime Writer: type, comptime PartialsMap: type, comptime options: RenderOptions) type {
+    const Engine = rendering.RenderEngine(Writer, PartialsMap, options);
+    const ContextStack = Engine.ContextStack;
+    const DataRender = Engine.DataRender;
+
+    return struct {
+        fn render(allocator: Allocator, template: Template, partials_map: PartialsMap, reader: anytype, writer: Writer) !void {
+            var scanner = Scanner(@TypeOf(reader)){ .reader = reader };
+
+            // First path part of the elements rendered while streaming
+            var names = std.StringHashMap(void).init(allocator);
+            defer names.deinit();
+
+            var visited = std.StringHashMap(void).init(allocator);
+            defer visited.deinit();
+
+            const streamed = try streamableSection(template.elements, partials_map, &names, &visited);
+
+            // Every member but the streamed array, as a JSON object
+            var members = std.ArrayList(u8).init(allocator);
+            defer members.deinit();
+
+            var key = std.ArrayList(u8).init(allocator);
+            defer key.deinit();
+
+            var key_text = std.ArrayList(u8).init(allocator);
+            defer key_text.deinit();
+
+            var parser = json.Parser.init(allocator, true);
+            defer parser.deinit();
+
+            var indentation_queue = Engine.IndentationQueue{};
+            var data_render = DataRender{
+                .out_writer = .{ .writer = writer },
+                .partials_map = partials_map,
+                .stack = undefined,
+                .indentation_queue = &indentation_queue,
+                .template_options = template.options,
+            };
+
+            // Elements already rendered while streaming
+            var rendered_until: usize = 0;
+
+            try scanner.expect('{');
+            try members.append('{');
+
+            var first_member = true;
+            while (true) {
+                const next = (try scanner.skipWhitespace()) orelse return error.InvalidJson;
+                if (next == '}') {
+                    _ = try scanner.take();
+                    break;
+                }
+
+                if (!first_member) try scanner.expect(',');
+                first_member = false;
+
+                if ((try scanner.skipWhitespace()) != @as(?u8, '"')) return error.InvalidJson;
+
+                key.clearRetainingCapacity();
+                try scanner.readValue(&key);
+                try scanner.expect(':');
+
+                if (streamed) |section| {
+                    if (rendered_until == 0 and
+                        (try scanner.skipWhitespace()) == @as(?u8, '[') and
+                        try keyEql(key.items, section.element.path[0].name, &key_text))
+                    {
+                        try renderStreamed(allocator, &data_render, &scanner, &parser, &members, template.elements, section);
+                        rendered_until = section.index + 1 + section.element.children_count + section.element.else_count;
+
+                        names.clearRetainingCapacity();
+                        visited.clearRetainingCapacity();
+                        try collectNames(template.elements[0..rendered_until], partials_map, &names, &visited);
+
+                        // No other element references the array
+                        continue;
+                    }
+                }
+
+                if (rendered_until > 0 and names.contains(try unescapeKey(key.items, &key_text))) {
+                    return error.MemberAfterStreamedArray;
+                }
+
+                try appendMember(&members, key.items, "");
+                try scanner.readValue(&members);
+            }
+
+            parser.reset();
+            var tree = try parseMembers(&parser, &members);
+            defer tree.deinit();
+
+            const root_stack = ContextStack{
+                .parent = null,
+                .ctx = context.getContext(Writer, tree.root, PartialsMap, options),
+            };
+
+            data_render.stack = &root_stack;
+            try data_render.render(template.elements[rendered_until..]);
+        }
+
+        /// Returns the section to stream, unless its name is referenced by any other element
+        fn streamableSection(
+            elements: []const Element,
+            partials_map: PartialsMap,
+            names: *std.StringHashMap(void),
+            visited: *std.StringHashMap(void),
+        ) Allocator.Error!?StreamedSection {
+            const section = findStreamedSection(elements) orelse return null;
+
+            try collectNames(elements[0..section.index], partials_map, names, visited);
+            try collectNames(elements[section.index + 1 ..], partials_map, names, visited);
+
+            return if (names.contains(section.element.path[0].name)) null else section;
+        }
+
+        /// Adds the first part of each path in the elements, and in the partials they render, to `names`
+        fn collectNames(
+            elements: []const Element,
+            partials_map: PartialsMap,
+            names: *std.StringHashMap(void),
+            visited: *std.StringHashMap(void),
+        ) Allocator.Error!void {
+            for (elements) |element| {
+                const path = switch (element) {
+                    .interpolation, .unescaped_interpolation => |path| path,
+                    .section => |section| section.path,
+                    .inverted_section => |section| section.path,
+                    .partial => |partial| {
+                        try collectPartialNames(partial.key, partials_map, names, visited);
+                        continue;
+                    },
+                    .parent => |parent| {
+                        try collectPartialNames(parent.key, partials_map, names, visited);
+                        continue;
+                    },
+                    .static_text, .block => continue,
+                };
+
+                if (path.len > 0) try names.put(path[0].name, {});
+            }
+        }
+
+        fn collectPartialNames(
+            key: []const u8,
+            partials_map: PartialsMap,
+            names: *std.StringHashMap(void),
+            visited: *std.StringHashMap(void),
+        ) Allocator.Error!void {
+            if (comptime PartialsMap.isEmpty()) return;
+
+            // Recursive partials are visited once
+            if ((try visited.getOrPut(key)).found_existing) return;
+
+            if (partials_map.get(key)) |partial_template| {
+                try collectNames(partial_template.elements, partials_map, names, visited);
+            }
+        }
+
+        /// Renders the elements up to the streamed section with the members read so far,
+        /// then reads the array items one at a time, rendering the section for each one
+        fn renderStreamed(
+            allocator: Allocator,
+            data_render: *DataRender,
+            scanner: anytype,
+            parser: *json.Parser,
+            members: *std.ArrayList(u8),
+            elements: []const Element,
+            section: StreamedSection,
+        ) !void {
+            parser.reset();
+            var tree = try parseMembers(parser, members);
+            defer tree.deinit();
+
+            const root_stack = ContextStack{
+                .parent = null,
+                .ctx = context.getContext(Writer, tree.root, PartialsMap, options),
+            };
+
+            data_render.stack = &root_stack;
+            try data_render.render(elements[0..section.index]);
+
+            const children_start = section.index + 1;
+            const else_start = children_start + section.element.children_count;
+
+            var item = std.ArrayList(u8).init(allocator);
+            defer item.deinit();
+
+            // Items are parsed in place, the text is kept until the item is rendered
+            var item_parser = json.Parser.init(allocator, false);
+            defer item_parser.deinit();
+
+            try scanner.expect('[');
+
+            var count: usize = 0;
+            while (true) : (count += 1) {
+                const next = (try scanner.skipWhitespace()) orelse return error.InvalidJson;
+                if (next == ']') {
+                    _ = try scanner.take();
+                    break;
+                }
+
+                if (count > 0) try scanner.expect(',');
+
+                item.clearRetainingCapacity();
+                try scanner.readValue(&item);
+
+                item_parser.reset();
+                var item_tree = try item_parser.parse(item.items);
+                defer item_tree.deinit();
+
+                data_render.stack = &ContextStack{
+                    .parent = &root_stack,
+                    .ctx = context.getContext(Writer, item_tree.root, PartialsMap, options),
+                };
+                defer data_render.stack = &root_stack;
+
+                try data_render.render(elements[children_start..else_start]);
+            }
+
+            if (count == 0) {
+                try data_render.render(elements[else_start .. else_start + section.element.else_count]);
+            }
+        }
+    };
+}
+
+pub const StreamedSection = struct {
+    index: usize,
+    element: Element.Section,
+};
+
+/// Returns the first top-level section with a single part path
+pub fn findStreamedSection(elements: []const Element) ?StreamedSection {
+    var index: usize = 0;
+    while (index < elements.len) {
+        const element = elements[index];
+        switch (element) {
+            .section => |section| {
+                if (section.path.len == 1) return StreamedSection{ .index = index, .element = section };
+                index += section.children_count + section.else_count;
+            },
+            .inverted_section => |section| index += section.children_count,
+            .parent => |parent| index += parent.children_count,
+            .block => |block| index += block.children_count,
+            else => {},
+        }
+
+        index += 1;
+    }
+
+    return null;
+}
+
+/// Parses the members read so far.
+/// The parser must copy strings, the members text keeps growing while the tree is in use
+fn parseMembers(parser: *json.Parser, members: *std.ArrayList(u8)) !json.ValueTree {
+    try members.append('}');
+    defer members.items.len -= 1;
+
+    return try parser.parse(members.items);
+}
+
+fn appendMember(members: *std.ArrayList(u8), raw_key: []const u8, value: []const u8) Allocator.Error!void {
+    if (members.items.len > 1) try members.append(',');
+    try members.appendSlice(raw_key);
+    try members.append(':');
+    try members.appendSlice(value);
+}
+
+/// Compares a quoted JSON key, still escaped, with a name
+fn keyEql(raw_key: []const u8, name: []const u8, buffer: *std.ArrayList(u8)) Allocator.Error!bool {
+    return std.mem.eql(u8, try unescapeKey(raw_key, buffer), name);
+}
+
+/// Returns the content of a quoted JSON key, unescaped into `buffer` if it has escape sequences
+fn unescapeKey(raw_key: []const u8, buffer: *std.ArrayList(u8)) Allocator.Error![]const u8 {
+    const content = raw_key[1 .. raw_key.len - 1];
+    if (std.mem.indexOfScalar(u8, content, '\\') == null) return content;
+
+    buffer.clearRetainingCapacity();
+
+    var unescaper = raw_json.Unescaper{ .text = content };
+    var char_buffer: [4]u8 = undefined;
+    while (unescaper.next(&char_buffer)) |bytes| try buffer.appendSlice(bytes);
+
+    return buffer.items;
+}
+
+/// Reads JSON values from a stream, one byte at a time
+fn Scanner(comptime Reader: type) type {
+    return struct {
+        const Self = @This();
+        pub const Error = Reader.Error || Allocator.Error || JsonStreamError;
+
+        reader: Reader,
+        peeked: ?u8 = null,
+
+        fn peek(self: *Self) Reader.Error!?u8 {
+            if (self.peeked == null) {
+                self.peeked = self.reader.readByte() catch |err| switch (err) {
+                    error.EndOfStream => return null,
+                    else => |read_error| return read_error,
+                };
+            }
+
+            return self.peeked;
+        }
+
+        fn take(self: *Self) Reader.Error!?u8 {
+            const char = try self.peek();
+            self.peeked = null;
+            return char;
+        }
+
+        /// Returns the next char that is not a whitespace, without consuming it
+        fn skipWhitespace(self: *Self) Reader.Error!?u8 {
+            while (try self.peek()) |char| {
+                switch (char) {
+                    ' ', '\t', '\r', '\n' => self.peeked = null,
+                    else => return char,
+                }
+            }
+
+            return null;
+        }
+
+        fn expect(self: *Self, expected: u8) Error!void {
+            if ((try self.skipWhitespace()) != @as(?u8, expected)) return error.InvalidJson;
+            self.peeked = null;
+        }
+
+        /// Appends the text of the next value, skipping nested objects and arrays
+        fn readValue(self: *Self, list: *std.ArrayList(u8)) Error!void {
+            const first = (try self.skipWhitespace()) orelse return error.InvalidJson;
+            switch (first) {
+                '"' => try self.readString(list),
+                '{', '[' => {
+                    var depth: usize = 0;
+                    while (true) {
+                        const char = (try self.peek()) orelse return error.InvalidJson;
+                        switch (char) {
+                            '"' => {
+                                try self.readString(list);
+                                continue;
+                            },
+                            '{', '[' => depth += 1,
+                            '}', ']' => depth -= 1,
+                            else => {},
+                        }
+
+                        self.peeked = null;
+                        try list.append(char);
+                        if (depth == 0) return;
+                    }
+                },
+                ',', ':', '}', ']' => return error.InvalidJson,
+                else => {
+                    while (try self.peek()) |char| {
+                        switch (char) {
+                            ',', '}', ']', ' ', '\t', '\r', '\n' => return,
+                            else => {
+                                self.peeked = null;
+                                try list.append(char);
+                            },
+                        }
+                    }
+                },
+            }
+        }
+
+        fn readString(self: *Self, list: *std.ArrayList(u8)) Error!void {
+            try list.append((try self.take()).?);
+
+            while (try self.take()) |char| {
+                try list.append(char);
+                switch (char) {
+                    '\\' => try list.append((try self.take()) orelse return error.InvalidJson),
+                    '"' => return,
+                    else => {},
+                }
+            }
+
+            return error.InvalidJson;
+        }
+    };
+}
+
+test {
+    _ = tests;
+}
+
+const tests = struct {
+    const template_text =
+        \\<h1>{{title}}</h1>
+        \\{{#rows}}
+        \\<p>{{id}}: {{name}} ({{title}})</p>
+        \\{{/rows}}
+        \\{{^rows}}
+        \\<p>None</p>
+        \\{{/rows}}
+        \\{{footer}}
+    ;
+
+    fn expectStreamRender(json_text: []const u8, expected: []const u8) !void {
+        const allocator = testing.allocator;
+
+        var template = (try mustache.parseText(allocator, template_text, .{}, .{ .copy_strings = false })).success;
+        defer template.deinit(allocator);
+
+        var result = std.ArrayList(u8).init(allocator);
+        defer result.deinit();
+
+        var stream = std.io.fixedBufferStream(json_text);
+        try renderJsonStream(allocator, template, stream.reader(), result.writer());
+
+        try testing.expectEqualStrings(expected, result.items);
+    }
+
+    test "Stream rows" {
+        try expectStreamRender(
+            \\{"title": "Report", "rows": [{"id": 1, "name": "a"}, {"id": 2, "name": "<b>"}], "footer": "End"}
+        ,
+            \\<h1>Report</h1>
+            \\<p>1: a (Report)</p>
+            \\<p>2: &lt;b&gt; (Report)</p>
+            \\End
+        );
+    }
+
+    test "Empty array" {
+        try expectStreamRender(
+            \\{"title": "Report", "rows": [ ], "footer": "End"}
+        ,
+            \\<h1>Report</h1>
+            \\<p>None</p>
+            \\End
+        );
+    }
+
+    test "Members after the array" {
+        const allocator = testing.allocator;
+
+        var template = (try mustache.parseText(allocator, template_text, .{}, .{ .copy_strings = false })).success;
+        defer template.deinit(allocator);
+
+        // The title comes too late for the elements already rendered
+        var stream = std.io.fixedBufferStream(
+            \\{"rows": [{"id": 1, "name": "a"}], "title": "Report", "footer": "End"}
+        );
+        try testing.expectError(error.MemberAfterStreamedArray, renderJsonStream(allocator, template, stream.reader(), std.io.null_writer));
+
+        // Members not referenced before the footer can follow the array
+        try expectStreamRender(
+            \\{"title": "Report", "rows": [{"id": 1, "name": "a"}], "footer": "End", "unused": [1, 2]}
+        ,
+            \\<h1>Report</h1>
+            \\<p>1: a (Report)</p>
+            \\End
+        );
+    }
+
+    test "Array referenced again" {
+        const allocator = testing.allocator;
+
+        // The array is read whole, the later sections see its items
+        var template = (try mustache.parseText(allocator, "{{#rows}}{{.}},{{/rows}}|{{#rows}}{{.}};{{/rows}}", .{}, .{ .copy_strings = false })).success;
+        defer template.deinit(allocator);
+
+        var result = std.ArrayList(u8).init(allocator);
+        defer result.deinit();
+
+        var stream = std.io.fixedBufferStream("{\"rows\": [1, 2], \"after\": 3}");
+        try renderJsonStream(allocator, template, stream.reader(), result.writer());
+
+        try testing.expectEqualStrings("1,2,|1;2;", result.items);
+    }
+
+    test "Missing array" {
+        try expectStreamRender(
+            \\{"title": "Report", "rows": "not an array", "footer": "End"}
+        ,
+            \\<h1>Report</h1>
+            \\<p>:  (Report)</p>
+            \\End
+        );
+    }
+
+    test "Many rows" {
+        const allocator = testing.allocator;
+
+        var template = (try mustache.parseText(allocator, "{{#rows}}{{.}},{{/rows}}", .{}, .{ .copy_strings = false })).success;
+        defer template.deinit(allocator);
+
+        var json_text = std.ArrayList(u8).init(allocator);
+        defer json_text.deinit();
+
+        var expected = std.ArrayList(u8).init(allocator);
+        defer expected.deinit();
+
+        try json_text.appendSlice("{\"rows\":[");
+
+        var index: usize = 0;
+        while (index < 10_000) : (index += 1) {
+            if (index > 0) try json_text.append(',');
+            try json_text.writer().print("{d}", .{index});
+            try expected.writer().print("{d},", .{index});
+        }
+
+        try json_text.appendSlice("]}");
+
+        var result = std.ArrayList(u8).init(allocator);
+        defer result.deinit();
+
+        var stream = std.io.fixedBufferStream(json_text.items);
+        try renderJsonStream(allocator, template, stream.reader(), result.writer());
+
+        try testing.expectEqualStrings(expected.items, result.items);
+    }
+
+    test "Invalid JSON" {
+        const allocator = testing.allocator;
+
+        var template = (try mustache.parseText(allocator, "{{#rows}}{{.}}{{/rows}}", .{}, .{ .copy_strings = false })).success;
+        defer template.deinit(allocator);
+
+        var stream = std.io.fixedBufferStream("{\"rows\": [1, 2");
+        try testing.expectError(error.InvalidJson, renderJsonStream(allocator, template, stream.reader(), std.io.null_writer));
+    }
+};
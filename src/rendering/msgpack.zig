@@ -0,0 +1,315 @@
+const std = @import("std");
+
+const testing = std.testing;
+const assert = std.debug.assert;
+
+const mustache = @import("../mustache.zig");
+
+/// MessagePack data rendered in place, without decoding it into structs or a `std.json.ValueTree`.
+/// Maps are scanned entry by entry along the template's paths, arrays are iterated without being materialized,
+/// and strings are rendered as slices of the input bytes.
+/// The bytes are expected to be valid MessagePack, truncated values render as missing.
+pub const MsgPack = struct {
+    bytes: []const u8,
+
+    pub fn root(self: MsgPack) Node {
+        const end = valueEnd(self.bytes, 0) orelse 0;
+        return .{ .value = self.bytes[0..end] };
+    }
+};
+
+pub const Kind = enum {
+    Null,
+    Bool,
+    Integer,
+    Float,
+    String,
+    Binary,
+    Array,
+    Map,
+    Extension,
+};
+
+/// MessagePack integers range from `minInt(i64)` to `maxInt(u64)`
+pub const Integer = union(enum) {
+    signed: i64,
+    unsigned: u64,
+};
+
+/// A MessagePack value inside the bytes
+pub const Node = struct {
+    /// The value's bytes, including its header
+    value: []const u8,
+
+    /// Bytes following the value, starting with the next item if the value is an array item
+    rest: []const u8 = "",
+
+    /// Number of array items following this one
+    remaining: u32 = 0,
+
+    pub fn kind(self: Node) Kind {
+        if (self.value.len == 0) return .Null;
+
+        const value = header(self.value, 0) orelse return .Null;
+        return value.kind;
+    }
+
+    pub fn isTrue(self: Node) bool {
+        return self.value.len > 0 and self.value[0] == 0xc3;
+    }
+
+    pub fn integer(self: Node) Integer {
+        assert(self.kind() == .Integer);
+
+        const bytes = self.value;
+        return switch (bytes[0]) {
+            0x00...0x7f => .{ .unsigned = bytes[0] },
+            0xe0...0xff => .{ .signed = @bitCast(i8, bytes[0]) },
+            0xcc => .{ .unsigned = bytes[1] },
+            0xcd => .{ .unsigned = std.mem.readIntSliceBig(u16, bytes[1..]) },
+            0xce => .{ .unsigned = std.mem.readIntSliceBig(u32, bytes[1..]) },
+            0xcf => .{ .unsigned = std.mem.readIntSliceBig(u64, bytes[1..]) },
+            0xd0 => .{ .signed = @bitCast(i8, bytes[1]) },
+            0xd1 => .{ .signed = std.mem.readIntSliceBig(i16, bytes[1..]) },
+            0xd2 => .{ .signed = std.mem.readIntSliceBig(i32, bytes[1..]) },
+            0xd3 => .{ .signed = std.mem.readIntSliceBig(i64, bytes[1..]) },
+            else => unreachable,
+        };
+    }
+
+    pub fn float(self: Node) f64 {
+        assert(self.kind() == .Float);
+
+        return switch (self.value[0]) {
+            0xca => @bitCast(f32, std.mem.readIntSliceBig(u32, self.value[1..])),
+            0xcb => @bitCast(f64, std.mem.readIntSliceBig(u64, self.value[1..])),
+            else => unreachable,
+        };
+    }
+
+    /// Content of a String or Binary, sliced from the input bytes
+    pub fn string(self: Node) []const u8 {
+        const value = header(self.value, 0).?;
+        assert(value.kind == .String or value.kind == .Binary);
+
+        return self.value[value.payload .. value.payload + value.len];
+    }
+
+    /// Returns the value of the string key `key`, keeping the first one if the key is repeated
+    pub fn get(self: Node, key: []const u8) ?Node {
+        const map = header(self.value, 0) orelse return null;
+        if (map.kind != .Map) return null;
+
+        var pos = map.payload;
+        var pending = map.count / 2;
+        while (pending > 0) : (pending -= 1) {
+            const key_end = valueEnd(self.value, pos) orelse return null;
+            const value_end = valueEnd(self.value, key_end) orelse return null;
+
+            const member_key = Node{ .value = self.value[pos..key_end] };
+            if (member_key.kind() == .String and std.mem.eql(u8, member_key.string(), key)) {
+                return Node{ .value = self.value[key_end..value_end] };
+            }
+
+            pos = value_end;
+        }
+
+        return null;
+    }
+
+    /// Returns the item at `index`, scanning the array from the start
+    pub fn at(self: Node, index: usize) ?Node {
+        const array = header(self.value, 0) orelse return null;
+        if (array.kind != .Array or index >= array.count) return null;
+
+        var item = arrayItem(self.value[array.payload..], @intCast(u32, array.count)) orelse return null;
+
+        var current: usize = 0;
+        while (current < index) : (current += 1) {
+            item = item.next() orelse return null;
+        }
+
+        return item;
+    }
+
+    /// Returns the array item following this one
+    pub fn next(self: Node) ?Node {
+        if (self.remaining == 0) return null;
+        return arrayItem(self.rest, self.remaining);
+    }
+
+    fn arrayItem(bytes: []const u8, count: u32) ?Node {
+        const end = valueEnd(bytes, 0) orelse return null;
+        return Node{ .value = bytes[0..end], .rest = bytes[end..], .remaining = count - 1 };
+    }
+};
+
+const Header = struct {
+    kind: Kind,
+
+    /// Position of the first byte following the header
+    payload: usize,
+
+    /// Number of payload bytes
+    len: usize = 0,
+
+    /// Number of values following the header, two per map entry
+    count: usize = 0,
+};
+
+fn header(bytes: []const u8, start: usize) ?Header {
+    if (start >= bytes.len) return null;
+
+    const byte = bytes[start];
+    return switch (byte) {
+        0x00...0x7f, 0xe0...0xff => Header{ .kind = .Integer, .payload = start + 1 },
+        0x80...0x8f => Header{ .kind = .Map, .payload = start + 1, .count = @as(usize, byte & 0x0f) * 2 },
+        0x90...0x9f => Header{ .kind = .Array, .payload = start + 1, .count = byte & 0x0f },
+        0xa0...0xbf => Header{ .kind = .String, .payload = start + 1, .len = byte & 0x1f },
+        0xc0 => Header{ .kind = .Null, .payload = start + 1 },
+        0xc1 => null,
+        0xc2, 0xc3 => Header{ .kind = .Bool, .payload = start + 1 },
+        0xc4 => sized(bytes, start, .Binary, u8),
+        0xc5 => sized(bytes, start, .Binary, u16),
+        0xc6 => sized(bytes, start, .Binary, u32),
+
+        // The extension's type byte is counted as payload
+        0xc7 => extension(sized(bytes, start, .Extension, u8)),
+        0xc8 => extension(sized(bytes, start, .Extension, u16)),
+        0xc9 => extension(sized(bytes, start, .Extension, u32)),
+
+        0xca => Header{ .kind = .Float, .payload = start + 1, .len = 4 },
+        0xcb => Header{ .kind = .Float, .payload = start + 1, .len = 8 },
+        0xcc, 0xd0 => Header{ .kind = .Integer, .payload = start + 1, .len = 1 },
+        0xcd, 0xd1 => Header{ .kind = .Integer, .payload = start + 1, .len = 2 },
+        0xce, 0xd2 => Header{ .kind = .Integer, .payload = start + 1, .len = 4 },
+        0xcf, 0xd3 => Header{ .kind = .Integer, .payload = start + 1, .len = 8 },
+        0xd4...0xd8 => Header{ .kind = .Extension, .payload = start + 1, .len = 1 + (@as(usize, 1) << @intCast(u3, byte - 0xd4)) },
+        0xd9 => sized(bytes, start, .String, u8),
+        0xda => sized(bytes, start, .String, u16),
+        0xdb => sized(bytes, start, .String, u32),
+        0xdc => counted(bytes, start, .Array, u16),
+        0xdd => counted(bytes, start, .Array, u32),
+        0xde => counted(bytes, start, .Map, u16),
+        0xdf => counted(bytes, start, .Map, u32),
+    };
+}
+
+/// Header followed by the payload length
+fn sized(bytes: []const u8, start: usize, kind: Kind, comptime Len: type) ?Header {
+    const payload = start + 1 + @sizeOf(Len);
+    if (payload > bytes.len) return null;
+
+    return Header{ .kind = kind, .payload = payload, .len = std.mem.readIntSliceBig(Len, bytes[start + 1 ..]) };
+}
+
+/// Header followed by the number of items or entries
+fn counted(bytes: []const u8, start: usize, kind: Kind, comptime Count: type) ?Header {
+    const payload = start + 1 + @sizeOf(Count);
+    if (payload > bytes.len) return null;
+
+    const count: usize = std.mem.readIntSliceBig(Count, bytes[start + 1 ..]);
+    return Header{ .kind = kind, .payload = payload, .count = if (kind == .Map) count * 2 else count };
+}
+
+fn extension(value: ?Header) ?Header {
+    var result = value orelse return null;
+    result.len += 1;
+    return result;
+}
+
+/// Returns the position after the value starting at `start`, skipping nested maps and arrays
+pub fn valueEnd(bytes: []const u8, start: usize) ?usize {
+    var pos = start;
+
+    // Every value takes at least one byte, so the loop is bounded by the input length
+    var pending: usize = 1;
+    while (pending > 0) : (pending -= 1) {
+        const value = header(bytes, pos) orelse return null;
+
+        pos = value.payload + value.len;
+        if (pos > bytes.len) return null;
+
+        pending += value.count;
+    }
+
+    return pos;
+}
+
+test {
+    _ = tests;
+}
+
+const tests = struct {
+    // {"name": "Fish & Chips", "tags": ["fish", {"nested": [1, 2]}, "chips"], "price": 9.5, "count": 12,
+    //  "available": true, "notes": nil, "empty": [], "big": 18446744073709551615, "neg": -3}
+    const bytes = "\x89" ++
+        "\xa4name" ++ "\xacFish & Chips" ++
+        "\xa4tags" ++ "\x93" ++ "\xa4fish" ++ "\x81" ++ "\xa6nested" ++ "\x92\x01\x02" ++ "\xa5chips" ++
+        "\xa5price" ++ "\xcb\x40\x23\x00\x00\x00\x00\x00\x00" ++
+        "\xa5count" ++ "\x0c" ++
+        "\xa9available" ++ "\xc3" ++
+        "\xa5notes" ++ "\xc0" ++
+        "\xa5empty" ++ "\x90" ++
+        "\xa3big" ++ "\xcf\xff\xff\xff\xff\xff\xff\xff\xff" ++
+        "\xa3neg" ++ "\xfd";
+
+    test "Lookup" {
+        const root = (MsgPack{ .bytes = bytes }).root();
+        try testing.expectEqual(Kind.Map, root.kind());
+        try testing.expectEqual(bytes.len, root.value.len);
+
+        try testing.expectEqualStrings("Fish & Chips", root.get("name").?.string());
+        try testing.expectEqual(@as(f64, 9.5), root.get("price").?.float());
+        try testing.expectEqual(Integer{ .unsigned = 12 }, root.get("count").?.integer());
+        try testing.expectEqual(Integer{ .unsigned = std.math.maxInt(u64) }, root.get("big").?.integer());
+        try testing.expectEqual(Integer{ .signed = -3 }, root.get("neg").?.integer());
+        try testing.expect(root.get("available").?.isTrue());
+        try testing.expectEqual(Kind.Null, root.get("notes").?.kind());
+        try testing.expect(root.get("missing") == null);
+        try testing.expect(root.get("name").?.get("name") == null);
+
+        try testing.expectEqual(@as(f64, 1.5), (MsgPack{ .bytes = "\xca\x3f\xc0\x00\x00" }).root().float());
+        try testing.expectEqualStrings("abc", (MsgPack{ .bytes = "\xd9\x03abc" }).root().string());
+        try testing.expectEqual(Kind.Extension, (MsgPack{ .bytes = "\xd6\xff\x00\x00\x00\x01" }).root().kind());
+    }
+
+    test "Arrays" {
+        const root = (MsgPack{ .bytes = bytes }).root();
+        const tags = root.get("tags").?;
+
+        try testing.expectEqualStrings("chips", tags.at(2).?.string());
+        try testing.expect(tags.at(3) == null);
+        try testing.expect(root.get("empty").?.at(0) == null);
+
+        var item = tags.at(0).?;
+        try testing.expectEqualStrings("fish", item.string());
+
+        item = item.next().?;
+        try testing.expectEqual(Integer{ .unsigned = 2 }, item.get("nested").?.at(1).?.integer());
+
+        item = item.next().?;
+        try testing.expectEqualStrings("chips", item.string());
+        try testing.expect(item.next() == null);
+    }
+
+    test "Render" {
+        const allocator = testing.allocator;
+
+        var template = (try mustache.parseText(allocator, "{{name}}|{{#tags}}[{{.}}]{{/tags}}|{{price}}|{{count}}|{{#notes}}notes{{/notes}}{{^empty}}empty{{/empty}}|{{big}}|{{neg}}", .{}, .{ .copy_strings = false })).success;
+        defer template.deinit(allocator);
+
+        const result = try mustache.allocRender(allocator, template, MsgPack{ .bytes = bytes });
+        defer allocator.free(result);
+
+        try testing.expectEqualStrings("Fish &amp; Chips|[fish][][chips]|9.5|12|empty|18446744073709551615|-3", result);
+    }
+
+    test "Truncated" {
+        try testing.expectEqual(Kind.Null, (MsgPack{ .bytes = "\x92\x01" }).root().kind());
+        try testing.expectEqual(Kind.Null, (MsgPack{ .bytes = "\xdc\xff" }).root().kind());
+        try testing.expectEqual(Kind.Null, (MsgPack{ .bytes = "\xa5abc" }).root().kind());
+        try testing.expectEqual(Kind.Null, (MsgPack{ .bytes = "" }).root().kind());
+        try testing.expect((MsgPack{ .bytes = "\x81\xa1a" }).root().get("a") == null);
+    }
+};
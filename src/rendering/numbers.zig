@@ -0,0 +1,156 @@
+const std = @import("std");
+
+const testing = std.testing;
+
+const mustache = @import("../mustache.zig");
+const FloatFormat = mustache.options.FloatFormat;
+
+const digit_pairs =
+    "00010203040506070809" ++
+    "10111213141516171819" ++
+    "20212223242526272829" ++
+    "30313233343536373839" ++
+    "40414243444546474849" ++
+    "50515253545556575859" ++
+    "60616263646566676869" ++
+    "70717273747576777879" ++
+    "80818283848586878889" ++
+    "90919293949596979899";
+
+/// Length hint for floats, enough for the shortest representation of most values
+pub const float_len_hint = 24;
+
+/// Max number of chars needed to print any value of the integer type `T` in decimal, including the sign
+pub fn maxIntLen(comptime T: type) usize {
+    return comptime std.math.max(
+        std.fmt.count("{d}", .{std.math.minInt(T)}),
+        std.fmt.count("{d}", .{std.math.maxInt(T)}),
+    );
+}
+
+pub fn IntBuffer(comptime T: type) type {
+    return [maxIntLen(T)]u8;
+}
+
+/// Writes the decimal representation of `value` at the end of `buffer`, two digits at a time.
+/// Returns the written slice.
+pub fn formatInt(value: anytype, buffer: *IntBuffer(@TypeOf(value))) []const u8 {
+    var magnitude = absolute(value);
+    var index: usize = buffer.len;
+
+    while (magnitude >= 100) {
+        const pair = @intCast(usize, magnitude % 100) * 2;
+        magnitude /= 100;
+
+        index -= 2;
+        buffer[index] = digit_pairs[pair];
+        buffer[index + 1] = digit_pairs[pair + 1];
+    }
+
+    if (magnitude >= 10) {
+        const pair = @intCast(usize, magnitude) * 2;
+        index -= 2;
+        buffer[index] = digit_pairs[pair];
+        buffer[index + 1] = digit_pairs[pair + 1];
+    } else {
+        index -= 1;
+        buffer[index] = '0' + @intCast(u8, magnitude);
+    }
+
+    if (value < 0) {
+        index -= 1;
+        buffer[index] = '-';
+    }
+
+    return buffer[index..];
+}
+
+/// Returns the number of chars printed by `formatInt`, without formatting
+pub fn intLen(value: anytype) usize {
+    var magnitude = absolute(value);
+    var len: usize = if (value < 0) 2 else 1;
+
+    while (magnitude >= 10) : (magnitude /= 10) {
+        len += 1;
+    }
+
+    return len;
+}
+
+/// Writes a float straight to the writer
+pub fn formatFloat(value: anytype, comptime format: FloatFormat, writer: anytype) @TypeOf(writer).Error!void {
+    const float_options: std.fmt.FormatOptions = switch (format) {
+        .shortest => .{},
+        .decimals => |decimals| .{ .precision = decimals },
+    };
+
+    try std.fmt.formatFloatDecimal(value, float_options, writer);
+}
+
+/// Magnitude of the integer as an unsigned type wide enough for the digit pairs arithmetic
+fn absolute(value: anytype) std.meta.Int(.unsigned, std.math.max(@typeInfo(@TypeOf(value)).Int.bits, 8)) {
+    return if (comptime @typeInfo(@TypeOf(value)).Int.signedness == .signed)
+        std.math.absCast(value)
+    else
+        value;
+}
+
+test {
+    _ = tests;
+}
+
+const tests = struct {
+    fn expectInt(value: anytype) !void {
+        var expected_buffer: [64]u8 = undefined;
+        const expected = try std.fmt.bufPrint(&expected_buffer, "{d}", .{value});
+
+        var buffer: IntBuffer(@TypeOf(value)) = undefined;
+        try testing.expectEqualStrings(expected, formatInt(value, &buffer));
+        try testing.expectEqual(expected.len, intLen(value));
+    }
+
+    test "Format integers" {
+        try expectInt(@as(u1, 1));
+        try expectInt(@as(u8, 0));
+        try expectInt(@as(u8, 9));
+        try expectInt(@as(u8, 10));
+        try expectInt(@as(u8, 99));
+        try expectInt(@as(u8, 100));
+        try expectInt(@as(u8, 255));
+        try expectInt(@as(i8, -128));
+        try expectInt(@as(i8, -5));
+        try expectInt(@as(i32, 1234567));
+        try expectInt(@as(u64, std.math.maxInt(u64)));
+        try expectInt(@as(i64, std.math.minInt(i64)));
+        try expectInt(@as(i128, std.math.minInt(i128)));
+    }
+
+    fn expectFloat(expected: []const u8, value: anytype, comptime format: FloatFormat) !void {
+        var list = std.ArrayList(u8).init(testing.allocator);
+        defer list.deinit();
+
+        try formatFloat(value, format, list.writer());
+        try testing.expectEqualStrings(expected, list.items);
+    }
+
+    test "Format floats" {
+        try expectFloat("0.1", @as(f64, 0.1), .shortest);
+        try expectFloat("-1.5", @as(f32, -1.5), .shortest);
+        try expectFloat("3.14", @as(f64, 3.14159), .{ .decimals = 2 });
+        try expectFloat("10.00", @as(f64, 10), .{ .decimals = 2 });
+    }
+
+    test "Render with float format" {
+        const allocator = testing.allocator;
+
+        var template = (try mustache.parseText(allocator, "{{price}} {{count}}", .{}, .{ .copy_strings = false })).success;
+        defer template.deinit(allocator);
+
+        const data = .{ .price = @as(f64, 9.5), .count = @as(u32, 1200) };
+
+        const result = try mustache.allocRenderWithOptions(allocator, template, data, .{ .float_format = .{ .decimals = 2 } });
+        defer allocator.free(result);
+
+        try testing.expectEqualStrings("9.50 1200", result);
+    }
+};
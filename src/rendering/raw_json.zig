@@ -0,0 +1,419 @@
+const std = @import("std");
+
+const testing = std.testing;
+const assert = std.debug.assert;
+
+const mustache = @import("../mustache.zig");
+
+/// JSON text rendered lazily, without building a `std.json.ValueTree`.
+/// Only the objects and arrays along the template's paths are scanned, other values are skipped over,
+/// and strings are rendered straight from the text, being unescaped only when they contain escape sequences.
+/// The text is expected to be valid JSON, malformed values render as missing.
+/// Repeated keys resolve to the last member, as in `std.json`.
+pub const RawJson = struct {
+    text: []const u8,
+
+    pub fn root(self: RawJson) Node {
+        const start = skipWhitespace(self.text, 0);
+        const end = if (start < self.text.len) valueEnd(self.text, start) orelse start else start;
+
+        return .{ .value = self.text[start..end] };
+    }
+};
+
+/// Same tags as `std.json.Value`
+pub const Kind = enum {
+    Null,
+    Bool,
+    Integer,
+    Float,
+    String,
+    Array,
+    Object,
+};
+
+/// A JSON value inside the text
+pub const Node = struct {
+    /// The value's text, from the first to the last char
+    value: []const u8,
+
+    /// Text following the value up to the end of the enclosing array,
+    /// empty if the value is not an array item
+    rest: []const u8 = "",
+
+    /// Returns the value's kind, malformed literals and numbers are `.Null`, rendering as missing
+    pub fn kind(self: Node) Kind {
+        if (self.value.len == 0) return .Null;
+
+        return switch (self.value[0]) {
+            '{' => .Object,
+            '[' => .Array,
+            '"' => .String,
+            't', 'f' => if (std.mem.eql(u8, self.value, "true") or std.mem.eql(u8, self.value, "false")) .Bool else .Null,
+            else => numberKind(self.value) orelse .Null,
+        };
+    }
+
+    pub fn isTrue(self: Node) bool {
+        return std.mem.eql(u8, self.value, "true");
+    }
+
+    /// Returns the member named `key`, keeping the last one if the key is repeated, as `std.json` does
+    pub fn get(self: Node, key: []const u8) ?Node {
+        if (self.kind() != .Object) return null;
+
+        const text = self.value;
+        var pos = skipWhitespace(text, 1);
+        if (pos >= text.len or text[pos] == '}') return null;
+
+        var found: ?Node = null;
+        while (pos < text.len) {
+            if (text[pos] != '"') return null;
+
+            const key_end = stringEnd(text, pos) orelse return null;
+            const raw_key = text[pos + 1 .. key_end - 1];
+
+            pos = skipWhitespace(text, key_end);
+            if (pos >= text.len or text[pos] != ':') return null;
+
+            pos = skipWhitespace(text, pos + 1);
+            if (pos >= text.len) return null;
+
+            const value_end = valueEnd(text, pos) orelse return null;
+            if (stringEql(raw_key, key)) found = Node{ .value = text[pos..value_end] };
+
+            pos = skipWhitespace(text, value_end);
+            if (pos >= text.len) return null;
+
+            switch (text[pos]) {
+                ',' => pos = skipWhitespace(text, pos + 1),
+                '}' => return found,
+                else => return null,
+            }
+        }
+
+        return null;
+    }
+
+    /// Returns the item at `index`, scanning the array from the start
+    pub fn at(self: Node, index: usize) ?Node {
+        if (self.kind() != .Array) return null;
+
+        const text = self.value;
+        const pos = skipWhitespace(text, 1);
+        if (pos >= text.len or text[pos] == ']') return null;
+
+        const end = valueEnd(text, pos) orelse return null;
+        var item = Node{ .value = text[pos..end], .rest = text[end..] };
+
+        var current: usize = 0;
+        while (current < index) : (current += 1) {
+            item = item.next() orelse return null;
+        }
+
+        return item;
+    }
+
+    /// Returns the array item following this one
+    pub fn next(self: Node) ?Node {
+        const text = self.rest;
+
+        var pos = skipWhitespace(text, 0);
+        if (pos >= text.len or text[pos] != ',') return null;
+
+        pos = skipWhitespace(text, pos + 1);
+        if (pos >= text.len) return null;
+
+        const end = valueEnd(text, pos) orelse return null;
+        return Node{ .value = text[pos..end], .rest = text[end..] };
+    }
+
+    /// The string's content still escaped, as in the JSON text
+    pub fn rawString(self: Node) []const u8 {
+        assert(self.kind() == .String);
+        return self.value[1 .. self.value.len - 1];
+    }
+};
+
+/// Decodes the escape sequences of a JSON string, one char at a time
+pub const Unescaper = struct {
+    text: []const u8,
+    index: usize = 0,
+
+    /// Returns the bytes of the next char, written into `buffer` when decoded from an escape sequence
+    pub fn next(self: *Unescaper, buffer: *[4]u8) ?[]const u8 {
+        if (self.index >= self.text.len) return null;
+
+        const start = self.index;
+        if (self.text[start] != '\\' or start + 1 >= self.text.len) {
+            self.index += 1;
+            return self.text[start .. start + 1];
+        }
+
+        self.index += 2;
+        buffer[0] = switch (self.text[start + 1]) {
+            'b' => 0x08,
+            'f' => 0x0C,
+            'n' => '\n',
+            'r' => '\r',
+            't' => '\t',
+            'u' => return self.nextCodepoint(buffer) orelse self.text[start..self.index],
+            else => |char| char,
+        };
+
+        return buffer[0..1];
+    }
+
+    fn nextCodepoint(self: *Unescaper, buffer: *[4]u8) ?[]const u8 {
+        var codepoint: u21 = self.hex() orelse return null;
+
+        // Surrogate pairs are encoded as two consecutive escape sequences
+        if (codepoint >= 0xD800 and codepoint <= 0xDBFF) {
+            if (self.index + 1 < self.text.len and self.text[self.index] == '\\' and self.text[self.index + 1] == 'u') {
+                self.index += 2;
+                const low = self.hex() orelse return null;
+                if (low < 0xDC00 or low > 0xDFFF) return null;
+
+                codepoint = 0x10000 + ((codepoint - 0xD800) << 10) + (low - 0xDC00);
+            } else {
+                return null;
+            }
+        }
+
+        const len = std.unicode.utf8Encode(codepoint, buffer) catch return null;
+        return buffer[0..len];
+    }
+
+    fn hex(self: *Unescaper) ?u21 {
+        if (self.index + 4 > self.text.len) return null;
+
+        const value = std.fmt.parseInt(u16, self.text[self.index .. self.index + 4], 16) catch return null;
+        self.index += 4;
+        return value;
+    }
+};
+
+/// Returns the kind of a number following the JSON grammar, `-?(0|[1-9][0-9]*)(.[0-9]+)?([eE][+-]?[0-9]+)?`,
+/// or null if the text is not a number
+fn numberKind(text: []const u8) ?Kind {
+    var pos: usize = 0;
+    if (pos < text.len and text[pos] == '-') pos += 1;
+
+    if (pos >= text.len) return null;
+    if (text[pos] == '0') {
+        pos += 1;
+    } else {
+        pos = digitsEnd(text, pos) orelse return null;
+    }
+
+    var kind: Kind = .Integer;
+
+    if (pos < text.len and text[pos] == '.') {
+        pos = digitsEnd(text, pos + 1) orelse return null;
+        kind = .Float;
+    }
+
+    if (pos < text.len and (text[pos] == 'e' or text[pos] == 'E')) {
+        pos += 1;
+        if (pos < text.len and (text[pos] == '+' or text[pos] == '-')) pos += 1;
+        pos = digitsEnd(text, pos) orelse return null;
+        kind = .Float;
+    }
+
+    return if (pos == text.len) kind else null;
+}
+
+/// Returns the position after one or more digits starting at `start`
+fn digitsEnd(text: []const u8, start: usize) ?usize {
+    var pos = start;
+    while (pos < text.len and std.ascii.isDigit(text[pos])) pos += 1;
+    return if (pos > start) pos else null;
+}
+
+/// Compares the content of a JSON string, still escaped, with a plain string
+pub fn stringEql(raw: []const u8, plain: []const u8) bool {
+    if (std.mem.indexOfScalar(u8, raw, '\\') == null) return std.mem.eql(u8, raw, plain);
+
+    var unescaper = Unescaper{ .text = raw };
+    var buffer: [4]u8 = undefined;
+    var index: usize = 0;
+    while (unescaper.next(&buffer)) |bytes| {
+        if (index + bytes.len > plain.len or !std.mem.eql(u8, bytes, plain[index .. index + bytes.len])) return false;
+        index += bytes.len;
+    }
+
+    return index == plain.len;
+}
+
+pub fn skipWhitespace(text: []const u8, start: usize) usize {
+    var pos = start;
+    while (pos < text.len) : (pos += 1) {
+        switch (text[pos]) {
+            ' ', '\t', '\r', '\n' => {},
+            else => break,
+        }
+    }
+
+    return pos;
+}
+
+/// Returns the position after the value starting at `start`, skipping nested objects and arrays
+pub fn valueEnd(text: []const u8, start: usize) ?usize {
+    switch (text[start]) {
+        '"' => return stringEnd(text, start),
+        '{', '[' => {
+            var depth: usize = 0;
+            var pos = start;
+            while (pos < text.len) {
+                switch (text[pos]) {
+                    '"' => {
+                        pos = stringEnd(text, pos) orelse return null;
+                        continue;
+                    },
+                    '{', '[' => depth += 1,
+                    '}', ']' => {
+                        depth -= 1;
+                        if (depth == 0) return pos + 1;
+                    },
+                    else => {},
+                }
+
+                pos += 1;
+            }
+
+            return null;
+        },
+        ',', ':', '}', ']' => return null,
+        else => {
+            var pos = start + 1;
+            while (pos < text.len) : (pos += 1) {
+                switch (text[pos]) {
+                    ',', '}', ']', ' ', '\t', '\r', '\n' => break,
+                    else => {},
+                }
+            }
+
+            return pos;
+        },
+    }
+}
+
+/// Returns the position after the closing quote of the string starting at `start`
+pub fn stringEnd(text: []const u8, start: usize) ?usize {
+    var pos = start + 1;
+    while (pos < text.len) {
+        switch (text[pos]) {
+            '\\' => pos += 2,
+            '"' => return pos + 1,
+            else => pos += 1,
+        }
+    }
+
+    return null;
+}
+
+test {
+    _ = tests;
+}
+
+const tests = struct {
+    const text =
+        \\ {
+        \\   "name": "Fish \"&\" Chips",
+        \\   "tags": ["fish", {"nested": [1, 2]}, "chips"],
+        \\   "price": 9.5, "count": 12, "available": true, "notes": null,
+        \\   "café": "😀",
+        \\   "empty": []
+        \\ }
+    ;
+
+    fn expectString(expected: []const u8, node: Node) !void {
+        try testing.expectEqual(Kind.String, node.kind());
+
+        var list = std.ArrayList(u8).init(testing.allocator);
+        defer list.deinit();
+
+        var unescaper = Unescaper{ .text = node.rawString() };
+        var buffer: [4]u8 = undefined;
+        while (unescaper.next(&buffer)) |bytes| try list.appendSlice(bytes);
+
+        try testing.expectEqualStrings(expected, list.items);
+    }
+
+    test "Lookup" {
+        const root = (RawJson{ .text = text }).root();
+        try testing.expectEqual(Kind.Object, root.kind());
+
+        try expectString("Fish \"&\" Chips", root.get("name").?);
+        try expectString("😀", root.get("café").?);
+
+        try testing.expectEqual(Kind.Float, root.get("price").?.kind());
+        try testing.expectEqualStrings("12", root.get("count").?.value);
+        try testing.expectEqual(Kind.Integer, root.get("count").?.kind());
+        try testing.expectEqual(Kind.Bool, root.get("available").?.kind());
+        try testing.expectEqual(Kind.Null, root.get("notes").?.kind());
+        try testing.expect(root.get("missing") == null);
+        try testing.expect(root.get("name").?.get("name") == null);
+    }
+
+    test "Arrays" {
+        const root = (RawJson{ .text = text }).root();
+        const tags = root.get("tags").?;
+
+        try expectString("chips", tags.at(2).?);
+        try testing.expect(tags.at(3) == null);
+        try testing.expect(root.get("empty").?.at(0) == null);
+
+        var item = tags.at(0).?;
+        try expectString("fish", item);
+
+        item = item.next().?;
+        try testing.expectEqualStrings("[1, 2]", item.get("nested").?.value);
+
+        item = item.next().?;
+        try expectString("chips", item);
+        try testing.expect(item.next() == null);
+    }
+
+    test "Render" {
+        const allocator = testing.allocator;
+
+        var template = (try mustache.parseText(allocator, "{{name}}|{{#tags}}[{{.}}]{{/tags}}|{{price}}|{{count}}|{{#notes}}notes{{/notes}}{{^empty}}empty{{/empty}}", .{}, .{ .copy_strings = false })).success;
+        defer template.deinit(allocator);
+
+        const result = try mustache.allocRender(allocator, template, RawJson{ .text = text });
+        defer allocator.free(result);
+
+        try testing.expectEqualStrings("Fish &quot;&amp;&quot; Chips|[fish][][chips]|9.5|12|empty", result);
+    }
+
+    test "Malformed" {
+        try testing.expect((RawJson{ .text = "{\"a\": " }).root().get("a") == null);
+        try testing.expect((RawJson{ .text = "[1, " }).root().at(1) == null);
+        try testing.expectEqual(Kind.Null, (RawJson{ .text = "" }).root().kind());
+
+        // Bare tokens that are not JSON numbers or literals render as missing
+        const root = (RawJson{ .text = "{\"name\": <svg/onload=confirm(1)>, \"bad\": 01, \"word\": trueish, \"exp\": -1.5e+3}" }).root();
+        try testing.expectEqual(Kind.Null, root.get("name").?.kind());
+        try testing.expectEqual(Kind.Null, root.get("bad").?.kind());
+        try testing.expectEqual(Kind.Null, root.get("word").?.kind());
+        try testing.expectEqual(Kind.Float, root.get("exp").?.kind());
+
+        const allocator = testing.allocator;
+
+        // Floats render as parsed by `std.json`, not as written
+        var template = (try mustache.parseText(allocator, "[{{name}}][{{{name}}}][{{exp}}]", .{}, .{ .copy_strings = false })).success;
+        defer template.deinit(allocator);
+
+        const result = try mustache.allocRender(allocator, template, RawJson{ .text = root.value });
+        defer allocator.free(result);
+
+        try testing.expectEqualStrings("[][][-1500]", result);
+    }
+
+    test "Repeated keys" {
+        const root = (RawJson{ .text = "{\"a\": 1, \"b\": 2, \"a\": 3}" }).root();
+        try testing.expectEqualStrings("3", root.get("a").?.value);
+        try testing.expectEqualStrings("2", root.get("b").?.value);
+    }
+};
@@ -22,18 +22,49 @@ const TemplateLoader = @import("../template.zig").TemplateLoader;
 
 const context = @import("context.zig");
 const Escape = context.Escape;
+const ObjectSlots = context.ObjectSlots;
 
 const invoker = @import("invoker.zig");
 const Fields = invoker.Fields;
 
 const indent = @import("indent.zig");
 const map = @import("partials_map.zig");
+const bounds = @import("bounds.zig");
+const escape_cache = @import("escape_cache.zig");
+const numbers = @import("numbers.zig");
+const json_stream = @import("json_stream.zig");
+const csv_stream = @import("csv_stream.zig");
+
+const BlockScope = @import("../linking.zig").BlockScope;
 
 const FileError = std.fs.File.OpenError || std.fs.File.ReadError;
 const BufError = std.io.FixedBufferStream([]u8).WriteError;
 
 pub const LambdaContext = @import("lambda.zig").LambdaContext;
 
+pub const outputBound = bounds.outputBound;
+
+pub const SafeHtml = context.SafeHtml;
+pub const FileRange = context.FileRange;
+pub const StreamError = context.StreamError;
+pub const RawJson = context.RawJson;
+pub const MsgPack = context.MsgPack;
+pub const JsonDocument = context.JsonDocument;
+
+pub const EscapeCache = escape_cache.EscapeCache;
+pub const EscapeCacheStats = escape_cache.EscapeCacheStats;
+
+pub const renderJsonStream = json_stream.renderJsonStream;
+pub const renderJsonStreamWithOptions = json_stream.renderJsonStreamWithOptions;
+pub const renderJsonStreamPartials = json_stream.renderJsonStreamPartials;
+pub const renderJsonStreamPartialsWithOptions = json_stream.renderJsonStreamPartialsWithOptions;
+
+pub const CsvFormat = csv_stream.CsvFormat;
+pub const renderCsvStream = csv_stream.renderCsvStream;
+pub const renderCsvStreamWithOptions = csv_stream.renderCsvStreamWithOptions;
+pub const renderCsvStreamPartials = csv_stream.renderCsvStreamPartials;
+pub const renderCsvStreamPartialsWithOptions = csv_stream.renderCsvStreamPartialsWithOptions;
+
 /// Renders the `Template` with the given `data` to a `writer`.
 pub fn render(template: Template, data: anytype, writer: anytype) !void {
     return try renderPartialsWithOptions(template, {}, data, writer, .{});
@@ -56,26 +87,26 @@ pub fn renderPartials(template: Template, partials: anytype, data: anytype, writ
 /// `options` defines the behavior of the render process
 pub fn renderPartialsWithOptions(template: Template, partials: anytype, data: anytype, writer: anytype, comptime options: mustache.options.RenderFromTemplateOptions) !void {
     const render_options = RenderOptions{ .template = options };
-    try internalRender(template, partials, data, writer, render_options);
+    try internalRender(template, partials, data, writer, render_options, null);
 }
 
 /// Renders the `Template` with the given `data` and returns an owned slice with the content.
 /// Caller must free the memory
-pub fn allocRender(allocator: Allocator, template: Template, data: anytype) Allocator.Error![]const u8 {
+pub fn allocRender(allocator: Allocator, template: Template, data: anytype) (Allocator.Error || StreamError)![]const u8 {
     return try allocRenderPartialsWithOptions(allocator, template, {}, data, .{});
 }
 
 /// Renders the `Template` with the given `data` and returns an owned slice with the content.
 /// `options` defines the behavior of the render process
 /// Caller must free the memory
-pub fn allocRenderWithOptions(allocator: Allocator, template: Template, data: anytype, comptime options: mustache.options.RenderFromTemplateOptions) Allocator.Error![]const u8 {
+pub fn allocRenderWithOptions(allocator: Allocator, template: Template, data: anytype, comptime options: mustache.options.RenderFromTemplateOptions) (Allocator.Error || StreamError)![]const u8 {
     return try allocRenderPartialsWithOptions(allocator, template, {}, data, options);
 }
 
 /// Renders the `Template` with the given `data` to a writer.
 /// `partials` can be a tuple, an array, slice or a HashMap containing the partial's name as key and the `Template` as value
 /// Caller must free the memory
-pub fn allocRenderPartials(allocator: Allocator, template: Template, partials: anytype, data: anytype) Allocator.Error![]const u8 {
+pub fn allocRenderPartials(allocator: Allocator, template: Template, partials: anytype, data: anytype) (Allocator.Error || StreamError)![]const u8 {
     return try allocRenderPartialsWithOptions(allocator, template, partials, data, .{});
 }
 
@@ -83,28 +114,28 @@ pub fn allocRenderPartials(allocator: Allocator, template: Template, partials: a
 /// `partials` can be a tuple, an array, slice or a HashMap containing the partial's name as key and the `Template` as value
 /// `options` defines the behavior of the render process
 /// Caller must free the memory
-pub fn allocRenderPartialsWithOptions(allocator: Allocator, template: Template, partials: anytype, data: anytype, comptime options: mustache.options.RenderFromTemplateOptions) Allocator.Error![]const u8 {
+pub fn allocRenderPartialsWithOptions(allocator: Allocator, template: Template, partials: anytype, data: anytype, comptime options: mustache.options.RenderFromTemplateOptions) (Allocator.Error || StreamError)![]const u8 {
     const render_options = RenderOptions{ .template = options };
-    return try internalAllocRender(allocator, template, partials, data, render_options, null);
+    return try internalAllocRender(allocator, template, partials, data, render_options, null, null);
 }
 
 /// Renders the `Template` with the given `data` and returns an owned sentinel-terminated slice with the content.
 /// Caller must free the memory
-pub fn allocRenderZ(allocator: Allocator, template: Template, data: anytype) Allocator.Error![:0]const u8 {
+pub fn allocRenderZ(allocator: Allocator, template: Template, data: anytype) (Allocator.Error || StreamError)![:0]const u8 {
     return try allocRenderZPartialsWithOptions(allocator, template, {}, data, .{});
 }
 
 /// Renders the `Template` with the given `data` and returns an owned sentinel-terminated slice with the content.
 /// `options` defines the behavior of the render process
 /// Caller must free the memory
-pub fn allocRenderZWithOptions(allocator: Allocator, template: Template, data: anytype, comptime options: mustache.options.RenderFromTemplateOptions) Allocator.Error![:0]const u8 {
+pub fn allocRenderZWithOptions(allocator: Allocator, template: Template, data: anytype, comptime options: mustache.options.RenderFromTemplateOptions) (Allocator.Error || StreamError)![:0]const u8 {
     return try allocRenderZPartialsWithOptions(allocator, template, {}, data, options);
 }
 
 /// Renders the `Template` with the given `data` and returns an owned sentinel-terminated slice with the content.
 /// `partials` can be a tuple, an array, slice or a HashMap containing the partial's name as key and the `Template` as value
 /// Caller must free the memory
-pub fn allocRenderZPartials(allocator: Allocator, template: Template, partials: anytype, data: anytype) Allocator.Error![:0]const u8 {
+pub fn allocRenderZPartials(allocator: Allocator, template: Template, partials: anytype, data: anytype) (Allocator.Error || StreamError)![:0]const u8 {
     return try allocRenderZPartialsWithOptions(allocator, template, partials, data, .{});
 }
 
@@ -112,28 +143,28 @@ pub fn allocRenderZPartials(allocator: Allocator, template: Template, partials:
 /// `partials` can be a tuple, an array, slice or a HashMap containing the partial's name as key and the `Template` as value
 /// `options` defines the behavior of the render process
 /// Caller must free the memory
-pub fn allocRenderZPartialsWithOptions(allocator: Allocator, template: Template, partials: anytype, data: anytype, comptime options: mustache.options.RenderFromTemplateOptions) Allocator.Error![:0]const u8 {
+pub fn allocRenderZPartialsWithOptions(allocator: Allocator, template: Template, partials: anytype, data: anytype, comptime options: mustache.options.RenderFromTemplateOptions) (Allocator.Error || StreamError)![:0]const u8 {
     const render_options = RenderOptions{ .template = options };
-    return try internalAllocRender(allocator, template, partials, data, render_options, '\x00');
+    return try internalAllocRender(allocator, template, partials, data, render_options, '\x00', null);
 }
 
 /// Renders the `Template` with the given `data` to a buffer.
 /// Returns a slice pointing to the underlying buffer
-pub fn bufRender(buf: []u8, template: Template, data: anytype) (Allocator.Error || BufError)![]const u8 {
+pub fn bufRender(buf: []u8, template: Template, data: anytype) (Allocator.Error || BufError || StreamError)![]const u8 {
     return try bufRenderPartialsWithOptions(buf, template, {}, data, .{});
 }
 
 /// Renders the `Template` with the given `data` to a buffer.
 /// `options` defines the behavior of the render process
 /// Returns a slice pointing to the underlying buffer
-pub fn bufRenderWithOptions(buf: []u8, template: Template, data: anytype, comptime options: mustache.options.RenderFromTemplateOptions) (Allocator.Error || BufError)![]const u8 {
+pub fn bufRenderWithOptions(buf: []u8, template: Template, data: anytype, comptime options: mustache.options.RenderFromTemplateOptions) (Allocator.Error || BufError || StreamError)![]const u8 {
     return try bufRenderPartialsWithOptions(buf, template, {}, data, options);
 }
 
 /// Renders the `Template` with the given `data` to a buffer.
 /// `partials` can be a tuple, an array, slice or a HashMap containing the partial's name as key and the `Template` as value
 /// Returns a slice pointing to the underlying buffer
-pub fn bufRenderPartials(buf: []u8, template: Template, partials: anytype, data: anytype) (Allocator.Error || BufError)![]const u8 {
+pub fn bufRenderPartials(buf: []u8, template: Template, partials: anytype, data: anytype) (Allocator.Error || BufError || StreamError)![]const u8 {
     return bufRenderPartialsWithOptions(buf, template, partials, data, .{});
 }
 
@@ -141,7 +172,7 @@ pub fn bufRenderPartials(buf: []u8, template: Template, partials: anytype, data:
 /// `partials` can be a tuple, an array, slice or a HashMap containing the partial's name as key and the `Template` as value
 /// `options` defines the behavior of the render process
 /// Returns a slice pointing to the underlying buffer
-pub fn bufRenderPartialsWithOptions(buf: []u8, template: Template, partials: anytype, data: anytype, comptime options: mustache.options.RenderFromTemplateOptions) (Allocator.Error || BufError)![]const u8 {
+pub fn bufRenderPartialsWithOptions(buf: []u8, template: Template, partials: anytype, data: anytype, comptime options: mustache.options.RenderFromTemplateOptions) (Allocator.Error || BufError || StreamError)![]const u8 {
     var fbs = std.io.fixedBufferStream(buf);
     try renderPartialsWithOptions(template, partials, data, fbs.writer(), options);
     return fbs.getWritten();
@@ -149,21 +180,21 @@ pub fn bufRenderPartialsWithOptions(buf: []u8, template: Template, partials: any
 
 /// Renders the `Template` with the given `data` to a buffer, terminated by the zero sentinel.
 /// Returns a slice pointing to the underlying buffer
-pub fn bufRenderZ(buf: []u8, template: Template, data: anytype) (Allocator.Error || BufError)![:0]const u8 {
+pub fn bufRenderZ(buf: []u8, template: Template, data: anytype) (Allocator.Error || BufError || StreamError)![:0]const u8 {
     return try bufRenderZPartialsWithOptions(buf, template, {}, data, .{});
 }
 
 /// Renders the `Template` with the given `data` to a buffer, terminated by the zero sentinel.
 /// `options` defines the behavior of the render process
 /// Returns a slice pointing to the underlying buffer
-pub fn bufRenderZWithOptions(buf: []u8, template: Template, data: anytype, comptime options: mustache.options.RenderFromTemplateOptions) (Allocator.Error || BufError)![:0]const u8 {
+pub fn bufRenderZWithOptions(buf: []u8, template: Template, data: anytype, comptime options: mustache.options.RenderFromTemplateOptions) (Allocator.Error || BufError || StreamError)![:0]const u8 {
     return try bufRenderZPartialsWithOptions(buf, template, {}, data, options);
 }
 
 /// Renders the `Template` with the given `data` to a buffer, terminated by the zero sentinel.
 /// `partials` can be a tuple, an array, slice or a HashMap containing the partial's name as key and the `Template` as value
 /// Returns a slice pointing to the underlying buffer
-pub fn bufRenderZPartials(buf: []u8, template: Template, partials: anytype, data: anytype) (Allocator.Error || BufError)![:0]const u8 {
+pub fn bufRenderZPartials(buf: []u8, template: Template, partials: anytype, data: anytype) (Allocator.Error || BufError || StreamError)![:0]const u8 {
     return try bufRenderZPartialsWithOptions(buf, template, partials, data, .{});
 }
 
@@ -171,7 +202,7 @@ pub fn bufRenderZPartials(buf: []u8, template: Template, partials: anytype, data
 /// `partials` can be a tuple, an array, slice or a HashMap containing the partial's name as key and the `Template` as value
 /// `options` defines the behavior of the render process
 /// Returns a slice pointing to the underlying buffer
-pub fn bufRenderZPartialsWithOptions(buf: []u8, template: Template, partials: anytype, data: anytype, comptime options: mustache.options.RenderFromTemplateOptions) (Allocator.Error || BufError)![:0]const u8 {
+pub fn bufRenderZPartialsWithOptions(buf: []u8, template: Template, partials: anytype, data: anytype, comptime options: mustache.options.RenderFromTemplateOptions) (Allocator.Error || BufError || StreamError)![:0]const u8 {
     var ret = try bufRenderPartialsWithOptions(buf, template, partials, data, options);
 
     if (ret.len < buf.len) {
@@ -183,47 +214,47 @@ pub fn bufRenderZPartialsWithOptions(buf: []u8, template: Template, partials: an
 }
 
 /// Parses the `template_text` and renders with the given `data` to a `writer`
-pub fn renderText(allocator: Allocator, template_text: []const u8, data: anytype, writer: anytype) (Allocator.Error || ParseError || @TypeOf(writer).Error)!void {
+pub fn renderText(allocator: Allocator, template_text: []const u8, data: anytype, writer: anytype) (Allocator.Error || ParseError || StreamError || @TypeOf(writer).Error)!void {
     try renderTextPartialsWithOptions(allocator, template_text, {}, data, writer, .{});
 }
 
 /// Parses the `template_text` and renders with the given `data` to a `writer`
 /// `options` defines the behavior of the parser and render process
-pub fn renderTextWithOptions(allocator: Allocator, template_text: []const u8, data: anytype, writer: anytype, comptime options: mustache.options.RenderFromStringOptions) (Allocator.Error || ParseError || @TypeOf(writer).Error)!void {
+pub fn renderTextWithOptions(allocator: Allocator, template_text: []const u8, data: anytype, writer: anytype, comptime options: mustache.options.RenderFromStringOptions) (Allocator.Error || ParseError || StreamError || @TypeOf(writer).Error)!void {
     try renderTextPartialsWithOptions(allocator, template_text, {}, data, writer, options);
 }
 
 /// Parses the `template_text` and renders with the given `data` to a `writer`
 /// `partials` can be a tuple, an array, slice or a HashMap containing the partial's name as key and the template text as value
-pub fn renderTextPartials(allocator: Allocator, template_text: []const u8, partials: anytype, data: anytype, writer: anytype) (Allocator.Error || ParseError || @TypeOf(writer).Error)!void {
+pub fn renderTextPartials(allocator: Allocator, template_text: []const u8, partials: anytype, data: anytype, writer: anytype) (Allocator.Error || ParseError || StreamError || @TypeOf(writer).Error)!void {
     try renderTextPartialsWithOptions(allocator, template_text, partials, data, writer, .{});
 }
 
 /// Parses the `template_text` and renders with the given `data` to a `writer`
 /// `partials` can be a tuple, an array, slice or a HashMap containing the partial's name as key and the template text as value
 /// `options` defines the behavior of the parser and render process
-pub fn renderTextPartialsWithOptions(allocator: Allocator, template_text: []const u8, partials: anytype, data: anytype, writer: anytype, comptime options: mustache.options.RenderFromStringOptions) (Allocator.Error || ParseError || @TypeOf(writer).Error)!void {
+pub fn renderTextPartialsWithOptions(allocator: Allocator, template_text: []const u8, partials: anytype, data: anytype, writer: anytype, comptime options: mustache.options.RenderFromStringOptions) (Allocator.Error || ParseError || StreamError || @TypeOf(writer).Error)!void {
     const render_options = RenderOptions{ .string = options };
     try internalCollect(allocator, template_text, partials, data, writer, render_options);
 }
 
 /// Parses the `template_text` and renders with the given `data` and returns an owned slice with the content.
 /// Caller must free the memory
-pub fn allocRenderText(allocator: Allocator, template_text: []const u8, data: anytype) (Allocator.Error || ParseError)![]const u8 {
+pub fn allocRenderText(allocator: Allocator, template_text: []const u8, data: anytype) (Allocator.Error || ParseError || StreamError)![]const u8 {
     return try allocRenderTextPartialsWithOptions(allocator, template_text, {}, data, .{});
 }
 
 /// Parses the `template_text` and renders with the given `data` and returns an owned slice with the content.
 /// `options` defines the behavior of the parser and render process
 /// Caller must free the memory
-pub fn allocRenderTextWithOptions(allocator: Allocator, template_text: []const u8, data: anytype, comptime options: mustache.options.RenderFromStringOptions) (Allocator.Error || ParseError)![]const u8 {
+pub fn allocRenderTextWithOptions(allocator: Allocator, template_text: []const u8, data: anytype, comptime options: mustache.options.RenderFromStringOptions) (Allocator.Error || ParseError || StreamError)![]const u8 {
     return try allocRenderTextPartialsWithOptions(allocator, template_text, {}, data, options);
 }
 
 /// Parses the `template_text` and renders with the given `data` and returns an owned slice with the content.
 /// `partials` can be a tuple, an array, slice or a HashMap containing the partial's name as key and the template text as value
 /// Caller must free the memory
-pub fn allocRenderTextPartials(allocator: Allocator, template_text: []const u8, partials: anytype, data: anytype) (Allocator.Error || ParseError)![]const u8 {
+pub fn allocRenderTextPartials(allocator: Allocator, template_text: []const u8, partials: anytype, data: anytype) (Allocator.Error || ParseError || StreamError)![]const u8 {
     return try allocRenderTextPartialsWithOptions(allocator, template_text, partials, data, .{});
 }
 
@@ -231,28 +262,28 @@ pub fn allocRenderTextPartials(allocator: Allocator, template_text: []const u8,
 /// `partials` can be a tuple, an array, slice or a HashMap containing the partial's name as key and the template text as value
 /// `options` defines the behavior of the parser and render process
 /// Caller must free the memory
-pub fn allocRenderTextPartialsWithOptions(allocator: Allocator, template_text: []const u8, partials: anytype, data: anytype, comptime options: mustache.options.RenderFromStringOptions) (Allocator.Error || ParseError)![]const u8 {
+pub fn allocRenderTextPartialsWithOptions(allocator: Allocator, template_text: []const u8, partials: anytype, data: anytype, comptime options: mustache.options.RenderFromStringOptions) (Allocator.Error || ParseError || StreamError)![]const u8 {
     const render_options = RenderOptions{ .string = options };
     return try internalAllocCollect(allocator, template_text, partials, data, render_options, null);
 }
 
 /// Parses the `template_text` and renders with the given `data` and returns an owned sentinel-terminated slice with the content.
 /// Caller must free the memory
-pub fn allocRenderTextZ(allocator: Allocator, template_text: []const u8, data: anytype) (Allocator.Error || ParseError)![:0]const u8 {
+pub fn allocRenderTextZ(allocator: Allocator, template_text: []const u8, data: anytype) (Allocator.Error || ParseError || StreamError)![:0]const u8 {
     return try allocRenderTextZPartialsWithOptions(allocator, template_text, {}, data, .{});
 }
 
 /// Parses the `template_text` and renders with the given `data` and returns an owned sentinel-terminated slice with the content.
 /// `options` defines the behavior of the parser and render process
 /// Caller must free the memory
-pub fn allocRenderTextZWithOptions(allocator: Allocator, template_text: []const u8, data: anytype, comptime options: mustache.options.RenderFromStringOptions) (Allocator.Error || ParseError)![:0]const u8 {
+pub fn allocRenderTextZWithOptions(allocator: Allocator, template_text: []const u8, data: anytype, comptime options: mustache.options.RenderFromStringOptions) (Allocator.Error || ParseError || StreamError)![:0]const u8 {
     return try allocRenderTextZPartialsWithOptions(allocator, template_text, {}, data, options);
 }
 
 /// Parses the `template_text` and renders with the given `data` and returns an owned sentinel-terminated slice with the content.
 /// `partials` can be a tuple, an array, slice or a HashMap containing the partial's name as key and the template text as value
 /// Caller must free the memory
-pub fn allocRenderTextZPartials(allocator: Allocator, template_text: []const u8, partials: anytype, data: anytype) (Allocator.Error || ParseError)![:0]const u8 {
+pub fn allocRenderTextZPartials(allocator: Allocator, template_text: []const u8, partials: anytype, data: anytype) (Allocator.Error || ParseError || StreamError)![:0]const u8 {
     return try allocRenderTextZPartialsWithOptions(allocator, template_text, partials, data, .{});
 }
 
@@ -260,53 +291,53 @@ pub fn allocRenderTextZPartials(allocator: Allocator, template_text: []const u8,
 /// `partials` can be a tuple, an array, slice or a HashMap containing the partial's name as key and the template text as value
 /// `options` defines the behavior of the parser and render process
 /// Caller must free the memory
-pub fn allocRenderTextZPartialsWithOptions(allocator: Allocator, template_text: []const u8, partials: anytype, data: anytype, comptime options: mustache.options.RenderFromStringOptions) (Allocator.Error || ParseError)![:0]const u8 {
+pub fn allocRenderTextZPartialsWithOptions(allocator: Allocator, template_text: []const u8, partials: anytype, data: anytype, comptime options: mustache.options.RenderFromStringOptions) (Allocator.Error || ParseError || StreamError)![:0]const u8 {
     const render_options = RenderOptions{ .string = options };
     return try internalAllocCollect(allocator, template_text, partials, data, render_options, '\x00');
 }
 
 /// Parses the file indicated by `template_absolute_path` and renders with the given `data` to a `writer`
-pub fn renderFile(allocator: Allocator, template_absolute_path: []const u8, data: anytype, writer: anytype) (Allocator.Error || ParseError || FileError || @TypeOf(writer).Error)!void {
+pub fn renderFile(allocator: Allocator, template_absolute_path: []const u8, data: anytype, writer: anytype) (Allocator.Error || ParseError || FileError || StreamError || @TypeOf(writer).Error)!void {
     try renderFilePartialsWithOptions(allocator, template_absolute_path, {}, data, writer, .{});
 }
 
 /// Parses the file indicated by `template_absolute_path` and renders with the given `data` to a `writer`
 /// `options` defines the behavior of the parser and render process
-pub fn renderFileWithOptions(allocator: Allocator, template_absolute_path: []const u8, data: anytype, writer: anytype, comptime options: mustache.options.RenderFromFileOptions) (Allocator.Error || ParseError || FileError || @TypeOf(writer).Error)!void {
+pub fn renderFileWithOptions(allocator: Allocator, template_absolute_path: []const u8, data: anytype, writer: anytype, comptime options: mustache.options.RenderFromFileOptions) (Allocator.Error || ParseError || FileError || StreamError || @TypeOf(writer).Error)!void {
     try renderFilePartialsWithOptions(allocator, template_absolute_path, {}, data, writer, options);
 }
 
 /// Parses the file indicated by `template_absolute_path` and renders with the given `data` to a `writer`
 /// `partials` can be a tuple, an array, slice or a HashMap containing the partial's name as key and the template absolute path as value
-pub fn renderFilePartials(allocator: Allocator, template_absolute_path: []const u8, partials: anytype, data: anytype, writer: anytype) (Allocator.Error || ParseError || FileError || @TypeOf(writer).Error)!void {
+pub fn renderFilePartials(allocator: Allocator, template_absolute_path: []const u8, partials: anytype, data: anytype, writer: anytype) (Allocator.Error || ParseError || FileError || StreamError || @TypeOf(writer).Error)!void {
     try renderFilePartialsWithOptions(allocator, template_absolute_path, partials, data, writer, .{});
 }
 
 /// Parses the file indicated by `template_absolute_path` and renders with the given `data` to a `writer`
 /// `partials` can be a tuple, an array, slice or a HashMap containing the partial's name as key and the template absolute path as value
 /// `options` defines the behavior of the parser and render process
-pub fn renderFilePartialsWithOptions(allocator: Allocator, template_absolute_path: []const u8, partials: anytype, data: anytype, writer: anytype, comptime options: mustache.options.RenderFromFileOptions) (Allocator.Error || ParseError || FileError || @TypeOf(writer).Error)!void {
+pub fn renderFilePartialsWithOptions(allocator: Allocator, template_absolute_path: []const u8, partials: anytype, data: anytype, writer: anytype, comptime options: mustache.options.RenderFromFileOptions) (Allocator.Error || ParseError || FileError || StreamError || @TypeOf(writer).Error)!void {
     const render_options = RenderOptions{ .file = options };
     try internalCollect(allocator, template_absolute_path, partials, data, writer, render_options);
 }
 
 /// Parses the file indicated by `template_absolute_path` and renders with the given `data` and returns an owned slice with the content.
 /// Caller must free the memory
-pub fn allocRenderFile(allocator: Allocator, template_absolute_path: []const u8, data: anytype) (Allocator.Error || ParseError || FileError)![]const u8 {
+pub fn allocRenderFile(allocator: Allocator, template_absolute_path: []const u8, data: anytype) (Allocator.Error || ParseError || FileError || StreamError)![]const u8 {
     return try allocRenderFilePartialsWithOptions(allocator, template_absolute_path, {}, data, .{});
 }
 
 /// Parses the file indicated by `template_absolute_path` and renders with the given `data` and returns an owned slice with the content.
 /// `options` defines the behavior of the parser and render process
 /// Caller must free the memory
-pub fn allocRenderFileWithOptions(allocator: Allocator, template_absolute_path: []const u8, data: anytype, comptime options: mustache.options.RenderFromFileOptions) (Allocator.Error || ParseError || FileError)![]const u8 {
+pub fn allocRenderFileWithOptions(allocator: Allocator, template_absolute_path: []const u8, data: anytype, comptime options: mustache.options.RenderFromFileOptions) (Allocator.Error || ParseError || FileError || StreamError)![]const u8 {
     return try allocRenderFilePartialsWithOptions(allocator, template_absolute_path, {}, data, options);
 }
 
 /// Parses the file indicated by `template_absolute_path` and renders with the given `data` and returns an owned slice with the content.
 /// `partials` can be a tuple, an array, slice or a HashMap containing the partial's name as key and the template absolute path as value
 /// Caller must free the memory
-pub fn allocRenderFilePartials(allocator: Allocator, template_absolute_path: []const u8, partials: anytype, data: anytype) (Allocator.Error || ParseError || FileError)![]const u8 {
+pub fn allocRenderFilePartials(allocator: Allocator, template_absolute_path: []const u8, partials: anytype, data: anytype) (Allocator.Error || ParseError || FileError || StreamError)![]const u8 {
     return try allocRenderFilePartialsWithOptions(allocator, template_absolute_path, partials, data, .{});
 }
 
@@ -314,28 +345,28 @@ pub fn allocRenderFilePartials(allocator: Allocator, template_absolute_path: []c
 /// `partials` can be a tuple, an array, slice or a HashMap containing the partial's name as key and the template absolute path as value
 /// `options` defines the behavior of the parser and render process
 /// Caller must free the memory
-pub fn allocRenderFilePartialsWithOptions(allocator: Allocator, template_absolute_path: []const u8, partials: anytype, data: anytype, comptime options: mustache.options.RenderFromFileOptions) (Allocator.Error || ParseError || FileError)![]const u8 {
+pub fn allocRenderFilePartialsWithOptions(allocator: Allocator, template_absolute_path: []const u8, partials: anytype, data: anytype, comptime options: mustache.options.RenderFromFileOptions) (Allocator.Error || ParseError || FileError || StreamError)![]const u8 {
     const render_options = RenderOptions{ .file = options };
     return try internalAllocCollect(allocator, template_absolute_path, partials, data, render_options, null);
 }
 
 /// Parses the file indicated by `template_absolute_path` and renders with the given `data` and returns an owned slice with the content.
 /// Caller must free the memory
-pub fn allocRenderFileZ(allocator: Allocator, template_absolute_path: []const u8, data: anytype) (Allocator.Error || ParseError || FileError)![]const u8 {
+pub fn allocRenderFileZ(allocator: Allocator, template_absolute_path: []const u8, data: anytype) (Allocator.Error || ParseError || FileError || StreamError)![]const u8 {
     return try allocRenderFileZPartialsWithOptions(allocator, template_absolute_path, {}, data, .{});
 }
 
 /// Parses the file indicated by `template_absolute_path` and renders with the given `data` and returns an owned slice with the content.
 /// `options` defines the behavior of the parser and render process
 /// Caller must free the memory
-pub fn allocRenderFileZWithOptions(allocator: Allocator, template_absolute_path: []const u8, data: anytype, comptime options: mustache.options.RenderFromFileOptions) (Allocator.Error || ParseError || FileError)![]const u8 {
+pub fn allocRenderFileZWithOptions(allocator: Allocator, template_absolute_path: []const u8, data: anytype, comptime options: mustache.options.RenderFromFileOptions) (Allocator.Error || ParseError || FileError || StreamError)![]const u8 {
     return try allocRenderFileZPartialsWithOptions(allocator, template_absolute_path, {}, data, options);
 }
 
 /// Parses the file indicated by `template_absolute_path` and renders with the given `data` and returns an owned slice with the content.
 /// `partials` can be a tuple, an array, slice or a HashMap containing the partial's name as key and the template absolute path as value
 /// Caller must free the memory
-pub fn allocRenderFileZPartials(allocator: Allocator, template_absolute_path: []const u8, partials: anytype, data: anytype) (Allocator.Error || ParseError || FileError)![]const u8 {
+pub fn allocRenderFileZPartials(allocator: Allocator, template_absolute_path: []const u8, partials: anytype, data: anytype) (Allocator.Error || ParseError || FileError || StreamError)![]const u8 {
     return try allocRenderFileZPartialsWithOptions(allocator, template_absolute_path, partials, data, .{});
 }
 
@@ -343,21 +374,33 @@ pub fn allocRenderFileZPartials(allocator: Allocator, template_absolute_path: []
 /// `partials` can be a tuple, an array, slice or a HashMap containing the partial's name as key and the template absolute path as value
 /// `options` defines the behavior of the parser and render process
 /// Caller must free the memory
-pub fn allocRenderFileZPartialsWithOptions(allocator: Allocator, template_absolute_path: []const u8, partials: anytype, data: anytype, comptime options: mustache.options.RenderFromFileOptions) (Allocator.Error || ParseError || FileError)![:0]const u8 {
+pub fn allocRenderFileZPartialsWithOptions(allocator: Allocator, template_absolute_path: []const u8, partials: anytype, data: anytype, comptime options: mustache.options.RenderFromFileOptions) (Allocator.Error || ParseError || FileError || StreamError)![:0]const u8 {
     const render_options = RenderOptions{ .file = options };
     return try internalAllocCollect(allocator, template_absolute_path, partials, data, render_options, '\x00');
 }
 
-fn internalRender(template: Template, partials: anytype, data: anytype, writer: anytype, comptime options: RenderOptions) !void {
+/// Renders looking up escaped strings in the `cache`, see `EscapeCache.renderPartialsWithOptions`
+pub fn renderWithEscapeCache(cache: *EscapeCache, template: Template, partials: anytype, data: anytype, writer: anytype, comptime options: mustache.options.RenderFromTemplateOptions) !void {
+    const render_options = RenderOptions{ .template = options };
+    try internalRender(template, partials, data, writer, render_options, cache);
+}
+
+/// Renders looking up escaped strings in the `cache`, see `EscapeCache.allocRenderPartialsWithOptions`
+pub fn allocRenderWithEscapeCache(cache: *EscapeCache, allocator: Allocator, template: Template, partials: anytype, data: anytype, comptime options: mustache.options.RenderFromTemplateOptions) (Allocator.Error || StreamError)![]const u8 {
+    const render_options = RenderOptions{ .template = options };
+    return try internalAllocRender(allocator, template, partials, data, render_options, null, cache);
+}
+
+fn internalRender(template: Template, partials: anytype, data: anytype, writer: anytype, comptime options: RenderOptions, cache: ?*EscapeCache) !void {
     comptime assert(options == .template);
 
     const PartialsMap = map.PartialsMap(@TypeOf(partials), options);
     const Engine = RenderEngine(@TypeOf(writer), PartialsMap, options);
 
-    try Engine.render(template, data, writer, PartialsMap.init(partials));
+    try Engine.render(template, data, writer, PartialsMap.init(partials), cache);
 }
 
-fn internalAllocRender(allocator: Allocator, template: Template, partials: anytype, data: anytype, comptime options: RenderOptions, comptime sentinel: ?u8) !if (sentinel) |z| [:z]const u8 else []const u8 {
+fn internalAllocRender(allocator: Allocator, template: Template, partials: anytype, data: anytype, comptime options: RenderOptions, comptime sentinel: ?u8, cache: ?*EscapeCache) !if (sentinel) |z| [:z]const u8 else []const u8 {
     comptime assert(options == .template);
 
     var list = std.ArrayList(u8).init(allocator);
@@ -367,7 +410,16 @@ fn internalAllocRender(allocator: Allocator, template: Template, partials: anyty
     const PartialsMap = map.PartialsMap(@TypeOf(partials), options);
     const Engine = RenderEngine(Writer, PartialsMap, options);
 
-    try Engine.bufRender(list.writer(), template, data, PartialsMap.init(partials));
+    const capacity_hint = switch (comptime options.template.preallocation) {
+        .capacity_hint => true,
+        .output_bound => if (bounds.outputBound(template, @TypeOf(data))) |bound| bounded: {
+            // The output never grows past the bound, no need to walk the template for a hint
+            try list.ensureTotalCapacityPrecise(bound + @boolToInt(sentinel != null));
+            break :bounded false;
+        } else true,
+    };
+
+    try Engine.bufRender(list.writer(), template, data, PartialsMap.init(partials), capacity_hint, cache);
 
     return if (comptime sentinel) |z|
         list.toOwnedSliceSentinel(z)
@@ -402,6 +454,83 @@ fn internalAllocCollect(allocator: Allocator, template: []const u8, partials: an
         list.toOwnedSlice();
 }
 
+/// Returns true if no tag name of the enum contains HTML special chars
+fn escapeFree(comptime Enum: type) bool {
+    comptime {
+        for (meta.fieldNames(Enum)) |name| {
+            if (std.mem.indexOfAny(u8, name, "<>&\"") != null) return false;
+        }
+
+        return true;
+    }
+}
+
+/// Chunk size used to stream readers and files into the output
+const stream_buffer_size = 4 * 1024;
+
+/// Returns true if the type is a `std.io.Reader`
+fn isReader(comptime T: type) bool {
+    return switch (@typeInfo(T)) {
+        .Struct => @hasField(T, "context") and @hasDecl(T, "Error") and @hasDecl(T, "read") and @hasDecl(T, "readAll"),
+        else => false,
+    };
+}
+
+/// Narrows `err` to the error set `E`, or returns null if it is not part of it
+fn narrowError(comptime E: type, err: anyerror) ?E {
+    inline for (@typeInfo(E).ErrorSet.?) |item| {
+        if (err == @field(E, item.name)) return @field(E, item.name);
+    }
+
+    return null;
+}
+
+/// Returns true if the type renders itself through a `mustacheWrite` or `format` function
+fn hasWriteHook(comptime T: type) bool {
+    return switch (@typeInfo(T)) {
+        .Struct, .Union, .Enum, .Opaque => hasMustacheWrite(T) or hasFormat(T),
+        else => false,
+    };
+}
+
+/// `pub fn mustacheWrite(self: T, writer: anytype) !void`
+fn hasMustacheWrite(comptime T: type) bool {
+    return hasHookFn(T, "mustacheWrite", &.{null});
+}
+
+/// `pub fn format(self: T, comptime fmt: []const u8, options: std.fmt.FormatOptions, writer: anytype) !void`
+fn hasFormat(comptime T: type) bool {
+    return hasHookFn(T, "format", &.{ []const u8, std.fmt.FormatOptions, null });
+}
+
+/// Returns true if `T` declares a function `name` taking the value, by value or const pointer, followed by `args`.
+/// A null arg stands for `anytype`
+fn hasHookFn(comptime T: type, comptime name: []const u8, comptime args: []const ?type) bool {
+    comptime {
+        if (!trait.hasFn(name)(T)) return false;
+
+        const info = @typeInfo(@TypeOf(@field(T, name))).Fn;
+        if (info.args.len != args.len + 1) return false;
+
+        if (info.args[0].arg_type) |Self| {
+            if (Self != T and Self != *const T) return false;
+        }
+
+        for (args) |expected, index| {
+            if (info.args[index + 1].arg_type) |Arg| {
+                if (expected == null or Arg != expected.?) return false;
+            }
+        }
+
+        const Return = info.return_type orelse return true;
+        return switch (@typeInfo(Return)) {
+            .ErrorUnion => |error_union| error_union.payload == void,
+            .Void => true,
+            else => false,
+        };
+    }
+}
+
 /// Group functions and structs that are denpendent of Writer and RenderOptions
 pub fn RenderEngine(comptime Writer: type, comptime PartialsMap: type, comptime options: RenderOptions) type {
     return struct {
@@ -424,13 +553,34 @@ pub fn RenderEngine(comptime Writer: type, comptime PartialsMap: type, comptime
 
         pub const DataRender = struct {
             const Self = @This();
-            pub const Error = Allocator.Error || Writer.Error;
+            pub const Error = Allocator.Error || Writer.Error || StreamError;
+
+            const float_format = switch (options) {
+                .template => |template_options| template_options.float_format,
+                .string => |string_options| string_options.float_format,
+                .file => |file_options| file_options.float_format,
+            };
+
+            const object_slot_hints = switch (options) {
+                .template => |template_options| template_options.object_slot_hints,
+                .string, .file => true,
+            };
 
             out_writer: OutWriter,
             stack: *const ContextStack,
             partials_map: PartialsMap,
             indentation_queue: *IndentationQueue,
             template_options: if (options == .template) *const TemplateOptions else void,
+            block_scope: ?*const BlockScope = null,
+
+            /// Looks up escaped strings, when rendering through an `EscapeCache`
+            escape_cache: ?*EscapeCache = null,
+
+            /// Reserves the buffer capacity before rendering each level, disabled when the buffer is already preallocated
+            capacity_hint: bool = true,
+
+            /// Positions of the names found in `std.json` objects during this render
+            object_slots: if (object_slot_hints) ObjectSlots else void = if (object_slot_hints) .{} else {},
 
             pub fn collect(self: *Self, allocator: Allocator, template: []const u8) !void {
                 switch (comptime options) {
@@ -469,7 +619,7 @@ pub fn RenderEngine(comptime Writer: type, comptime PartialsMap: type, comptime
 
             pub fn render(self: *Self, elements: []const Element) !void {
                 switch (self.out_writer) {
-                    .buffer => |buffer| {
+                    .buffer => |buffer| if (self.capacity_hint) {
                         var list = buffer.context;
                         const capacity_hint = self.levelCapacityHint(elements);
 
@@ -502,7 +652,7 @@ pub fn RenderEngine(comptime Writer: type, comptime PartialsMap: type, comptime
             fn renderLevel(
                 self: *Self,
                 elements: []const Element,
-            ) (Allocator.Error || Writer.Error)!void {
+            ) (Allocator.Error || Writer.Error || StreamError)!void {
                 var index: usize = 0;
                 while (index < elements.len) {
                     const element = elements[index];
@@ -516,6 +666,10 @@ pub fn RenderEngine(comptime Writer: type, comptime PartialsMap: type, comptime
                             const section_children = elements[index .. index + section.children_count];
                             index += section.children_count;
 
+                            // Fused inverted section, rendered when the path evaluates as "false"
+                            const else_children = elements[index .. index + section.else_count];
+                            index += section.else_count;
+
                             if (self.getIterator(section.path)) |*iterator| {
                                 if (self.lambdasSupported()) {
                                     if (iterator.lambda()) |lambda_ctx| {
@@ -528,6 +682,11 @@ pub fn RenderEngine(comptime Writer: type, comptime PartialsMap: type, comptime
                                     }
                                 }
 
+                                if (!iterator.truthy()) {
+                                    try self.renderLevel(else_children);
+                                    continue;
+                                }
+
                                 while (iterator.next()) |item_ctx| {
                                     var current_level = self.stack;
                                     self.stack = &ContextStack{
@@ -538,6 +697,8 @@ pub fn RenderEngine(comptime Writer: type, comptime PartialsMap: type, comptime
                                     defer self.stack = current_level;
                                     try self.renderLevel(section_children);
                                 }
+                            } else {
+                                try self.renderLevel(else_children);
                             }
                         },
                         .inverted_section => |section| {
@@ -546,8 +707,14 @@ pub fn RenderEngine(comptime Writer: type, comptime PartialsMap: type, comptime
 
                             // Lambdas aways evaluate as "true" for inverted section
                             // Broken paths, empty lists, null and false evaluates as "false"
-
-                            const truthy = if (self.getIterator(section.path)) |iterator| iterator.truthy() else false;
+                            // Iterators are peeked, fetching the first item would consume it from an iterator advanced in place
+
+                            const truthy = if (self.getForwardOnly(section.path)) |sequence|
+                                sequence.peek()
+                            else if (self.getIterator(section.path)) |iterator|
+                                iterator.truthy()
+                            else
+                                false;
                             if (!truthy) {
                                 try self.renderLevel(section_children);
                             }
@@ -557,30 +724,65 @@ pub fn RenderEngine(comptime Writer: type, comptime PartialsMap: type, comptime
                             if (comptime PartialsMap.isEmpty()) continue;
 
                             if (self.partials_map.get(partial.key)) |partial_template| {
-                                if (self.preseveLineBreaksAndIndentation()) {
-                                    if (partial.indentation) |value| {
-                                        const prev_has_pending = self.indentation_queue.has_pending;
-                                        self.indentation_queue.indent(&IndentationQueue.Node{ .indentation = value });
-                                        self.indentation_queue.has_pending = true;
-
-                                        defer {
-                                            self.indentation_queue.unindent();
-                                            self.indentation_queue.has_pending = prev_has_pending;
-                                        }
-
-                                        try self.renderLevelPartials(partial_template);
-                                        continue;
-                                    }
-                                }
+                                try self.renderIndentedPartial(partial_template, partial.indentation);
+                            }
+                        },
+
+                        .parent => |parent| {
+                            const parent_children = elements[index .. index + parent.children_count];
+                            index += parent.children_count;
+
+                            if (comptime PartialsMap.isEmpty()) continue;
 
-                                try self.renderLevelPartials(partial_template);
+                            // Only the blocks declared inside the parent tag are passed as overrides,
+                            // any other content is ignored
+                            if (self.partials_map.get(parent.key)) |parent_template| {
+                                const current_scope = self.block_scope;
+                                self.block_scope = &BlockScope{
+                                    .parent = current_scope,
+                                    .elements = parent_children,
+                                };
+
+                                defer self.block_scope = current_scope;
+                                try self.renderIndentedPartial(parent_template, parent.indentation);
                             }
                         },
 
-                        //TODO Parent, Block
-                        else => {},
+                        .block => |block| {
+                            const block_children = elements[index .. index + block.children_count];
+                            index += block.children_count;
+
+                            const content = if (self.block_scope) |scope| scope.find(block.key) orelse block_children else block_children;
+                            try self.renderLevel(content);
+                        },
+                    }
+                }
+            }
+
+            fn renderIndentedPartial(
+                self: *Self,
+                partial_template: PartialsMap.Template,
+                indentation: ?[]const u8,
+            ) !void {
+                comptime assert(!PartialsMap.isEmpty());
+
+                if (self.preseveLineBreaksAndIndentation()) {
+                    if (indentation) |value| {
+                        const prev_has_pending = self.indentation_queue.has_pending;
+                        self.indentation_queue.indent(&IndentationQueue.Node{ .indentation = value });
+                        self.indentation_queue.has_pending = true;
+
+                        defer {
+                            self.indentation_queue.unindent();
+                            self.indentation_queue.has_pending = prev_has_pending;
+                        }
+
+                        try self.renderLevelPartials(partial_template);
+                        return;
                     }
                 }
+
+                try self.renderLevelPartials(partial_template);
             }
 
             fn renderLevelPartials(
@@ -603,7 +805,7 @@ pub fn RenderEngine(comptime Writer: type, comptime PartialsMap: type, comptime
                 self: *Self,
                 path: Element.Path,
                 escape: Escape,
-            ) (Allocator.Error || Writer.Error)!void {
+            ) (Allocator.Error || Writer.Error || StreamError)!void {
                 var level: ?*const ContextStack = self.stack;
 
                 while (level) |current| : (level = current.parent) {
@@ -663,11 +865,35 @@ pub fn RenderEngine(comptime Writer: type, comptime PartialsMap: type, comptime
                 return null;
             }
 
+            /// Returns the hints for `std.json` object lookups, or null if disabled by the render options
+            pub inline fn objectSlots(self: *Self) ?*ObjectSlots {
+                return if (comptime object_slot_hints) &self.object_slots else null;
+            }
+
+            /// Returns the context of the path if it is a forward-only sequence, resolved without fetching any item
+            fn getForwardOnly(
+                self: *Self,
+                path: Element.Path,
+            ) ?Context {
+                var level: ?*const ContextStack = self.stack;
+
+                while (level) |current| : (level = current.parent) {
+                    switch (current.ctx.get(path)) {
+                        .field => |found| return if (found.isForwardOnly()) found else null,
+                        .lambda => return null,
+                        .iterator_consumed, .chain_broken => break,
+                        .not_found_in_context => continue,
+                    }
+                }
+
+                return null;
+            }
+
             pub fn write(
                 self: *Self,
                 value: anytype,
                 escape: Escape,
-            ) (Allocator.Error || Writer.Error)!void {
+            ) (Allocator.Error || Writer.Error || StreamError)!void {
                 switch (self.out_writer) {
                     .writer => |writer| switch (escape) {
                         .Escaped => try self.recursiveWrite(writer, value, .Escaped),
@@ -680,11 +906,30 @@ pub fn RenderEngine(comptime Writer: type, comptime PartialsMap: type, comptime
                 }
             }
 
+            /// Writes a string held in a temporary buffer, skipping the escape cache,
+            /// since the buffer's content is overwritten after this call
+            pub fn writeTransient(
+                self: *Self,
+                value: []const u8,
+                escape: Escape,
+            ) (Allocator.Error || Writer.Error)!void {
+                switch (self.out_writer) {
+                    .writer => |writer| switch (escape) {
+                        .Escaped => try self.flushToWriter(writer, value, .Escaped),
+                        .Unescaped => try self.flushToWriter(writer, value, .Unescaped),
+                    },
+                    .buffer => |buffer| switch (escape) {
+                        .Escaped => try self.flushToWriter(buffer, value, .Escaped),
+                        .Unescaped => try self.flushToWriter(buffer, value, .Unescaped),
+                    },
+                }
+            }
+
             pub fn countWrite(
                 self: *Self,
                 value: anytype,
                 escape: Escape,
-            ) (Allocator.Error || Writer.Error)!usize {
+            ) (Allocator.Error || Writer.Error || StreamError)!usize {
                 switch (self.out_writer) {
                     .writer => |writer| {
                         var counter = std.io.countingWriter(writer);
@@ -714,29 +959,50 @@ pub fn RenderEngine(comptime Writer: type, comptime PartialsMap: type, comptime
                 writer: anytype,
                 value: anytype,
                 comptime escape: Escape,
-            ) (Allocator.Error || Writer.Error)!void {
+            ) (Allocator.Error || Writer.Error || StreamError)!void {
                 const TValue = @TypeOf(value);
 
+                if (comptime hasWriteHook(TValue) or (trait.isSingleItemPtr(TValue) and hasWriteHook(meta.Child(TValue)))) {
+                    return try self.writeHook(writer, value, escape);
+                }
+
+                // Booleans and numbers never contain HTML special chars,
+                // they are written unescaped, skipping the escape scan
                 switch (@typeInfo(TValue)) {
-                    .Bool => try self.flushToWriter(writer, if (value) "true" else "false", escape),
-                    .Int, .ComptimeInt => {
-                        var buf: [128]u8 = undefined;
-                        const size = std.fmt.formatIntBuf(&buf, value, 10, .lower, .{});
-                        try self.flushToWriter(writer, buf[0..size], escape);
+                    .Bool => try self.flushToWriter(writer, if (value) "true" else "false", .Unescaped),
+                    .Int => {
+                        var buffer: numbers.IntBuffer(TValue) = undefined;
+                        try self.writeIndentation(writer);
+                        try writer.writeAll(numbers.formatInt(value, &buffer));
                     },
+                    .ComptimeInt => try self.recursiveWrite(writer, @as(std.math.IntFittingRange(value, value), value), escape),
                     .Float, .ComptimeFloat => {
-                        var buf: [128]u8 = undefined;
-                        var fbs = std.io.fixedBufferStream(&buf);
-                        std.fmt.formatFloatDecimal(value, .{}, fbs.writer()) catch unreachable;
-                        try self.flushToWriter(writer, buf[0..fbs.pos], escape);
+                        try self.writeIndentation(writer);
+                        try numbers.formatFloat(value, float_format, writer);
+                    },
+                    .Enum => try self.flushToWriter(writer, @tagName(value), if (comptime escapeFree(TValue)) .Unescaped else escape),
+                    .Struct => {
+                        if (TValue == SafeHtml) {
+                            try self.flushToWriter(writer, value.value, .Unescaped);
+                        } else if (TValue == FileRange) {
+                            try self.writeFileRange(writer, value, escape);
+                        } else if (comptime isReader(TValue)) {
+                            try self.writeReader(writer, value, escape);
+                        }
                     },
-                    .Enum => try self.flushToWriter(writer, @tagName(value), escape),
 
                     .Pointer => |info| switch (info.size) {
-                        .One => return try self.recursiveWrite(writer, value.*, escape),
+                        .One => {
+                            // Strings are written in place, without copying the array
+                            if (comptime trait.isPtrTo(.Array)(TValue) and meta.Elem(TValue) == u8) {
+                                return try self.flushString(writer, value, escape);
+                            }
+
+                            return try self.recursiveWrite(writer, value.*, escape);
+                        },
                         .Slice => {
                             if (info.child == u8) {
-                                try self.flushToWriter(writer, value, escape);
+                                try self.flushString(writer, value, escape);
                             }
                         },
                         .Many => @compileError("[*] pointers not supported"),
@@ -744,7 +1010,7 @@ pub fn RenderEngine(comptime Writer: type, comptime PartialsMap: type, comptime
                     },
                     .Array => |info| {
                         if (info.child == u8) {
-                            try self.flushToWriter(writer, &value, escape);
+                            try self.flushString(writer, &value, escape);
                         }
                     },
                     .Optional => {
@@ -756,6 +1022,129 @@ pub fn RenderEngine(comptime Writer: type, comptime PartialsMap: type, comptime
                 }
             }
 
+            /// Calls the `mustacheWrite` or `format` function declared by the value's type,
+            /// passing a writer that escapes and indents the output.
+            /// The function must return only the errors of that writer.
+            fn writeHook(
+                self: *Self,
+                writer: anytype,
+                value: anytype,
+                comptime escape: Escape,
+            ) @TypeOf(writer).Error!void {
+                const TValue = if (comptime trait.isSingleItemPtr(@TypeOf(value))) meta.Child(@TypeOf(value)) else @TypeOf(value);
+                const Hook = HookWriter(@TypeOf(writer), escape);
+
+                const hook_writer = Hook.Stream{
+                    .context = .{
+                        .data_render = self,
+                        .writer = writer,
+                    },
+                };
+
+                if (comptime hasMustacheWrite(TValue)) {
+                    try value.mustacheWrite(hook_writer);
+                } else {
+                    try value.format("", .{}, hook_writer);
+                }
+            }
+
+            fn HookWriter(comptime UnderlyingWriter: type, comptime escape: Escape) type {
+                return struct {
+                    const Hook = @This();
+                    pub const Stream = std.io.Writer(Hook, UnderlyingWriter.Error, write);
+
+                    data_render: *Self,
+                    writer: UnderlyingWriter,
+
+                    fn write(hook: Hook, bytes: []const u8) UnderlyingWriter.Error!usize {
+                        try hook.data_render.flushToWriter(hook.writer, bytes, escape);
+                        return bytes.len;
+                    }
+                };
+            }
+
+            /// Streams the reader into the output in chunks
+            fn writeReader(
+                self: *Self,
+                writer: anytype,
+                reader: anytype,
+                comptime escape: Escape,
+            ) (@TypeOf(writer).Error || StreamError)!void {
+                var buffer: [stream_buffer_size]u8 = undefined;
+                while (true) {
+                    const len = reader.read(&buffer) catch |err| return narrowError(StreamError, err) orelse error.ReadFailed;
+                    if (len == 0) break;
+
+                    try self.flushToWriter(writer, buffer[0..len], escape);
+                }
+            }
+
+            /// Streams a range of the file into the output.
+            /// Unescaped values rendered into a file are copied by the kernel, using `sendfile` or `copy_file_range`.
+            fn writeFileRange(
+                self: *Self,
+                writer: anytype,
+                range: FileRange,
+                comptime escape: Escape,
+            ) (@TypeOf(writer).Error || StreamError)!void {
+                if (comptime escape == .Unescaped and @TypeOf(writer) == std.fs.File.Writer) {
+                    if (self.indentationEmpty()) {
+                        writer.context.writeFileAll(range.file, .{ .in_offset = range.offset, .in_len = range.len }) catch |err| {
+                            if (narrowError(@TypeOf(writer).Error, err)) |write_error| return write_error;
+                            return narrowError(StreamError, err) orelse error.ReadFailed;
+                        };
+
+                        return;
+                    }
+                }
+
+                var buffer: [stream_buffer_size]u8 = undefined;
+                var offset = range.offset;
+                var remaining = range.len orelse std.math.maxInt(u64);
+                while (remaining > 0) {
+                    const max_len = @intCast(usize, std.math.min(remaining, buffer.len));
+                    const len = try range.file.pread(buffer[0..max_len], offset);
+                    if (len == 0) break;
+
+                    try self.flushToWriter(writer, buffer[0..len], escape);
+                    offset += len;
+                    remaining -= len;
+                }
+            }
+
+            inline fn indentationEmpty(self: *Self) bool {
+                if (comptime PartialsMap.isEmpty()) return true;
+                return self.indentation_queue.isEmpty() or !self.preseveLineBreaksAndIndentation();
+            }
+
+            /// Writes the pending indentation, before a value known to have no line breaks
+            fn writeIndentation(self: *Self, writer: anytype) @TypeOf(writer).Error!void {
+                if (comptime !PartialsMap.isEmpty()) {
+                    if (self.indentation_queue.has_pending and !self.indentation_queue.isEmpty() and self.preseveLineBreaksAndIndentation()) {
+                        self.indentation_queue.has_pending = false;
+                        try self.indentation_queue.write(writer);
+                    }
+                }
+            }
+
+            /// Flushes a string value, looking up its escaped form in the escape cache, if any
+            fn flushString(
+                self: *Self,
+                writer: anytype,
+                value: []const u8,
+                comptime escape: Escape,
+            ) @TypeOf(writer).Error!void {
+                if (comptime escape == .Escaped) {
+                    if (self.escape_cache) |cache| {
+                        if (cache.fetch(value)) |escaped_value| {
+                            return try self.flushToWriter(writer, escaped_value, .Unescaped);
+                        }
+                    }
+                }
+
+                try self.flushToWriter(writer, value, escape);
+            }
+
             fn flushToWriter(
                 self: *Self,
                 writer: anytype,
@@ -841,7 +1230,18 @@ pub fn RenderEngine(comptime Writer: type, comptime PartialsMap: type, comptime
                             const section_children = elements[index .. index + section.children_count];
                             index += section.children_count;
 
+                            const else_children = elements[index .. index + section.else_count];
+                            index += section.else_count;
+
+                            // Iterators are walked only once, by the render itself
+                            if (self.getForwardOnly(section.path) != null) continue;
+
                             if (self.getIterator(section.path)) |*iterator| {
+                                if (!iterator.truthy()) {
+                                    size += self.levelCapacityHint(else_children);
+                                    continue;
+                                }
+
                                 while (iterator.next()) |item_ctx| {
                                     var current_level = self.stack;
                                     self.stack = &ContextStack{
@@ -853,18 +1253,25 @@ pub fn RenderEngine(comptime Writer: type, comptime PartialsMap: type, comptime
 
                                     size += self.levelCapacityHint(section_children);
                                 }
+                            } else {
+                                size += self.levelCapacityHint(else_children);
                             }
                         },
                         .inverted_section => |section| {
                             const section_children = elements[index .. index + section.children_count];
                             index += section.children_count;
 
+                            if (self.getForwardOnly(section.path) != null) continue;
+
                             const truthy = if (self.getIterator(section.path)) |iterator| iterator.truthy() else false;
                             if (!truthy) {
                                 size += self.levelCapacityHint(section_children);
                             }
                         },
 
+                        // Overrides are not rendered in place
+                        .parent => |parent| index += parent.children_count,
+
                         else => {},
                     }
                 }
@@ -907,12 +1314,15 @@ pub fn RenderEngine(comptime Writer: type, comptime PartialsMap: type, comptime
 
                 switch (@typeInfo(TValue)) {
                     .Bool => return 5,
-                    .Int,
-                    .ComptimeInt,
-                    .Float,
-                    .ComptimeFloat,
-                    => return std.fmt.count("{d}", .{value}),
+                    .Int => return numbers.intLen(value),
+                    .ComptimeInt => return comptime std.fmt.count("{d}", .{value}),
+                    .Float, .ComptimeFloat => return numbers.float_len_hint,
                     .Enum => return @tagName(value).len,
+                    .Struct => {
+                        if (TValue == SafeHtml) {
+                            return value.value.len;
+                        }
+                    },
                     .Pointer => |info| switch (info.size) {
                         .One => return self.valueCapacityHint(value.*),
                         .Slice => {
@@ -940,7 +1350,7 @@ pub fn RenderEngine(comptime Writer: type, comptime PartialsMap: type, comptime
             }
         };
 
-        pub fn render(template: Template, data: anytype, writer: Writer, partials_map: PartialsMap) !void {
+        pub fn render(template: Template, data: anytype, writer: Writer, partials_map: PartialsMap, cache: ?*EscapeCache) !void {
             comptime assert(options == .template);
 
             const Data = @TypeOf(data);
@@ -961,12 +1371,13 @@ pub fn RenderEngine(comptime Writer: type, comptime PartialsMap: type, comptime
                 },
                 .indentation_queue = &indentation_queue,
                 .template_options = template.options,
+                .escape_cache = cache,
             };
 
             try data_render.render(template.elements);
         }
 
-        pub fn bufRender(writer: std.ArrayList(u8).Writer, template: Template, data: anytype, partials_map: PartialsMap) !void {
+        pub fn bufRender(writer: std.ArrayList(u8).Writer, template: Template, data: anytype, partials_map: PartialsMap, capacity_hint: bool, cache: ?*EscapeCache) !void {
             comptime assert(options == .template);
 
             const Data = @TypeOf(data);
@@ -987,6 +1398,8 @@ pub fn RenderEngine(comptime Writer: type, comptime PartialsMap: type, comptime
                 },
                 .indentation_queue = &indentation_queue,
                 .template_options = template.options,
+                .capacity_hint = capacity_hint,
+                .escape_cache = cache,
             };
 
             try data_render.render(template.elements);
@@ -1052,6 +1465,11 @@ test {
     _ = context;
     _ = map;
     _ = indent;
+    _ = bounds;
+    _ = escape_cache;
+    _ = numbers;
+    _ = json_stream;
+    _ = csv_stream;
 
     _ = tests.spec;
     _ = tests.extra;
@@ -3165,6 +3583,224 @@ const tests = struct {
                 try expectRenderPartials(template_text, partials_template_text, data, expected);
             }
         };
+
+        const inheritance = struct {
+
+            // Default content should be rendered if the block isn't overridden
+            test "Default" {
+                const template_text = "{{$title}}Default title{{/title}}\n";
+                const expected = "Default title\n";
+
+                var data = .{};
+                try expectRender(template_text, data, expected);
+            }
+
+            // Default content renders variables
+            test "Variable" {
+                const template_text = "{{$foo}}default {{bar}} content{{/foo}}\n";
+                const expected = "default baz content\n";
+
+                var data = .{ .bar = "baz" };
+                try expectRender(template_text, data, expected);
+            }
+
+            // Default content renders triple mustache variables
+            test "Triple Mustache" {
+                const template_text = "{{$foo}}default {{{bar}}} content{{/foo}}\n";
+                const expected = "default <baz> content\n";
+
+                var data = .{ .bar = "<baz>" };
+                try expectRender(template_text, data, expected);
+            }
+
+            // Default content renders sections
+            test "Sections" {
+                const template_text = "{{$foo}}default {{#bar}}{{baz}}{{/bar}} content{{/foo}}\n";
+                const expected = "default qux content\n";
+
+                var data = .{ .bar = .{ .baz = "qux" } };
+                try expectRender(template_text, data, expected);
+            }
+
+            // Default content renders negative sections
+            test "Negative Sections" {
+                const template_text = "{{$foo}}default {{^bar}}{{baz}}{{/bar}} content{{/foo}}\n";
+                const expected = "default three content\n";
+
+                var data = .{ .bar = false, .baz = "three" };
+                try expectRender(template_text, data, expected);
+            }
+
+            // Mustache injection in default content
+            test "Mustache Injection" {
+                const template_text = "{{$foo}}default {{#bar}}{{baz}}{{/bar}} content{{/foo}}\n";
+                const expected = "default {{qux}} content\n";
+
+                var data = .{ .bar = .{ .baz = "{{qux}}" } };
+                try expectRender(template_text, data, expected);
+            }
+
+            // Default content rendered inside inherited templates
+            test "Inherit" {
+                const template_text = "{{<include}}{{/include}}";
+                const partials_template_text = .{
+                    .{ "include", "{{$foo}}default content{{/foo}}" },
+                };
+
+                const expected = "default content";
+
+                var data = .{};
+                try expectRenderPartials(template_text, partials_template_text, data, expected);
+            }
+
+            // Overridden content
+            test "Overridden content" {
+                const template_text = "{{<super}}{{$title}}sub template title{{/title}}{{/super}}";
+                const partials_template_text = .{
+                    .{ "super", "...{{$title}}Default title{{/title}}..." },
+                };
+
+                const expected = "...sub template title...";
+
+                var data = .{};
+                try expectRenderPartials(template_text, partials_template_text, data, expected);
+            }
+
+            // Context does not override argument passed into parent
+            test "Data does not override block" {
+                const template_text = "{{<include}}{{$var}}var in template{{/var}}{{/include}}";
+                const partials_template_text = .{
+                    .{ "include", "{{$var}}var in include{{/var}}" },
+                };
+
+                const expected = "var in template";
+
+                var data = .{ .@"var" = "var in data" };
+                try expectRenderPartials(template_text, partials_template_text, data, expected);
+            }
+
+            // Context does not override default content of block
+            test "Data does not override block default" {
+                const template_text = "{{<include}}{{/include}}";
+                const partials_template_text = .{
+                    .{ "include", "{{$var}}var in include{{/var}}" },
+                };
+
+                const expected = "var in include";
+
+                var data = .{ .@"var" = "var in data" };
+                try expectRenderPartials(template_text, partials_template_text, data, expected);
+            }
+
+            // Overridden parent
+            test "Overridden parent" {
+                const template_text = "test {{<parent}}{{$stuff}}override{{/stuff}}{{/parent}}";
+                const partials_template_text = .{
+                    .{ "parent", "{{$stuff}}...{{/stuff}}" },
+                };
+
+                const expected = "test override";
+
+                var data = .{};
+                try expectRenderPartials(template_text, partials_template_text, data, expected);
+            }
+
+            // Two overridden parents with different content
+            test "Two overridden parents" {
+                const template_text = "test {{<parent}}{{$stuff}}override1{{/stuff}}{{/parent}} {{<parent}}{{$stuff}}override2{{/stuff}}{{/parent}}\n";
+                const partials_template_text = .{
+                    .{ "parent", "|{{$stuff}}...{{/stuff}}{{$default}} default{{/default}}|" },
+                };
+
+                const expected = "test |override1 default| |override2 default|\n";
+
+                var data = .{};
+                try expectRenderPartials(template_text, partials_template_text, data, expected);
+            }
+
+            // Override one substitution but not the other
+            test "Only one override" {
+                const template_text = "{{<parent}}{{$stuff2}}override two{{/stuff2}}{{/parent}}";
+                const partials_template_text = .{
+                    .{ "parent", "{{$stuff}}new default one{{/stuff}}, {{$stuff2}}new default two{{/stuff2}}" },
+                };
+
+                const expected = "new default one, override two";
+
+                var data = .{};
+                try expectRenderPartials(template_text, partials_template_text, data, expected);
+            }
+
+            // Parent templates behave identically to partials when called with no parameters
+            test "Parent template" {
+                const template_text = "{{>parent}}|{{<parent}}{{/parent}}";
+                const partials_template_text = .{
+                    .{ "parent", "{{$foo}}default content{{/foo}}" },
+                };
+
+                const expected = "default content|default content";
+
+                var data = .{};
+                try expectRenderPartials(template_text, partials_template_text, data, expected);
+            }
+
+            // Recursion in inherited templates
+            test "Recursion" {
+                const template_text = "{{<parent}}{{$foo}}override{{/foo}}{{/parent}}";
+                const partials_template_text = .{
+                    .{ "parent", "{{$foo}}default content{{/foo}} {{$bar}}{{<parent2}}{{/parent2}}{{/bar}}" },
+                    .{ "parent2", "{{$foo}}parent2 default content{{/foo}} {{<parent}}{{$bar}}don't recurse{{/bar}}{{/parent}}" },
+                };
+
+                const expected = "override override override don't recurse";
+
+                var data = .{};
+                try expectRenderPartials(template_text, partials_template_text, data, expected);
+            }
+
+            // Top-level substitutions take precedence in multi-level inheritance
+            test "Multi-level inheritance" {
+                const template_text = "{{<parent}}{{$a}}c{{/a}}{{/parent}}";
+                const partials_template_text = .{
+                    .{ "parent", "{{<older}}{{$a}}p{{/a}}{{/older}}" },
+                    .{ "older", "{{<grandParent}}{{$a}}o{{/a}}{{/grandParent}}" },
+                    .{ "grandParent", "{{$a}}g{{/a}}" },
+                };
+
+                const expected = "c";
+
+                var data = .{};
+                try expectRenderPartials(template_text, partials_template_text, data, expected);
+            }
+
+            // Top-level substitutions take precedence in multi-level inheritance
+            test "Multi-level inheritance, no sub child" {
+                const template_text = "{{<parent}}{{/parent}}";
+                const partials_template_text = .{
+                    .{ "parent", "{{<older}}{{$a}}p{{/a}}{{/older}}" },
+                    .{ "older", "{{<grandParent}}{{$a}}o{{/a}}{{/grandParent}}" },
+                    .{ "grandParent", "{{$a}}g{{/a}}" },
+                };
+
+                const expected = "p";
+
+                var data = .{};
+                try expectRenderPartials(template_text, partials_template_text, data, expected);
+            }
+
+            // Ignores text inside parent templates, but does parse $ tags
+            test "Text inside parent" {
+                const template_text = "{{<parent}} asdfasd {{$foo}}hmm{{/foo}} asdfasd{{/parent}}";
+                const partials_template_text = .{
+                    .{ "parent", "{{$foo}}default content{{/foo}}" },
+                };
+
+                const expected = "hmm";
+
+                var data = .{};
+                try expectRenderPartials(template_text, partials_template_text, data, expected);
+            }
+        };
     };
 
     const extra = struct {
@@ -3192,6 +3828,220 @@ const tests = struct {
             try expectRender(template_text, data, expected);
         }
 
+        test "Section with else branch" {
+            const template_text =
+                \\{{#items}}
+                \\- {{.}}
+                \\{{/items}}
+                \\{{^items}}
+                \\No items
+                \\{{/items}}
+                \\{{#flag}}on{{/flag}}{{^flag}}off{{/flag}}|{{#missing}}found{{/missing}}{{^missing}}not found{{/missing}}
+            ;
+
+            {
+                const data = .{ .items = [_][]const u8{ "a", "b" }, .flag = true, .missing = @as(?[]const u8, null) };
+                const expected =
+                    \\- a
+                    \\- b
+                    \\on|not found
+                ;
+
+                try expectRender(template_text, data, expected);
+            }
+
+            {
+                const data = .{ .items = [_][]const u8{}, .flag = false, .missing = @as(?[]const u8, null) };
+                const expected =
+                    \\No items
+                    \\off|not found
+                ;
+
+                try expectRender(template_text, data, expected);
+            }
+        }
+
+        test "Lambda section with else branch" {
+            const Data = struct {
+                pub fn lambda(ctx: LambdaContext) !void {
+                    try ctx.write("expanded");
+                }
+            };
+
+            const template_text = "{{#lambda}}section{{/lambda}}{{^lambda}}else{{/lambda}}";
+            try expectRender(template_text, Data{}, "expanded");
+        }
+
+        test "Indented numbers" {
+            const template_text = "  {{>partial}}\n";
+            const partials = .{.{ "partial", "{{n}}<\n{{n}}&\n" }};
+
+            try expectRenderPartials(template_text, partials, .{ .n = 1 }, "  1<\n  1&\n");
+        }
+
+        test "Write hook" {
+            const Money = struct {
+                cents: u64,
+
+                pub fn mustacheWrite(self: @This(), writer: anytype) !void {
+                    try writer.print("${d}.{d:0>2}", .{ self.cents / 100, self.cents % 100 });
+                }
+            };
+
+            const Tag = struct {
+                name: []const u8,
+
+                pub fn format(self: @This(), comptime fmt: []const u8, options: std.fmt.FormatOptions, writer: anytype) !void {
+                    _ = fmt;
+                    _ = options;
+                    try writer.print("<{s}>", .{self.name});
+                }
+            };
+
+            const template_text = "{{price}} {{tag}} {{{tag}}}";
+            const data = .{ .price = Money{ .cents = 1234 }, .tag = Tag{ .name = "b" } };
+            const expected = "$12.34 &lt;b&gt; <b>";
+
+            // JSON has no equivalent for user types
+            try expectCachedRender(template_text, data, expected);
+            try expectComptimeRender(template_text, data, expected);
+            try expectStreamedRender(template_text, data, expected);
+        }
+
+        test "Format decls that are not hooks" {
+            const Unit = enum {
+                kg,
+                lb,
+
+                pub const format = "short";
+            };
+
+            const Color = enum {
+                red,
+                blue,
+
+                pub fn format(self: @This()) []const u8 {
+                    return @tagName(self);
+                }
+            };
+
+            try testing.expect(!hasWriteHook(Unit));
+            try testing.expect(!hasWriteHook(Color));
+
+            const template_text = "{{unit}} {{color}}";
+            const data = .{ .unit = Unit.kg, .color = Color.blue };
+
+            try expectCachedRender(template_text, data, "kg blue");
+            try expectStreamedRender(template_text, data, "kg blue");
+        }
+
+        test "Stream readers" {
+            const allocator = testing.allocator;
+
+            var template = try expectParseTemplate("{{body}}|{{{raw}}}");
+            defer template.deinit(allocator);
+
+            var body = std.io.fixedBufferStream("<b>bold</b>");
+            var raw = std.io.fixedBufferStream("<i>raw</i>");
+            const data = .{ .body = body.reader(), .raw = raw.reader() };
+
+            const result = try allocRender(allocator, template, data);
+            defer allocator.free(result);
+
+            try testing.expectEqualStrings("&lt;b&gt;bold&lt;/b&gt;|<i>raw</i>", result);
+        }
+
+        test "Stream read errors" {
+            const allocator = testing.allocator;
+
+            const Failing = struct {
+                const Reader = std.io.Reader(*@This(), error{ Broken, InputOutput }, read);
+
+                calls: usize = 0,
+                err: anyerror,
+
+                fn read(self: *@This(), buffer: []u8) error{ Broken, InputOutput }!usize {
+                    self.calls += 1;
+                    if (self.calls > 1) return @errSetCast(error{ Broken, InputOutput }, self.err);
+
+                    std.mem.copy(u8, buffer, "partial");
+                    return "partial".len;
+                }
+
+                fn reader(self: *@This()) Reader {
+                    return .{ .context = self };
+                }
+            };
+
+            var template = try expectParseTemplate("{{body}}");
+            defer template.deinit(allocator);
+
+            // Errors declared by std.fs.File.PReadError are returned as is
+            var io_error = Failing{ .err = error.InputOutput };
+            try testing.expectError(error.InputOutput, allocRender(allocator, template, .{ .body = io_error.reader() }));
+
+            // Any other error is reported as ReadFailed, never as a truncated output
+            var other_error = Failing{ .err = error.Broken };
+            var list = std.ArrayList(u8).init(allocator);
+            defer list.deinit();
+
+            try testing.expectError(error.ReadFailed, render(template, .{ .body = other_error.reader() }, list.writer()));
+            try testing.expectEqualStrings("partial", list.items);
+        }
+
+        test "Stream file ranges" {
+            const allocator = testing.allocator;
+
+            var tmp = testing.tmpDir(.{});
+            defer tmp.cleanup();
+
+            try tmp.dir.writeFile("body.html", "<p>hello</p>");
+
+            var body_file = try tmp.dir.openFile("body.html", .{});
+            defer body_file.close();
+
+            var template = try expectParseTemplate("{{body}}|{{{body}}}|{{{all}}}");
+            defer template.deinit(allocator);
+
+            const data = .{
+                .body = FileRange{ .file = body_file, .offset = 3, .len = 9 },
+                .all = FileRange{ .file = body_file },
+            };
+            const expected = "hello&lt;/p&gt;|hello</p>|<p>hello</p>";
+
+            {
+                const result = try allocRender(allocator, template, data);
+                defer allocator.free(result);
+
+                try testing.expectEqualStrings(expected, result);
+            }
+
+            {
+                // Unescaped ranges are copied from file to file
+                var out_file = try tmp.dir.createFile("out.html", .{ .read = true });
+                defer out_file.close();
+
+                try render(template, data, out_file.writer());
+
+                try out_file.seekTo(0);
+                const result = try out_file.readToEndAlloc(allocator, 1024);
+                defer allocator.free(result);
+
+                try testing.expectEqualStrings(expected, result);
+            }
+        }
+
+        test "SafeHtml" {
+            const template_text = "{{title}}|{{{title}}}|{{&title}}";
+            const data = .{ .title = SafeHtml{ .value = "<b>\"trusted\"</b>" } };
+            const expected = "<b>\"trusted\"</b>|<b>\"trusted\"</b>|<b>\"trusted\"</b>";
+
+            // JSON has no equivalent for SafeHtml
+            try expectCachedRender(template_text, data, expected);
+            try expectComptimeRender(template_text, data, expected);
+            try expectStreamedRender(template_text, data, expected);
+        }
+
         test "Context stack resolution" {
             const Data = struct {
                 name: []const u8 = "root field",
@@ -3944,6 +4794,17 @@ const tests = struct {
             try expectEscape(">ab&cd<", ">ab&cd<", .Unescaped);
         }
 
+        test "Escape elision by type" {
+            try expectEscape("42", @as(u32, 42), .Escaped);
+            try expectEscape("-1.5", @as(f64, -1.5), .Escaped);
+            try expectEscape("false", false, .Escaped);
+            try expectEscape("safe", enum { safe }.safe, .Escaped);
+            try expectEscape("a&lt;b", enum { @"a<b" }.@"a<b", .Escaped);
+
+            try expectEscape("<b>trusted</b>", SafeHtml{ .value = "<b>trusted</b>" }, .Escaped);
+            try expectEscape("<b>trusted</b>", SafeHtml{ .value = "<b>trusted</b>" }, .Unescaped);
+        }
+
         test "Escape and Indentation" {
             var indentation_queue = IndentationQueue{};
 
@@ -3996,7 +4857,7 @@ const tests = struct {
             try expectIndent("a\r\n>>b\r\n>>c", "a\r\nb\r\nc", &indentation_queue);
         }
 
-        fn expectEscape(expected: []const u8, value: []const u8, escape: Escape) !void {
+        fn expectEscape(expected: []const u8, value: anytype, escape: Escape) !void {
             var indentation_queue = IndentationQueue{};
             try expectEscapeAndIndent(expected, value, escape, &indentation_queue);
         }
@@ -4005,7 +4866,7 @@ const tests = struct {
             try expectEscapeAndIndent(expected, value, .Unescaped, indentation_queue);
         }
 
-        fn expectEscapeAndIndent(expected: []const u8, value: []const u8, escape: Escape, indentation_queue: *IndentationQueue) !void {
+        fn expectEscapeAndIndent(expected: []const u8, value: anytype, escape: Escape, indentation_queue: *IndentationQueue) !void {
             const allocator = testing.allocator;
             var list = std.ArrayList(u8).init(allocator);
             defer list.deinit();
@@ -4107,6 +4968,21 @@ const tests = struct {
         defer allocator.free(result);
 
         try testing.expectEqualStrings(expected, result);
+
+        // Lazy render from the raw JSON text
+        var raw_result = try allocRender(allocator, cached_template, mustache.RawJson{ .text = json_text });
+        defer allocator.free(raw_result);
+
+        try testing.expectEqualStrings(expected, raw_result);
+
+        // Compact document built from the parsed tree
+        var document = try mustache.JsonDocument.fromValue(allocator, json.root);
+        defer document.deinit();
+
+        var document_result = try allocRender(allocator, cached_template, &document);
+        defer allocator.free(document_result);
+
+        try testing.expectEqualStrings(expected, document_result);
     }
 
     fn expectComptimeRender(comptime template_text: []const u8, data: anytype, expected: []const u8) anyerror!void {
@@ -4187,6 +5063,21 @@ const tests = struct {
         defer allocator.free(result);
 
         try testing.expectEqualStrings(expected, result);
+
+        // Lazy render from the raw JSON text
+        var raw_result = try allocRenderPartials(allocator, cached_template, hashMap, mustache.RawJson{ .text = json_text });
+        defer allocator.free(raw_result);
+
+        try testing.expectEqualStrings(expected, raw_result);
+
+        // Compact document built from the parsed tree
+        var document = try mustache.JsonDocument.fromValue(allocator, json.root);
+        defer document.deinit();
+
+        var document_result = try allocRenderPartials(allocator, cached_template, hashMap, &document);
+        defer allocator.free(document_result);
+
+        try testing.expectEqualStrings(expected, document_result);
     }
 
     fn expectComptimeRenderPartials(comptime template_text: []const u8, comptime partials: anytype, data: anytype, expected: []const u8) anyerror!void {
@@ -12,6 +12,7 @@ const TemplateLoadMode = mustache.options.TemplateLoadMode;
 const Features = mustache.options.Features;
 
 const parsing = @import("parsing/parsing.zig");
+const Projection = @import("dependencies.zig").Projection;
 
 pub const Delimiters = parsing.Delimiters;
 
@@ -44,7 +45,19 @@ pub const Element = union(Element.Type) {
     parent: Parent,
     block: Block,
 
-    pub const Path = []const []const u8;
+    pub const Path = []const PathPart;
+
+    /// A dotted name part, with its hash computed once at parse time
+    pub const PathPart = struct {
+        name: []const u8,
+
+        /// Same hash used by `std.StringArrayHashMap`, and so by `std.json.ObjectMap`
+        hash: u32,
+
+        pub fn init(name: []const u8) PathPart {
+            return .{ .name = name, .hash = std.array_hash_map.hashString(name) };
+        }
+    };
 
     pub const Type = enum {
         /// Static text
@@ -190,6 +203,11 @@ pub const Element = union(Element.Type) {
         children_count: u32,
         inner_text: ?[]const u8,
         delimiters: ?Delimiters,
+
+        /// Number of elements following the children, rendered when the section evaluates as "false".
+        /// Fused by the parser from an inverted section with the same path,
+        /// as in `{{#items}}...{{/items}}{{^items}}...{{/items}}`
+        else_count: u32 = 0,
     };
 
     pub const InvertedSection = struct {
@@ -250,10 +268,53 @@ pub const Element = union(Element.Type) {
         }
     }
 
+    /// Returns the number of elements nested inside this element
+    pub fn childrenCount(self: Element) u32 {
+        return switch (self) {
+            .section => |section| section.children_count + section.else_count,
+            .inverted_section => |section| section.children_count,
+            .parent => |parent| parent.children_count,
+            .block => |block| block.children_count,
+            else => 0,
+        };
+    }
+
+    /// Returns the number of bytes allocated by this element, not including the element itself
+    pub fn memoryFootprint(self: Element, owns_string: bool) usize {
+        const strings = struct {
+            fn len(owns: bool, value: ?[]const u8) usize {
+                if (!owns) return 0;
+                return if (value) |slice| slice.len else 0;
+            }
+        };
+
+        return switch (self) {
+            .static_text => |content| strings.len(owns_string, content),
+            .interpolation => |path| pathFootprint(owns_string, path),
+            .unescaped_interpolation => |path| pathFootprint(owns_string, path),
+            .section => |section| pathFootprint(owns_string, section.path) + strings.len(owns_string, section.inner_text),
+            .inverted_section => |section| pathFootprint(owns_string, section.path),
+            .partial => |partial| strings.len(owns_string, partial.key) + strings.len(owns_string, partial.indentation),
+            .parent => |parent| strings.len(owns_string, parent.key),
+            .block => |block| strings.len(owns_string, block.key),
+        };
+    }
+
+    fn pathFootprint(owns_string: bool, path: Path) usize {
+        if (path.len == 0) return 0;
+
+        var size = path.len * @sizeOf(PathPart);
+        if (owns_string) {
+            for (path) |part| size += part.name.len;
+        }
+
+        return size;
+    }
+
     pub inline fn destroyPath(allocator: Allocator, owns_string: bool, path: Path) void {
         if (path.len > 0) {
             if (owns_string) {
-                for (path) |part| allocator.free(part);
+                for (path) |part| allocator.free(part.name);
             }
             allocator.free(path);
         }
@@ -270,6 +331,29 @@ pub const Template = struct {
             allocator.free(self.elements);
         }
     }
+
+    /// Returns the number of bytes owned by this template,
+    /// including elements, paths and strings when the template owns them.
+    /// Templates loaded at comptime don't own any memory.
+    pub fn memoryFootprint(self: Template) usize {
+        if (self.options.load_mode != .runtime_loaded) return 0;
+
+        const owns_string = self.options.copyStrings();
+        var size = self.elements.len * @sizeOf(Element);
+        for (self.elements) |element| {
+            size += element.memoryFootprint(owns_string);
+        }
+
+        return size;
+    }
+
+    /// Returns the tree of data paths this template may read, including the partials and parents it includes,
+    /// each node marked with the tags reading it.
+    /// `partials` can be a tuple, an array, slice or a HashMap containing the partial's name as key and the `Template` as value.
+    /// Call `deinit` on the result to free it.
+    pub fn dependencies(self: Template, allocator: Allocator, partials: anytype) Allocator.Error!Projection {
+        return try Projection.init(allocator, self, partials);
+    }
 };
 
 /// Parses a string and returns an union containing either a `ParseError` or a `Template`
@@ -524,7 +608,8 @@ const tests = struct {
 
         try testing.expectEqual(expected_path.len, path.len);
         for (expected_path) |expected_part, i| {
-            try testing.expectEqualStrings(expected_part, path[i]);
+            try testing.expectEqualStrings(expected_part.name, path[i].name);
+            try testing.expectEqual(std.array_hash_map.hashString(path[i].name), path[i].hash);
         }
     }
 
@@ -542,13 +627,22 @@ const tests = struct {
 
                     const elements = template.result.elements;
 
-                    try testing.expectEqual(@as(usize, 2), elements.len);
+                    if (load_mode == .comptime_loaded) {
+
+                        // Comptime strings around the comment are merged into a single text
+                        try testing.expectEqual(@as(usize, 1), elements.len);
 
-                    try testing.expectEqual(Element.Type.static_text, elements[0]);
-                    try testing.expectEqualStrings("12345", elements[0].static_text);
+                        try testing.expectEqual(Element.Type.static_text, elements[0]);
+                        try testing.expectEqualStrings("1234567890", elements[0].static_text);
+                    } else {
+                        try testing.expectEqual(@as(usize, 2), elements.len);
 
-                    try testing.expectEqual(Element.Type.static_text, elements[1]);
-                    try testing.expectEqualStrings("67890", elements[1].static_text);
+                        try testing.expectEqual(Element.Type.static_text, elements[0]);
+                        try testing.expectEqualStrings("12345", elements[0].static_text);
+
+                        try testing.expectEqual(Element.Type.static_text, elements[1]);
+                        try testing.expectEqualStrings("67890", elements[1].static_text);
+                    }
                 }
             }.action;
 
@@ -2433,18 +2527,74 @@ const tests = struct {
                     try testing.expectEqual(@as(usize, 2), template.elements.len);
                     try testing.expectEqual(Element.Type.interpolation, template.elements[0]);
                     try testing.expectEqual(Element.Type.static_text, template.elements[1]);
-                    try testing.expectEqualStrings("hello", template.elements[0].interpolation[0]);
+                    try testing.expectEqualStrings("hello", template.elements[0].interpolation[0].name);
                     try testing.expectEqualStrings("world", template.elements[1].static_text);
                 },
             }
         }
 
+        test "memoryFootprint" {
+            const template_text = "{{a.b}}world";
+
+            const owned = (try parseText(testing.allocator, template_text, .{}, .{ .copy_strings = true })).success;
+            defer owned.deinit(testing.allocator);
+
+            // Elements, one path with two parts, and the strings "a", "b" and "world"
+            const elements_size = 2 * @sizeOf(Element);
+            const path_size = 2 * @sizeOf(Element.PathPart);
+            try testing.expectEqual(@as(usize, elements_size + path_size + 1 + 1 + 5), owned.memoryFootprint());
+
+            const borrowed = (try parseText(testing.allocator, template_text, .{}, .{ .copy_strings = false })).success;
+            defer borrowed.deinit(testing.allocator);
+            try testing.expectEqual(@as(usize, elements_size + path_size), borrowed.memoryFootprint());
+
+            const comptime_template = comptime parseComptime(template_text, .{}, .{});
+            try testing.expectEqual(@as(usize, 0), comptime_template.memoryFootprint());
+        }
+
+        test "Merge static texts" {
+            const template_text =
+                \\Begin.
+                \\{{! Comment Block! }}
+                \\Middle.
+                \\{{=<% %>=}}
+                \\<%! Another comment %>
+                \\End. <%name%>
+            ;
+
+            const owned = (try parseText(testing.allocator, template_text, .{}, .{ .copy_strings = true })).success;
+            defer owned.deinit(testing.allocator);
+
+            try testing.expectEqual(@as(usize, 2), owned.elements.len);
+            try testing.expectEqualStrings("Begin.\nMiddle.\nEnd. ", owned.elements[0].static_text);
+            try testing.expectEqual(Element.Type.interpolation, owned.elements[1]);
+
+            const comptime_template = comptime parseComptime(template_text, .{}, .{});
+            try testing.expectEqual(@as(usize, 2), comptime_template.elements.len);
+            try testing.expectEqualStrings("Begin.\nMiddle.\nEnd. ", comptime_template.elements[0].static_text);
+
+            // A cached template borrowing its text can't own the merged text
+            const borrowed = (try parseText(testing.allocator, template_text, .{}, .{ .copy_strings = false })).success;
+            defer borrowed.deinit(testing.allocator);
+
+            try testing.expectEqual(@as(usize, 4), borrowed.elements.len);
+
+            const result = try mustache.allocRender(testing.allocator, owned, .{ .name = "world" });
+            defer testing.allocator.free(result);
+            try testing.expectEqualStrings("Begin.\nMiddle.\nEnd. world", result);
+
+            // Merged while rendering straight from the text
+            const streamed = try mustache.allocRenderText(testing.allocator, template_text, .{ .name = "world" });
+            defer testing.allocator.free(streamed);
+            try testing.expectEqualStrings("Begin.\nMiddle.\nEnd. world", streamed);
+        }
+
         test "parseComptime API" {
             const template = mustache.parseComptime("{{hello}}world", .{}, .{});
             try testing.expectEqual(@as(usize, 2), template.elements.len);
             try testing.expectEqual(Element.Type.interpolation, template.elements[0]);
             try testing.expectEqual(Element.Type.static_text, template.elements[1]);
-            try testing.expectEqualStrings("hello", template.elements[0].interpolation[0]);
+            try testing.expectEqualStrings("hello", template.elements[0].interpolation[0].name);
             try testing.expectEqualStrings("world", template.elements[1].static_text);
         }
 
@@ -2472,7 +2622,7 @@ const tests = struct {
                     try testing.expectEqual(@as(usize, 2), template.elements.len);
                     try testing.expectEqual(Element.Type.interpolation, template.elements[0]);
                     try testing.expectEqual(Element.Type.static_text, template.elements[1]);
-                    try testing.expectEqualStrings("hello", template.elements[0].interpolation[0]);
+                    try testing.expectEqualStrings("hello", template.elements[0].interpolation[0].name);
                     try testing.expectEqualStrings("world", template.elements[1].static_text);
                 },
             }